@@ -23,11 +23,13 @@ namespace fs = std::experimental::filesystem;
 namespace fs = std::filesystem;
 #endif
 #include <fstream>
+#include <iostream>
 #include <thread>
 #include "CRSDK/CrDeviceProperty.h"
 #include "Text.h"
 #include "OpenCVWrapper.h"
 #include "CrDebugString.h"
+#include "Logger.h"
 
 #if defined(__APPLE__) || defined(__linux__)
 #include <sys/stat.h>
@@ -46,9 +48,6 @@ namespace fs = std::filesystem;
 #include <conio.h>
 #endif
 
-#include "FFmpegStreamer.h"
-#include "MjpegHttpServer.h"
-
 // Enumerator
 enum Password_Key {
 
@@ -84,9 +83,6 @@ using namespace std::chrono_literals;
 
 constexpr int const ImageSaveAutoStartNo = -1;
 
-FFmpegStreamer server;
-MjpegHttpServer serverLocal;
-
 namespace cli
 {
 CameraDevice::CameraDevice(std::int32_t no, SCRSDK::ICrCameraObjectInfo const* camera_info)
@@ -142,27 +138,6 @@ void CameraDevice::setCompeletedCallback(std::function<void (std::string)>* cb)
     this->onCaptureCompleted = cb;
 }
 
-bool CameraDevice::enable_live_view(bool enable, bool isLocal, std::string& rtmpUrl) {
-    bool ret = false;
-    if (enable) {
-        tout << "启动推流\n";   
-        if (isLocal) {
-            ret = serverLocal.start(9091);
-        } else {
-            ret = server.startRtmpStream(rtmpUrl, 25, 2000);
-        }
-    } else {
-        ret = true;
-        tout << "停止推流\n";   
-        if (isLocal) {
-            serverLocal.stop();
-        } else {
-            server.stop();
-        }
-    }
-    return ret;
-}
-
 bool CameraDevice::getfingerprint()
 {
     CrInt32u fpLen = 0;
@@ -262,11 +237,12 @@ bool CameraDevice::connect(SCRSDK::CrSdkControlMode openMode, SCRSDK::CrReconnec
     }
 
     m_spontaneous_disconnection = false;
-    tout << "inputId=" << inputId << ", m_userPassword=" << m_userPassword << ", m_fingerprint=" << m_fingerprint << "\n";
+    LOG_INFO("Connect " << m_info->GetModel() << ", user " << inputId << (m_userPassword.empty() ? "" : ", with SSH password")
+        << (m_fingerprint.empty() ? "" : ", with fingerprint"));
     auto connect_status = SDK::Connect(m_info, this, &m_device_handle, openMode, reconnect, inputId, m_userPassword.c_str(), m_fingerprint.c_str(), (CrInt32u)m_fingerprint.size());
     if (CR_FAILED(connect_status)) {
         text id(this->get_id());
-        tout << std::endl << "Failed to connect: 0x" << std::hex << connect_status << std::dec << ". " << m_info->GetModel() << " (" << id.data() << ")\n";
+        LOG_ERROR("Failed to connect: 0x" << std::hex << connect_status << std::dec << ". " << m_info->GetModel() << " (" << id.data() << ")");
         m_userPassword.clear();
         return false;
     }
@@ -279,10 +255,10 @@ bool CameraDevice::disconnect()
     // m_fingerprint.clear();  // Use as needed
     // m_userPassword.clear(); // Use as needed
     m_spontaneous_disconnection = true;
-    tout << "Disconnect from camera...\n";
+    LOG_INFO("Disconnect from camera...");
     auto disconnect_status = SDK::Disconnect(m_device_handle);
     if (CR_FAILED(disconnect_status)) {
-        tout << "Disconnect failed to initialize.\n";
+        LOG_WARN("Disconnect failed to initialize.");
         return false;
     }
     return true;
@@ -290,11 +266,11 @@ bool CameraDevice::disconnect()
 
 bool CameraDevice::release()
 {
-    tout << "Release camera...\n";
+    LOG_INFO("Release camera...");
     auto finalize_status = SDK::ReleaseDevice(m_device_handle);
     m_device_handle = 0; // clear
     if (CR_FAILED(finalize_status)) {
-        tout << "Finalize device failed to initialize.\n";
+        LOG_WARN("Finalize device failed to initialize.");
         return false;
     }
     return true;
@@ -315,13 +291,13 @@ SCRSDK::CrSdkControlMode CameraDevice::get_sdkmode()
 
 void CameraDevice::capture_image() const
 {
-    tout << "Capture image...\n";
-    tout << "Shutter down\n";
+    LOG_INFO("Capture image...");
+    LOG_DEBUG("Shutter down");
     SDK::SendCommand(m_device_handle, SDK::CrCommandId::CrCommandId_Release, SDK::CrCommandParam_Down);
 
     // Wait, then send shutter up
     std::this_thread::sleep_for(35ms);
-    tout << "Shutter up\n";
+    LOG_DEBUG("Shutter up");
     SDK::SendCommand(m_device_handle, SDK::CrCommandId::CrCommandId_Release, SDK::CrCommandParam_Up);
 }
 
@@ -335,8 +311,8 @@ void CameraDevice::s1_shooting() const
     //     return;
     // }
 
-    tout << "S1 shooting...\n";
-    tout << "Shutter Half Press down\n";
+    LOG_INFO("S1 shooting...");
+    LOG_DEBUG("Shutter Half Press down");
     SDK::CrDeviceProperty prop;
     prop.SetCode(SDK::CrDevicePropertyCode::CrDeviceProperty_S1);
     prop.SetCurrentValue(SDK::CrLockIndicator::CrLockIndicator_Locked);
@@ -345,7 +321,7 @@ void CameraDevice::s1_shooting() const
 
     // Wait, then send shutter up
     std::this_thread::sleep_for(1s);
-    tout << "Shutter Half Press up\n";
+    LOG_DEBUG("Shutter Half Press up");
     prop.SetCurrentValue(SDK::CrLockIndicator::CrLockIndicator_Unlocked);
     SDK::SetDeviceProperty(m_device_handle, &prop);
 }
@@ -360,8 +336,8 @@ void CameraDevice::af_shutter() const
     //     return;
     // }
 
-    tout << "S1 shooting...\n";
-    tout << "Shutter Half Press down\n";
+    LOG_INFO("S1 shooting...");
+    LOG_DEBUG("Shutter Half Press down");
     SDK::CrDeviceProperty prop;
     prop.SetCode(SDK::CrDevicePropertyCode::CrDeviceProperty_S1);
     prop.SetCurrentValue(SDK::CrLockIndicator::CrLockIndicator_Locked);
@@ -370,17 +346,17 @@ void CameraDevice::af_shutter() const
 
     // Wait, then send shutter down
     std::this_thread::sleep_for(500ms);
-    tout << "Shutter down\n";
+    LOG_DEBUG("Shutter down");
     SDK::SendCommand(m_device_handle, SDK::CrCommandId::CrCommandId_Release, SDK::CrCommandParam::CrCommandParam_Down);
 
     // Wait, then send shutter up
     std::this_thread::sleep_for(35ms);
-    tout << "Shutter up\n";
+    LOG_DEBUG("Shutter up");
     SDK::SendCommand(m_device_handle, SDK::CrCommandId::CrCommandId_Release, SDK::CrCommandParam::CrCommandParam_Up);
 
     // Wait, then send shutter up
     std::this_thread::sleep_for(1s);
-    tout << "Shutter Half Press up\n";
+    LOG_DEBUG("Shutter Half Press up");
     prop.SetCurrentValue(SDK::CrLockIndicator::CrLockIndicator_Unlocked);
     SDK::SetDeviceProperty(m_device_handle, &prop);
 }
@@ -388,7 +364,7 @@ void CameraDevice::af_shutter() const
 void CameraDevice::continuous_shooting()
 {
     load_properties();
-    tout << "Continuous Shooting\n";
+    LOG_INFO("Continuous Shooting");
     if (1 == m_prop.position_key_setting.writable) {
         // Set, PriorityKeySettings property
         SDK::CrDeviceProperty priority;
@@ -397,7 +373,7 @@ void CameraDevice::continuous_shooting()
         priority.SetValueType(SDK::CrDataType::CrDataType_UInt32Array);
         auto err_priority = SDK::SetDeviceProperty(m_device_handle, &priority);
         if (CR_FAILED(err_priority)) {
-            tout << "Priority Key setting FAILED\n";
+            LOG_WARN("Priority Key setting FAILED");
             return;
         }
         std::this_thread::sleep_for(500ms);
@@ -407,7 +383,7 @@ void CameraDevice::continuous_shooting()
     // Set, still_capture_mode property
     SDK::CrDeviceProperty mode;
     if (-1 == m_prop.still_capture_mode.writable) {
-        tout << "Still Capture Mode setting is not supported.\n";
+        LOG_WARN("Still Capture Mode setting is not supported.");
         return;
     }
     auto& values = m_prop.still_capture_mode.possible;
@@ -422,13 +398,13 @@ void CameraDevice::continuous_shooting()
         mode.SetCurrentValue(SDK::CrDriveMode::CrDrive_Continuous);
     }
     else {
-        tout << "Continuous Shot is not supported.\n";
+        LOG_WARN("Continuous Shot is not supported.");
         return;
     }
     mode.SetValueType(SDK::CrDataType::CrDataType_UInt32Array);
     auto err_still_capture_mode = SDK::SetDeviceProperty(m_device_handle, &mode);
     if (CR_FAILED(err_still_capture_mode)) {
-        tout << "Still Capture Mode setting FAILED\n";
+        LOG_WARN("Still Capture Mode setting FAILED");
         return;
     }
 
@@ -439,419 +415,277 @@ void CameraDevice::continuous_shooting()
     if ((m_prop.still_capture_mode.current == SDK::CrDriveMode::CrDrive_Continuous_Hi_Plus) ||
         (m_prop.still_capture_mode.current == SDK::CrDriveMode::CrDrive_Continuous_Hi)||
         (m_prop.still_capture_mode.current == SDK::CrDriveMode::CrDrive_Continuous)){
-        tout << "Still Capture Mode setting SUCCESS\n";
-        tout << "Capture image...\n";
-        tout << "Shutter down\n";
+        LOG_INFO("Still Capture Mode setting SUCCESS");
+        LOG_INFO("Capture image...");
+        LOG_DEBUG("Shutter down");
         SDK::SendCommand(m_device_handle, SDK::CrCommandId::CrCommandId_Release, SDK::CrCommandParam::CrCommandParam_Down);
 
         // Wait, then send shutter up
         std::this_thread::sleep_for(500ms);
-        tout << "Shutter up\n";
+        LOG_DEBUG("Shutter up");
         SDK::SendCommand(m_device_handle, SDK::CrCommandId::CrCommandId_Release, SDK::CrCommandParam::CrCommandParam_Up);
     }
     else {
-        tout << "Still Capture Mode setting FAILED\n";
+        LOG_WARN("Still Capture Mode setting FAILED");
     }
 }
 
 void CameraDevice::get_aperture()
 {
     load_properties();
-    tout << format_f_number(m_prop.f_number.current) << '\n';
+    LOG_INFO(format_f_number(m_prop.f_number.current));
 }
 
 void CameraDevice::get_iso()
 {
     load_properties();
 
-    tout << "ISO: " << format_iso_sensitivity(m_prop.iso_sensitivity.current) << '\n';
+    LOG_INFO("ISO: " << format_iso_sensitivity(m_prop.iso_sensitivity.current));
 }
 
 void CameraDevice::get_shutter_speed()
 {
     load_properties();
-    tout << "Shutter Speed: " << format_shutter_speed(m_prop.shutter_speed.current) << '\n';
+    LOG_INFO("Shutter Speed: " << format_shutter_speed(m_prop.shutter_speed.current));
 }
 
 bool CameraDevice::get_extended_shutter_speed()
 {
     load_properties();
     if (-1 == m_prop.extended_shutter_speed.writable) {
-        tout << "Extended Shutter Speed is not supported.\n";
+        LOG_WARN("Extended Shutter Speed is not supported.");
         return false;
     }
-    tout << "Extended Shutter Speed: " << format_extended_shutter_speed(m_prop.extended_shutter_speed.current) << '\n';
+    LOG_INFO("Extended Shutter Speed: " << format_extended_shutter_speed(m_prop.extended_shutter_speed.current));
     return true;
 }
 
 void CameraDevice::get_position_key_setting()
 {
     load_properties();
-    tout << "Position Key Setting: " << format_position_key_setting(m_prop.position_key_setting.current) << '\n';
+    LOG_INFO("Position Key Setting: " << format_position_key_setting(m_prop.position_key_setting.current));
 }
 
 void CameraDevice::get_exposure_program_mode()
 {
     load_properties();
-    tout << "Exposure Program Mode: " << format_exposure_program_mode(m_prop.exposure_program_mode.current) << '\n';
+    LOG_INFO("Exposure Program Mode: " << format_exposure_program_mode(m_prop.exposure_program_mode.current));
 }
 
 void CameraDevice::get_still_capture_mode()
 {
     load_properties();
-    tout << "Still Capture Mode: " << format_still_capture_mode(m_prop.still_capture_mode.current) << '\n';
+    LOG_INFO("Still Capture Mode: " << format_still_capture_mode(m_prop.still_capture_mode.current));
 }
 
 void CameraDevice::get_focus_mode()
 {
     load_properties();
-    tout << "Focus Mode: " << format_focus_mode(m_prop.focus_mode.current) << '\n';
+    LOG_INFO("Focus Mode: " << format_focus_mode(m_prop.focus_mode.current));
 }
 
 void CameraDevice::get_focus_area()
 {
     load_properties();
-    tout << "Focus Area: " << format_focus_area(m_prop.focus_area.current) << '\n';
+    LOG_INFO("Focus Area: " << format_focus_area(m_prop.focus_area.current));
 }
 
-void CameraDevice::get_live_view_only(bool isLocal)
+void CameraDevice::get_live_view_only()
 {
-    tout << "GetLiveView...\n";
-
-    CrInt32 num = 0;
-    SDK::CrLiveViewProperty* property = nullptr;
-    auto err = SDK::GetLiveViewProperties(m_device_handle, &property, &num);
-    if (CR_FAILED(err)) {
-        tout << "GetLiveView FAILED\n";
+    // 菜单只验证取帧是否正常，帧不落盘，分发由预览流水线负责
+    FramePtr frame;
+    if (CR_FAILED(fetch_live_view_frame(frame))) {
         return;
     }
-    SDK::ReleaseLiveViewProperties(m_device_handle, property);
+    LOG_DEBUG("GetLiveView SUCCESS frame " << frame->frameNo << ", " << frame->size << " bytes");
+}
 
+SDK::CrError CameraDevice::refresh_live_view_info()
+{
     SDK::CrImageInfo inf;
-    err = SDK::GetLiveViewImageInfo(m_device_handle, &inf);
+    auto err = SDK::GetLiveViewImageInfo(m_device_handle, &inf);
     if (CR_FAILED(err)) {
-        tout << "GetLiveView FAILED\n";
-        return;
+        LOG_EVERY_MS(LogLevel::Warn, 5000, "GetLiveView FAILED GetLiveViewImageInfo 0x" << std::hex << err);
+        return err;
     }
-
     CrInt32u bufSize = inf.GetBufferSize();
     if (bufSize < 1)
     {
-        tout << "GetLiveView FAILED \n";
-        return;
+        LOG_EVERY_MS(LogLevel::Warn, 5000, "GetLiveView FAILED buffer size=0");
+        return SDK::CrError_Generic;
     }
+    m_lvInfo.setBufferSize(bufSize);
+    LOG_DEBUG("LiveView buffer size " << bufSize);
 
-    SDK::CrImageDataBlock* image_data = nullptr;
-    CrInt8u* image_buff = nullptr;
-
-    image_data = new SDK::CrImageDataBlock();
-    if (!image_data)
-    {
-        // FAILED
-        tout << "GetLiveView FAILED (new CrImageDataBlock class)\n";
-        return;
+    // 首次取帧时拉一次全量框信息，之后由 OnLvPropertyChangedCodes 增量更新
+    if (!m_lvInfo.hasFrameInfo()) {
+        CrInt32 num = 0;
+        SDK::CrLiveViewProperty* property = nullptr;
+        if (CR_SUCCEEDED(SDK::GetLiveViewProperties(m_device_handle, &property, &num)) && property) {
+            m_lvInfo.update(property, num);
+            SDK::ReleaseLiveViewProperties(m_device_handle, property);
+        }
     }
-    image_buff = new CrInt8u[bufSize];
-    if (!image_buff)
-    {
-        // FAILED
-        tout << "GetLiveView FAILED (new Image buffer)\n";
-        delete image_data; // Release
-        return;
+    return SDK::CrError_None;
+}
+
+SDK::CrError CameraDevice::fetch_live_view_frame(FramePtr& out)
+{
+    LOG_TRACE("GetLiveView...");
+
+    // 缓冲区大小来自缓存，只在失效时重新向相机查询
+    CrInt32u bufSize = m_lvInfo.bufferSize();
+    if (bufSize < 1) {
+        auto err = refresh_live_view_info();
+        if (CR_FAILED(err)) return err;
+        bufSize = m_lvInfo.bufferSize();
     }
-    image_data->SetSize(bufSize);
-    image_data->SetData(image_buff);
+
+    // 从缓冲池取帧，最后一个持有者释放后自动归还
+    FramePtr frame = m_lvFramePool.acquire(bufSize);
+    SDK::CrImageDataBlock image_data;
+    image_data.SetSize(bufSize);
+    image_data.SetData(frame->raw());
 
     // Get the LiveViewImage
-    err = SDK::GetLiveViewImage(m_device_handle, image_data);
+    frame->fetchStart = std::chrono::steady_clock::now();
+    auto err = SDK::GetLiveViewImage(m_device_handle, &image_data);
+    frame->timestamp = std::chrono::steady_clock::now();
     if (CR_FAILED(err))
     {
         // FAILED
         if (err == SDK::CrWarning_Frame_NotUpdated) {
-            tout << "Warning. GetLiveView Frame NotUpdate\n";
+            LOG_EVERY_MS(LogLevel::Debug, 5000, "Warning. GetLiveView Frame NotUpdate");
         }
         else if (err == SDK::CrError_Memory_Insufficient) {
-            tout << "Warning. GetLiveView Memory insufficient\n";
+            // 缓存的缓冲区大小已不够用（画质/尺寸变化未收到通知），下一帧重新获取
+            m_lvInfo.invalidateBufferSize();
+            LOG_EVERY_MS(LogLevel::Warn, 5000, "Warning. GetLiveView Memory insufficient");
         }
-        delete[] image_buff; // Release
-        delete image_data; // Release
-        return;
-    }
-
-    if (0 == image_data->GetSize()) {
-        // FAILED
-        tout << "GetLiveView FAILED Image size=0\n";
-        delete[] image_buff; // Release
-        delete image_data; // Release
-        return;
+        else {
+            LOG_EVERY_MS(LogLevel::Warn, 5000, "GetLiveView FAILED 0x" << std::hex << err);
+        }
+        return err;
     }
 
-    // Display
-    // etc.
-#if defined(__APPLE__)
-    char path[MAC_MAX_PATH]; /*MAX_PATH*/
-    memset(path, 0, sizeof(path));
-    if (NULL == getcwd(path, sizeof(path) - 1)) {
+    if (0 == image_data.GetSize()) {
         // FAILED
-        delete[] image_buff; // Release
-        delete image_data; // Release
-        tout << "Folder path is too long.\n";
-        return;
-    }
-    char filename[] = "/LiveView000000.JPG";
-    if (strlen(path) + strlen(filename) > MAC_MAX_PATH) {
-        // FAILED
-        delete[] image_buff; // Release
-        delete image_data; // Release
-        tout << "Failed to create save path.\n";
-        return;
+        LOG_EVERY_MS(LogLevel::Warn, 5000, "GetLiveView FAILED Image size=0");
+        return SDK::CrError_Generic;
     }
-    strncat(path, filename, strlen(filename));
-#else
-    auto path = fs::current_path();
-    std::string pic_name("Live" + std::to_string(image_data->GetFrameNo()) + ".JPG");
-    path.append(TEXT(pic_name));
-#endif
-    tout << path << '\n';
+    frame->offset = static_cast<uint32_t>(image_data.GetImageData() - frame->raw());
+    frame->size = image_data.GetImageSize();
+    frame->frameNo = image_data.GetFrameNo();
 
-    // std::ofstream file(path, std::ios::out | std::ios::binary);
-    // if (!file.bad())
-    // {
-    //     file.write((char*)image_data->GetImageData(), image_data->GetImageSize());
-    //     file.close();
-    // }
-    if (isLocal) {
-        serverLocal.pushFrame((char*)image_data->GetImageData(), image_data->GetImageSize());
-    } else {
-        server.pushFrame((char*)image_data->GetImageData(), image_data->GetImageSize());
-    }
-    tout << "GetLiveView SUCCESS: isLocal=" << isLocal << "\n";
-    delete[] image_buff; // Release
-    delete image_data; // Release
+    out = frame;
+    return SDK::CrError_None;
 }
 
 void CameraDevice::get_live_view_and_OSD()
 {
-    tout << "GetLiveView...\n";
+    LOG_DEBUG("GetLiveView...");
 
     CrInt32u isLVEnb = 0;
     SDK::GetDeviceSetting(m_device_handle, SDK::Setting_Key_EnableLiveView, &isLVEnb);
 
     SDK::CrError err = SDK::CrError_None;
-    SDK::CrImageDataBlock* liveview_image_data = nullptr;
-    CrInt8u* liveview_image_buff = nullptr;
+    SDK::CrImageDataBlock liveview_image_data;
+    FramePtr liveview_frame;
 
     if (isLVEnb == 0) {
 
     }else{
         do {
-            CrInt32 num = 0;
-            SDK::CrLiveViewProperty* property = nullptr;
-            err = SDK::GetLiveViewProperties(m_device_handle, &property, &num);
-            if (CR_FAILED(err)) {
-                tout << "GetLiveView FAILED\n";
-                break;
-            }
-            SDK::ReleaseLiveViewProperties(m_device_handle, property);
-
-            SDK::CrImageInfo inf;
-            err = SDK::GetLiveViewImageInfo(m_device_handle, &inf);
-            if (CR_FAILED(err)) {
-                tout << "GetLiveView FAILED\n";
-                break;
-            }
-
-            CrInt32u bufSize = inf.GetBufferSize();
-            if (bufSize < 1)
-            {
-                tout << "GetLiveView FAILED \n";
-                break;
+            CrInt32u bufSize = m_lvInfo.bufferSize();
+            if (bufSize < 1) {
+                err = refresh_live_view_info();
+                if (CR_FAILED(err)) {
+                    LOG_EVERY_MS(LogLevel::Warn, 5000, "GetLiveView FAILED");
+                    break;
+                }
+                bufSize = m_lvInfo.bufferSize();
             }
 
-            liveview_image_data = new SDK::CrImageDataBlock();
-            if (!liveview_image_data)
-            {
-                // FAILED
-                tout << "GetLiveView FAILED (new CrImageDataBlock class)\n";
-                break;
-            }
-            liveview_image_buff = new CrInt8u[bufSize];
-            if (!liveview_image_buff)
-            {
-                // FAILED
-                tout << "GetLiveView FAILED (new Image buffer)\n";
-                delete liveview_image_data; // Release
-                liveview_image_data = nullptr;
-                break;
-            }
-            liveview_image_data->SetSize(bufSize);
-            liveview_image_data->SetData(liveview_image_buff);
+            FramePtr frame = m_lvFramePool.acquire(bufSize);
+            liveview_image_data.SetSize(bufSize);
+            liveview_image_data.SetData(frame->raw());
 
             // Get the LiveViewImage
-            err = SDK::GetLiveViewImage(m_device_handle, liveview_image_data);
+            err = SDK::GetLiveViewImage(m_device_handle, &liveview_image_data);
             if (CR_FAILED(err))
             {
                 // FAILED
                 if (err == SDK::CrWarning_Frame_NotUpdated) {
-                    tout << "Warning. GetLiveView Frame NotUpdate\n";
+                    LOG_EVERY_MS(LogLevel::Debug, 5000, "Warning. GetLiveView Frame NotUpdate");
                 }
                 else if (err == SDK::CrError_Memory_Insufficient) {
-                    tout << "Warning. GetLiveView Memory insufficient\n";
+                    m_lvInfo.invalidateBufferSize();
+                    LOG_EVERY_MS(LogLevel::Warn, 5000, "Warning. GetLiveView Memory insufficient");
                 }
-                delete[] liveview_image_buff; // Release
-                liveview_image_buff = nullptr;
-                delete liveview_image_data; // Release
-                liveview_image_data = nullptr;
                 break;
             }
 
-            if (0 == liveview_image_data->GetSize()) {
+            if (0 == liveview_image_data.GetSize()) {
                 // FAILED
-                tout << "GetLiveView FAILED Image size=0\n";
-                delete[] liveview_image_buff; // Release
-                liveview_image_buff = nullptr;
-                delete liveview_image_data; // Release
-                liveview_image_data = nullptr;
+                LOG_EVERY_MS(LogLevel::Warn, 5000, "GetLiveView FAILED Image size=0");
                 break;
             }
+            frame->offset = static_cast<uint32_t>(liveview_image_data.GetImageData() - frame->raw());
+            frame->size = liveview_image_data.GetImageSize();
+            frame->frameNo = liveview_image_data.GetFrameNo();
+            liveview_frame = frame;
 
         } while (0);
     }
 
-    SDK::CrOSDImageDataBlock* osd_image_data = nullptr;
-    CrInt8u* osd_image_buff = nullptr;
-    unsigned char* image_buff = nullptr;
-
-    osd_image_data = new SDK::CrOSDImageDataBlock();
-    if (!osd_image_data)
-    {
-        // FAILED
-        tout << "GetLiveView FAILED (new CrOSDImageDataBlock class)\n";
-        if (liveview_image_buff) {
-            delete[] liveview_image_buff; // Release
-            liveview_image_buff = nullptr;
-        }
-        if (liveview_image_data) {
-            delete liveview_image_data; // Release
-            liveview_image_data = nullptr;
-        }
-        return;
-    }
-
-    osd_image_buff = new CrInt8u[CR_OSD_IMAGE_MAX_SIZE];
-    if (!osd_image_buff)
-    {
-        // FAILED
-        tout << "GetLiveView FAILED (new Image buffer)\n";
-        if (liveview_image_buff) {
-            delete[] liveview_image_buff; // Release
-            liveview_image_buff = nullptr;
-        }
-        if (liveview_image_data) {
-            delete liveview_image_data; // Release
-            liveview_image_data = nullptr;
-        }
-        delete osd_image_data; // Release
-        osd_image_data = nullptr;
-        return;
-    }
-    osd_image_data->SetData(osd_image_buff);
+    // OSD图像和合成图像都使用 CR_OSD_IMAGE_MAX_SIZE 大小的池化缓冲
+    SDK::CrOSDImageDataBlock osd_image_data;
+    FramePtr osd_frame = m_osdFramePool.acquire(CR_OSD_IMAGE_MAX_SIZE);
+    osd_image_data.SetData(osd_frame->raw());
 
     // Get the OSDImage
-    err = SDK::GetOSDImage(m_device_handle, osd_image_data);
+    err = SDK::GetOSDImage(m_device_handle, &osd_image_data);
     if (CR_FAILED(err))
     {
         // FAILED
         if (err == SDK::CrWarning_Frame_NotUpdated) {
-            tout << "Warning. GetLiveView Frame NotUpdate GetOSDImage\n";
+            LOG_EVERY_MS(LogLevel::Debug, 5000, "Warning. GetLiveView Frame NotUpdate GetOSDImage");
         }
         else {
-            tout << "Error GetLiveView FAILED GetOSDImage\n";
-        }
-
-        if (liveview_image_buff) {
-            delete[] liveview_image_buff; // Release
-            liveview_image_buff = nullptr;
+            LOG_EVERY_MS(LogLevel::Warn, 5000, "Error GetLiveView FAILED GetOSDImage");
         }
-        if (liveview_image_data) {
-            delete liveview_image_data; // Release
-            liveview_image_data = nullptr;
-        }
-        delete[] osd_image_buff; //Release
-        osd_image_buff = nullptr;
-        delete osd_image_data; // Release
-        osd_image_data = nullptr;
         return;
     }
 
-    if (0 == osd_image_data->GetImageSize()) {
+    if (0 == osd_image_data.GetImageSize()) {
         // FAILED
-        tout << "GetLiveView FAILED OSDImage size=0\n";
-        if (liveview_image_buff) {
-            delete[] liveview_image_buff; // Release
-            liveview_image_buff = nullptr;
-        }
-        if (liveview_image_data) {
-            delete liveview_image_data; // Release
-            liveview_image_data = nullptr;
-        }
-        delete[] osd_image_buff; //Release
-        osd_image_buff = nullptr;
-        delete osd_image_data; // Release
-        osd_image_data = nullptr;
+        LOG_EVERY_MS(LogLevel::Warn, 5000, "GetLiveView FAILED OSDImage size=0");
         return;
     }
 
     std::vector<uchar> lvbuf;
-    CrInt32u lvsize = 0;
-    if (isLVEnb==0) {
-        const SDK::CrOSDImageMetaInfo& metainfo = osd_image_data->GetMetaInfo();
+    if (isLVEnb==0 || !liveview_frame) {
+        const SDK::CrOSDImageMetaInfo& metainfo = osd_image_data.GetMetaInfo();
         OpenCVWrapper::CreateFillImage(metainfo.lvWidth,metainfo.lvHeight, 0, 0, 0, &lvbuf);
     }
     else {
-        lvbuf.assign(liveview_image_data->GetImageData(), liveview_image_data->GetImageData() + liveview_image_data->GetImageSize());
+        const uchar* lvdata = reinterpret_cast<const uchar*>(liveview_frame->data());
+        lvbuf.assign(lvdata, lvdata + liveview_frame->size);
     }
 
     // Create Image for Composite LiveviewImage and OSDImage
-    image_buff = new unsigned char[CR_OSD_IMAGE_MAX_SIZE];
-    if (!image_buff) {
-        // FAILED
-        tout << "GetLiveView FAILED (new CrImageDataBlock class)\n";
-        if (liveview_image_buff) {
-            delete[] liveview_image_buff; // Release
-            liveview_image_buff = nullptr;
-        }
-        if (liveview_image_data) {
-            delete liveview_image_data; // Release
-            liveview_image_data = nullptr;
-        }
-        delete[] osd_image_buff; //Release
-        osd_image_buff = nullptr;
-        delete osd_image_data; // Release
-        osd_image_data = nullptr;
-        return;
-    }
+    FramePtr composite_frame = m_osdFramePool.acquire(CR_OSD_IMAGE_MAX_SIZE);
 
     // Composite LiveviewImage and OSDImage
     CrInt32u image_size = 0;
-    bool cverr = OpenCVWrapper::CompositeImage(lvbuf, osd_image_data, image_buff, &image_size);
+    bool cverr = OpenCVWrapper::CompositeImage(lvbuf, &osd_image_data, composite_frame->raw(), &image_size);
 
     if (!cverr || (0 == image_size) ) {
         // FAILED
-        tout << "GetLiveView FAILED LiveView&OSD Composite\n";
-        if (liveview_image_buff) {
-            delete[] liveview_image_buff; // Release
-            liveview_image_buff = nullptr;
-        }
-        if (liveview_image_data) {
-            delete liveview_image_data; // Release
-            liveview_image_data = nullptr;
-        }
-        delete[] osd_image_buff; // Release
-        delete osd_image_data; // Release
-        delete[] image_buff; // Release
+        LOG_EVERY_MS(LogLevel::Warn, 5000, "GetLiveView FAILED LiveView&OSD Composite");
         return;
     }
+    composite_frame->size = image_size;
 
     // Display
     // etc.
@@ -860,35 +694,13 @@ void CameraDevice::get_live_view_and_OSD()
     memset(path, 0, sizeof(path));
     if (NULL == getcwd(path, sizeof(path) - 1)) {
         // FAILED
-        if (liveview_image_buff) {
-            delete[] liveview_image_buff; // Release
-            liveview_image_buff = nullptr;
-        }
-        if (liveview_image_data) {
-            delete liveview_image_data; // Release
-            liveview_image_data = nullptr;
-        }
-        delete[] osd_image_buff; // Release
-        delete osd_image_data; // Release
-        delete[] image_buff; // Release
-        tout << "Folder path is too long.\n";
+        LOG_WARN("Folder path is too long.");
         return;
     }
     char filename[] = "/LiveView000000.JPG";
     if (strlen(path) + strlen(filename) > MAC_MAX_PATH) {
         // FAILED
-        if (liveview_image_buff) {
-            delete[] liveview_image_buff; // Release
-            liveview_image_buff = nullptr;
-        }
-        if (liveview_image_data) {
-            delete liveview_image_data; // Release
-            liveview_image_data = nullptr;
-        }
-        delete[] osd_image_buff; // Release
-        delete osd_image_data; // Release
-        delete[] image_buff; // Release
-        tout << "Failed to create save path.\n";
+        LOG_WARN("Failed to create save path.");
         return;
     }
     strncat(path, filename, strlen(filename));
@@ -896,29 +708,18 @@ void CameraDevice::get_live_view_and_OSD()
     auto path = fs::current_path();
     path.append(TEXT("LiveView000000.JPG"));
 #endif
-    tout << path << '\n';
+    LOG_DEBUG("LiveView&OSD saved to " << path);
 
     std::ofstream file(path, std::ios::out | std::ios::binary);
     if (!file.bad())
     {
-        file.write((char*)image_buff, image_size);
+        file.write(composite_frame->data(), composite_frame->size);
         file.close();
     }
-    tout << "GetLiveView SUCCESS\n";
-    if (liveview_image_buff) {
-        delete[] liveview_image_buff; // Release
-        liveview_image_buff = nullptr;
-    }
-    if (liveview_image_data) {
-        delete liveview_image_data; // Release
-        liveview_image_data = nullptr;
-    }
-    delete[] osd_image_buff; // Release
-    delete osd_image_data; // Release
-    delete[] image_buff; // Release
+    LOG_DEBUG("GetLiveView SUCCESS");
 }
 
-void CameraDevice::get_live_view(bool isLocal)
+void CameraDevice::get_live_view()
 {
     // check OSD gettable status
     std::int32_t nprop = 0;
@@ -935,7 +736,7 @@ void CameraDevice::get_live_view(bool isLocal)
     }
 
     if (false == bSelected) {
-        get_live_view_only(isLocal);
+        get_live_view_only();
         return;
     }
 
@@ -956,7 +757,7 @@ void CameraDevice::get_live_view(bool isLocal)
     ss >> selected_index;
 
     if (LiveViewOnly == selected_index) {
-        get_live_view_only(isLocal);
+        get_live_view_only();
     }
     else if (LiveViewAndOSD == selected_index) {
         get_live_view_and_OSD();
@@ -989,38 +790,37 @@ void CameraDevice::get_osd_image()
     }
 
     if (0 == triStatus) {
-        tout << "Get OSD Image is not supported.\n";
+        LOG_WARN("Get OSD Image is not supported.");
         return;
     }
     else if (1 == triStatus) {
-        tout << "Get OSD Image is not executable.\n";
+        LOG_WARN("Get OSD Image is not executable.");
         return;
     }
 
-    tout << "Get OSD Image...\n";
+    LOG_INFO("Get OSD Image...");
 
     auto* image_data = new SDK::CrOSDImageDataBlock();
     if (!image_data)
     {
-        tout << "GetOSDImage FAILED (new CrImageDataBlock class)\n";
+        LOG_WARN("GetOSDImage FAILED (new CrImageDataBlock class)");
         return;
     }
 
-    CrInt8u *pdata = new CrInt8u[CR_OSD_IMAGE_MAX_SIZE];
-    image_data->SetData(pdata);
+    FramePtr osd_frame = m_osdFramePool.acquire(CR_OSD_IMAGE_MAX_SIZE);
+    image_data->SetData(osd_frame->raw());
 
     auto err = SDK::GetOSDImage(m_device_handle, image_data);
     if (CR_FAILED(err))
     {
         // FAILED
         if (err == SDK::CrWarning_Frame_NotUpdated) {
-            tout << "Warning. GetLiveView Frame NotUpdate\n";
+            LOG_DEBUG("Warning. GetLiveView Frame NotUpdate");
         }
         else{
-            tout << "Error GetLiveView FAILED\n";
+            LOG_WARN("Error GetLiveView FAILED");
         }
 
-        delete[] pdata;
         delete image_data; // Release
     }
     else
@@ -1035,14 +835,14 @@ void CameraDevice::get_osd_image()
             if(NULL == getcwd(path, sizeof(path) - 1)){
                 // FAILED
                 delete image_data; // Release
-                tout << "Folder path is too long.\n";
+                LOG_WARN("Folder path is too long.");
                 return;
             }
             char filename[] ="/OSDImage000000.PNG";
             if(strlen(path) + strlen(filename) > MAC_MAX_PATH){
                 // FAILED
                 delete image_data; // Release
-                tout << "Failed to create save path.\n";
+                LOG_WARN("Failed to create save path.");
                 return;
             }
             strncat(path, filename, strlen(filename));
@@ -1050,7 +850,7 @@ void CameraDevice::get_osd_image()
             auto path = fs::current_path();
             path.append(TEXT("OSDImage000000.PNG"));
 #endif
-            tout << path << '\n';
+            LOG_INFO("OSD image saved to " << path);
 
             std::ofstream file(path, std::ios::out | std::ios::binary);
             if (!file.bad())
@@ -1058,9 +858,8 @@ void CameraDevice::get_osd_image()
                 file.write((char*)image_data->GetImageData(), image_data->GetImageSize());
                 file.close();
             }
-            tout << "GetOSDImage SUCCESS\n";
+            LOG_INFO("GetOSDImage SUCCESS");
         }
-        delete[] pdata;
         delete image_data; // Release
     }
 }
@@ -1068,7 +867,7 @@ void CameraDevice::get_osd_image()
 void CameraDevice::get_live_view_image_quality()
 {
     load_properties();
-    tout << "Live View Image Quality: " << format_live_view_image_quality(m_prop.live_view_image_quality.current) << '\n';
+    LOG_INFO("Live View Image Quality: " << format_live_view_image_quality(m_prop.live_view_image_quality.current));
 }
 
 void CameraDevice::get_select_media_format()
@@ -1106,22 +905,20 @@ bool CameraDevice::get_custom_wb()
 void CameraDevice::get_zoom_operation()
 {
     load_properties();
-    tout << "Zoom Operation Status: " << format_zoom_operation_status(m_prop.zoom_operation_status.current) << '\n';
+    LOG_DEBUG("Zoom Operation Status: " << format_zoom_operation_status(m_prop.zoom_operation_status.current));
     if (m_prop.zoom_setting_type.current > 0) {
-        tout << "Zoom Setting Type    : " << format_zoom_setting_type(m_prop.zoom_setting_type.current) << '\n';
+        LOG_DEBUG("Zoom Setting Type    : " << format_zoom_setting_type(m_prop.zoom_setting_type.current));
     }
     if (m_prop.zoom_types_status.current > 0) {
-        tout << "Zoom Type Status     : " << format_zoom_types_status(m_prop.zoom_types_status.current) << '\n';
+        LOG_DEBUG("Zoom Type Status     : " << format_zoom_types_status(m_prop.zoom_types_status.current));
     }
 
     // Zoom Speed Range is not supported
     if (m_prop.zoom_speed_range.possible.size() < 2) {
-        tout << "Zoom Speed Range     : -1 to 1" << std::endl 
-             << "Zoom Speed Type      : " << format_remocon_zoom_speed_type(m_prop.remocon_zoom_speed_type.current) << std::endl;
+        LOG_DEBUG("Zoom Speed Range     : -1 to 1" << ", " << "Zoom Speed Type      : " << format_remocon_zoom_speed_type(m_prop.remocon_zoom_speed_type.current));
     }
     else {
-        tout << "Zoom Speed Range     : " << (int)m_prop.zoom_speed_range.possible.at(0) << " to " << (int)m_prop.zoom_speed_range.possible.at(1) << std::endl
-             << "Zoom Speed Type      : " << format_remocon_zoom_speed_type(m_prop.remocon_zoom_speed_type.current) << std::endl;
+        LOG_DEBUG("Zoom Speed Range     : " << (int)m_prop.zoom_speed_range.possible.at(0) << " to " << (int)m_prop.zoom_speed_range.possible.at(1) << ", " << "Zoom Speed Type      : " << format_remocon_zoom_speed_type(m_prop.remocon_zoom_speed_type.current));
     }
 
     // Zoom Bar Information
@@ -1130,39 +927,39 @@ void CameraDevice::get_zoom_operation()
     CrInt32u getCode = SDK::CrDevicePropertyCode::CrDeviceProperty_Zoom_Bar_Information;
     auto status = SDK::GetSelectDeviceProperties(m_device_handle, 1, &getCode, &prop_list, &nprop);
     if (CR_FAILED(status)) {
-        tout << "Failed to get Zoom Bar Information.\n";
+        LOG_WARN("Failed to get Zoom Bar Information.");
         return;
     }
     if (prop_list && 0 < nprop) {
         auto prop = prop_list[0];
         if (SDK::CrDevicePropertyCode::CrDeviceProperty_Zoom_Bar_Information == prop.GetCode())
         {
-            tout << "Zoom Bar Information : 0x" << std::hex << prop.GetCurrentValue() << std::dec << '\n';
+            LOG_DEBUG("Zoom Bar Information : 0x" << std::hex << prop.GetCurrentValue());
         }
         SDK::ReleaseDeviceProperties(m_device_handle, prop_list);
     }
 
     // Zoom Distance
     if (-1 == m_prop.zoom_distance.writable) {
-        tout << "Zoom Distance is not supported.\n";
+        LOG_WARN("Zoom Distance is not supported.");
     }
     else {
-        tout << "Zoom Distance Current Value : " << m_prop.zoom_distance.current << std::endl;
-        tout << "Zoom Distance min    : " << m_prop.zoom_distance.possible.at(0) << std::endl;
-        tout << "Zoom Distance max    : " << m_prop.zoom_distance.possible.at(1) << std::endl;
-        tout << "Zoom Distance step   : " << m_prop.zoom_distance.possible.at(2) << std::endl;
+        LOG_DEBUG("Zoom Distance Current Value : " << m_prop.zoom_distance.current);
+        LOG_DEBUG("Zoom Distance min    : " << m_prop.zoom_distance.possible.at(0));
+        LOG_DEBUG("Zoom Distance max    : " << m_prop.zoom_distance.possible.at(1));
+        LOG_DEBUG("Zoom Distance step   : " << m_prop.zoom_distance.possible.at(2));
     }
 
     // Lens Model Name
     if (nullptr == m_lensModelNameProp) {
-        tout << "Lens Model Name is not supported.\n";
+        LOG_WARN("Lens Model Name is not supported.");
     }
     else {
         if (0 < (CrInt16u)*m_lensModelNameProp->GetCurrentStr()) {
-            tout << "\nLens Model Name : " << getCurrentStr(m_lensModelNameProp) << std::endl;
+            LOG_DEBUG("Lens Model Name : " << getCurrentStr(m_lensModelNameProp));
         }
         else {
-            tout << "Lens Model Name could not be obtained.\n";
+            LOG_WARN("Lens Model Name could not be obtained.");
         }
     }
 }
@@ -1690,20 +1487,20 @@ bool CameraDevice::set_save_info() const
     text_char path[MAC_MAX_PATH]; /*MAX_PATH*/
     memset(path, 0, sizeof(path));
     if(NULL == getcwd(path, sizeof(path) - 1)){
-        tout << "Folder path is too long.\n";
+        LOG_ERROR("Folder path is too long.");
         return false;
     }
     auto save_status = SDK::SetSaveInfo(m_device_handle
         , path, (char*)"", ImageSaveAutoStartNo);
 #else
     text path = fs::current_path().native();
-    tout << path.data() << '\n';
+    LOG_INFO("Save path: " << path.data());
 
     auto save_status = SDK::SetSaveInfo(m_device_handle
         , const_cast<text_char*>(path.data()), const_cast<text_char*>(TEXT("")), ImageSaveAutoStartNo);
 #endif
     if (CR_FAILED(save_status)) {
-        tout << "Failed to set save path.\n";
+        LOG_ERROR("Failed to set save path.");
         return false;
     }
     return true;
@@ -2740,7 +2537,7 @@ void CameraDevice::zoom(int speed) {
     bool ret = true;
     bool cancel = false;
     if (m_prop.zoom_speed_range.possible.size() < 2) {
-        tout << std::endl << "camera not support range\n";
+        LOG_INFO("camera not support range");
         switch (speed)
         {
         case 0:
@@ -2761,16 +2558,16 @@ void CameraDevice::zoom(int speed) {
         if ((speed < (int)m_prop.zoom_speed_range.possible.at(0)) || ((int)m_prop.zoom_speed_range.possible.at(1) < speed)) {
             cancel = true;
             ptpValue = SDK::CrZoomOperation::CrZoomOperation_Stop;
-            tout << "Input cancelled.\n";
+            LOG_WARN("Zoom speed " << speed << " out of range, stop zooming");
         } else {
             ptpValue = (CrInt64)speed;
         }
     }
     if (SDK::CrZoomOperationEnableStatus::CrZoomOperationEnableStatus_Enable != m_prop.zoom_operation_status.current) {
-        std::cout << "Zoom Operation is not executable.\n";
+        LOG_WARN("Zoom Operation is not executable.");
         return;
     }
-    std::cout << "ptpValue=" << ptpValue << std::endl;
+    LOG_DEBUG("ptpValue=" << ptpValue);
     SDK::CrDeviceProperty prop;
     prop.SetCode(SDK::CrDevicePropertyCode::CrDeviceProperty_Zoom_Operation);
     prop.SetCurrentValue((CrInt64u)ptpValue);
@@ -4828,7 +4625,7 @@ void CameraDevice::change_live_view_enable()
 {
     CrInt32u current = 0;
     SDK::GetDeviceSetting(m_device_handle, SDK::Setting_Key_EnableLiveView, &current);
-    tout << "EnableLiveView Current Setting Value:" << current;
+    LOG_INFO("EnableLiveView Current Setting Value:" << current);
 
     // tout << std::endl << "Are you sure you want to reverse EnableLiveView? (y/n) > ";
     // text yesno;
@@ -4842,6 +4639,18 @@ void CameraDevice::change_live_view_enable()
     SDK::SetDeviceSetting(m_device_handle, SDK::Setting_Key_EnableLiveView, (CrInt32u)m_lvEnbSet);
 }
 
+bool CameraDevice::set_live_view_enable(bool enable)
+{
+    CrInt32u current = 0;
+    SDK::CrError err = SDK::GetDeviceSetting(m_device_handle, SDK::Setting_Key_EnableLiveView, &current);
+    m_lvEnbSet = enable;
+    if (CR_SUCCEEDED(err) && (current != 0) == enable) {
+        return true;
+    }
+    err = SDK::SetDeviceSetting(m_device_handle, SDK::Setting_Key_EnableLiveView, (CrInt32u)enable);
+    return CR_SUCCEEDED(err);
+}
+
 bool CameraDevice::is_connected() const
 {
     return m_connected.load();
@@ -4860,17 +4669,18 @@ void CameraDevice::OnConnected(SDK::DeviceConnectionVersioin version)
 {
     m_connected.store(true);
     text id(this->get_id());
-    tout << "Connected to " << m_info->GetModel() << " (" << id.data() << ")\n";
+    LOG_INFO("Connected to " << m_info->GetModel() << " (" << id.data() << ")");
 }
 
 void CameraDevice::OnDisconnected(CrInt32u error)
 {
     m_connected.store(false);
+    m_lvInfo.reset();
     text id(this->get_id());
-    tout << "Disconnected from " << m_info->GetModel() << " (" << id.data() << ")\n";
+    LOG_INFO("Disconnected from " << m_info->GetModel() << " (" << id.data() << ")");
     if ((false == m_spontaneous_disconnection) && (SDK::CrSdkControlMode_ContentsTransfer == m_modeSDK))
     {
-        tout << "Please input '0' to return to the TOP-MENU\n";
+        LOG_INFO("Please input '0' to return to the TOP-MENU");
     }
 }
 
@@ -4882,6 +4692,7 @@ void CameraDevice::OnPropertyChanged()
 void CameraDevice::OnLvPropertyChanged()
 {
     // tout << "LvProperty changed.\n";
+    m_lvInfo.invalidate();
 }
 
 void CameraDevice::OnCompleteDownload(CrChar* filename, CrInt32u type )
@@ -4890,13 +4701,13 @@ void CameraDevice::OnCompleteDownload(CrChar* filename, CrInt32u type )
     switch (type)
     {
     case SCRSDK::CrDownloadSettingFileType_None:
-        tout << "Complete download. File: " << file.data() << '\n';
+        LOG_INFO("Complete download. File: " << file.data());
         if (onCaptureCompleted != nullptr) {
             (*onCaptureCompleted)(std::string(file.data()));
         }
         break;
     case SCRSDK::CrDownloadSettingFileType_Setup:
-        tout << "Complete download. Camera Setting File: " << file.data() << '\n';
+        LOG_INFO("Complete download. Camera Setting File: " << file.data());
         break;
     default:
         break;
@@ -4908,23 +4719,22 @@ void CameraDevice::OnNotifyContentsTransfer(CrInt32u notify, SDK::CrContentHandl
     // Start
     if (SDK::CrNotify_ContentsTransfer_Start == notify)
     {
-        tout << "[START] Contents Handle: 0x " << std::hex << contentHandle << std::dec << std::endl;
+        LOG_INFO("[START] Contents Handle: 0x " << std::hex << contentHandle);
     }
     // Complete
     else if (SDK::CrNotify_ContentsTransfer_Complete == notify)
     {
         text file(filename);
-        tout << "[COMPLETE] Contents Handle: 0x" << std::hex << contentHandle << std::dec << ", File: " << file.data() << std::endl;
+        LOG_INFO("[COMPLETE] Contents Handle: 0x" << std::hex << contentHandle << std::dec << ", File: " << file.data());
     }
     // Other
     else
     {
         text msg = get_message_desc(notify);
         if (msg.empty()) {
-            tout << "[-] Content transfer failure. 0x" << std::hex << notify << ", handle: 0x" << contentHandle << std::dec << std::endl;
+            LOG_WARN("[-] Content transfer failure. 0x" << std::hex << notify << ", handle: 0x" << contentHandle);
         } else {
-            tout << "[-] Content transfer failure. handle: 0x" << std::hex << contentHandle  << std::dec << std::endl << "    -> ";
-            tout << msg.data() << std::endl;
+            LOG_WARN("[-] Content transfer failure. handle: 0x" << std::hex << contentHandle << std::dec << " -> " << msg.data());
         }
     }
 }
@@ -4933,7 +4743,7 @@ void CameraDevice::OnWarning(CrInt32u warning)
 {
     text id(this->get_id());
     if (SDK::CrWarning_Connect_Reconnecting == warning) {
-        tout << "Device Disconnected. Reconnecting... " << m_info->GetModel() << " (" << id.data() << ")\n";
+        LOG_EVERY_MS(LogLevel::Warn, 5000, "Device Disconnected. Reconnecting... " << m_info->GetModel() << " (" << id.data() << ")");
         return;
     }
     switch (warning)
@@ -4941,51 +4751,51 @@ void CameraDevice::OnWarning(CrInt32u warning)
     case SDK::CrWarning_ContentsTransferMode_Invalid:
     case SDK::CrWarning_ContentsTransferMode_DeviceBusy:
     case SDK::CrWarning_ContentsTransferMode_StatusError:
-        tout << "\nThe camera is in a condition where it cannot transfer content.\n\n";
-        tout << "Please input '0' to return to the TOP-MENU and connect again.\n";
+        LOG_WARN("The camera is in a condition where it cannot transfer content.");
+        LOG_INFO("Please input '0' to return to the TOP-MENU and connect again.");
         break;
     case SDK::CrWarning_ContentsTransferMode_CanceledFromCamera:
-        tout << "\nContent transfer mode canceled.\n";
-        tout << "If you want to continue content transfer, input '0' to return to the TOP-MENU and connect again.\n\n";
+        LOG_WARN("Content transfer mode canceled.");
+        LOG_INFO("If you want to continue content transfer, input '0' to return to the TOP-MENU and connect again.");
         break;
     case SDK::CrWarning_CameraSettings_Read_Result_OK:
-        tout << "\nConfiguration file read successfully.\n\n";
+        LOG_INFO("Configuration file read successfully.");
         break;
     case SDK::CrWarning_CameraSettings_Read_Result_NG:
-        tout << "\nFailed to load configuration file\n\n";
+        LOG_WARN("Failed to load configuration file");
         break;
     case SDK::CrWarning_CameraSettings_Save_Result_NG:
-        tout << "\nConfiguration file save request failed.\n\n";
+        LOG_WARN("Configuration file save request failed.");
         break;
     case SDK::CrWarning_RequestDisplayStringList_Success:
-        tout << "\nRequest for DisplayStringList  successfully\n\n";
+        LOG_INFO("Request for DisplayStringList  successfully");
         m_dispCameraKeyCV.notify_all();
         break;
     case SDK::CrWarning_RequestDisplayStringList_Error: 
-        tout << "\nFailed to Request for DisplayStringList\n\n";
+        LOG_WARN("Failed to Request for DisplayStringList");
         m_dispCameraKeyCV.notify_all();
         break;
     case SDK::CrWarning_CustomWBCapture_Result_OK:
-        tout << "\nCustom WB capture successful.\n\n";
+        LOG_INFO("Custom WB capture successful.");
         break;
     case SDK::CrWarning_CustomWBCapture_Result_Invalid:
     case SDK::CrWarning_CustomWBCapture_Result_NG:
-        tout << "\nCustom WB capture failure.\n\n";
+        LOG_WARN("Custom WB capture failure.");
         break;
     case SDK::CrWarning_FocusPosition_Result_Invalid:
-        tout << "\nFocus Position Result Invalid.\n\n";
+        LOG_WARN("Focus Position Result Invalid.");
         break;
     case SDK::CrWarning_FocusPosition_Result_OK:
-        tout << "\nFocus Position Result OK.\n\n";
+        LOG_INFO("Focus Position Result OK.");
         break;
     case SDK::CrWarning_FocusPosition_Result_NG:
-        tout << "\nFocus Position Result NG.\n\n";
+        LOG_WARN("Focus Position Result NG.");
         break;
     case SDK::CrWarning_ControlMonitoring_Result_Start_Failed:
-        tout << "\nMonitoring Start Failed.\n\n";
+        LOG_WARN("Monitoring Start Failed.");
         break;
     case SDK::CrWarning_ControlMonitoring_Result_Stop_Failed:
-        tout << "\nMonitoring Stop Failed.\n\n";
+        LOG_WARN("Monitoring Stop Failed.");
         break;
     case SDK::CrWarning_ControlMonitoring_Result_Invalid:
     case SDK::CrWarning_ControlMonitoring_Result_SystemError:
@@ -4996,46 +4806,46 @@ void CameraDevice::OnWarning(CrInt32u warning)
     case SDK::CrWarning_ControlMonitoring_Result_InvalidParameter:
     case SDK::CrWarning_ControlMonitoring_Result_WifiHighTemperature:
     case SDK::CrWarning_ControlMonitoring_Result_Streaming:
-        tout << "\nMonitoring Result NG.\n\n"; tout << warning;
+        LOG_WARN("Monitoring Result NG: 0x" << std::hex << warning);
         break;
     case SDK::CrWarning_ControlMonitoring_LostReceiving:
-        tout << "\nMonitoring Lost Receiving.\n\n";
+        LOG_WARN("Monitoring Lost Receiving.");
         break;
     case SDK::CrWarning_ControlMonitoring_ErrorOccurred:
-        tout << "\nMonitoring Error Occurred.\n\n";
+        LOG_WARN("Monitoring Error Occurred.");
         break;
     case SDK::CrWarning_RequestZoomAndFocusPreset_Result_Success:
-        tout << "\nRequest for ZoomAndFocusPreset successfully\n\n";
+        LOG_INFO("Request for ZoomAndFocusPreset successfully");
         break;
     case SDK::CrWarning_RequestZoomAndFocusPreset_Result_DeviceBusy:
     case SDK::CrWarning_RequestZoomAndFocusPreset_Result_Error:
-        tout << "\nFailed to Request for ZoomAndFocusPreset\n\n";
+        LOG_WARN("Failed to Request for ZoomAndFocusPreset");
         break;
     case SDK::CrWarning_Format_Failed:
         m_media_formatComplete = true;
-        tout << std::endl << "Format failed \n\n";
+        LOG_WARN("Format failed");
         break;
     case SDK::CrWarning_Format_Invalid:
         m_media_formatComplete = true;
-        tout << std::endl << "Format invalid \n\n";
+        LOG_WARN("Format invalid");
         break;
     case SDK::CrWarning_Format_Complete:
         m_media_formatComplete = true;
-        tout << std::endl << "Format completed \n\n";
+        LOG_INFO("Format completed");
         break;
     case SDK::CrWarning_Format_Canceled:
         m_media_formatComplete = true;
-        tout << std::endl << "Format canceled \n\n";
+        LOG_WARN("Format canceled");
         break;
     default:
-        tout << "OnWarning:" << CrErrorString(warning).c_str() << "\n";
+        LOG_WARN("OnWarning:" << CrErrorString(warning).c_str());
         return;
     }
 }
 
 void CameraDevice::OnWarningExt(CrInt32u warning, CrInt32 param1, CrInt32 param2, CrInt32 param3)
 {
-    tout << "OnWarningExt:" << CrWarningExtString(warning, param1, param2, param3).c_str() << "\n";
+    LOG_WARN("OnWarningExt:" << CrWarningExtString(warning, param1, param2, param3).c_str());
 }
 
 void CameraDevice::OnNotifyFTPTransferResult(CrInt32u notify, CrInt32u numOfSuccess, CrInt32u numOfFail)
@@ -5076,26 +4886,26 @@ void CameraDevice::OnNotifyRemoteFirmwareUpdateResult(CrInt32u notify, const voi
     case SDK::CrNotify_RemoteFirmware_Precheck_NG:
         {
             auto eve = (SDK::CrNotifyParam_FirmwareUpdateEvent*)param;
-            tout << "Precheck NG(0x" << std::hex << *eve << std::dec << ")\n";
+            LOG_WARN("Precheck NG(0x" << std::hex << *eve << std::dec << ")");
         }
         break;
     case SDK::CrNotify_RemoteFirmware_Precheck_OK:
-        tout << "Precheck OK\n";
+        LOG_INFO("Precheck OK");
         break;
     case SDK::CrNotify_RemoteFirmware_UpdateEvent:
         {
             auto eve = (const SDK::CrNotifyParam_FirmwareUpdateEvent*)param;
-            tout << "Firmware Update Event(0x" << std::hex << *eve << std::dec << ")\n";
+            LOG_INFO("Firmware Update Event(0x" << std::hex << *eve << std::dec << ")");
         }
         break;
     case SDK::CrNotify_RemoteFirmware_Upload_NG:
         {
             auto eve = (const SDK::CrNotifyParam_FirmwareUploadResult*)param;
-            tout << "Firmware Upload Result(0x" << std::hex << *eve << std::dec << ")\n";
+            LOG_WARN("Firmware Upload Result(0x" << std::hex << *eve << std::dec << ")");
         }
         break;
     case SDK::CrNotify_RemoteFirmware_Upload_OK:
-        tout << "Firmware Upload OK\n";
+        LOG_INFO("Firmware Upload OK");
         break;
     case SDK::CrNotify_RemoteFirmware_Upload_Rate:
         {
@@ -5106,30 +4916,30 @@ void CameraDevice::OnNotifyRemoteFirmwareUpdateResult(CrInt32u notify, const voi
     case SDK::CrNotify_RemoteFirmware_Update_NG:
         {
             auto eve = (const SDK::CrNotifyParam_FirmwareUpdateEvent*)param;
-            tout << "Firmware Update Result(0x" << std::hex << *eve << std::dec << ")\n";
+            LOG_WARN("Firmware Update Result(0x" << std::hex << *eve << std::dec << ")");
         }
         break;
     case SDK::CrNotify_RemoteFirmware_Update_OK:
-        tout << "Firmware Update Request passed to Camera.\n";
+        LOG_INFO("Firmware Update Request passed to Camera.");
         break;
     case SDK::CrNotify_RemoteFirmware_GetUpdaterInfo_Request_NG:
         {
             auto err = (const SDK::CrError*)param;
-            tout << "GetUpdaterInfo Request NG(0x" << std::hex << *err << std::dec << ")\n";
+            LOG_WARN("GetUpdaterInfo Request NG(0x" << std::hex << *err << std::dec << ")");
         }
         break;
     case SDK::CrNotify_RemoteFirmware_GetUpdaterInfo_NG:
         {
             auto status = (const SDK::CrNotifyParam_FirmwareUpdaterGetStatus*)param;
-            tout << "Get Firmware Updater Info NG(0x" << std::hex << *status << std::dec << ")\n";
+            LOG_WARN("Get Firmware Updater Info NG(0x" << std::hex << *status << std::dec << ")");
         }
         break;
     case SDK::CrNotify_RemoteFirmware_GetUpdaterInfo_OK:
         {
-            tout << "Get Firmware Updater Info OK\n";
+            LOG_INFO("Get Firmware Updater Info OK");
             auto result = (const CrChar*)param;
             text firmwareVersion(result);
-            tout << "Firmware Version:" << firmwareVersion << "\n";
+            LOG_INFO("Firmware Version:" << firmwareVersion);
         }
         break;
     }
@@ -5167,6 +4977,13 @@ void CameraDevice::OnPropertyChangedCodes(CrInt32u num, CrInt32u* codes)
     //    tout << ", 0x" << codes[i];
     //}
     //tout << std::endl << std::dec;
+    for (CrInt32u i = 0; i < num; ++i) {
+        // 预览画质决定单帧最大尺寸
+        if (codes[i] == SDK::CrDeviceProperty_LiveView_Image_Quality) {
+            m_lvInfo.invalidateBufferSize();
+            break;
+        }
+    }
 }
 
 void CameraDevice::OnLvPropertyChangedCodes(CrInt32u num, CrInt32u* codes)
@@ -5178,6 +4995,20 @@ void CameraDevice::OnLvPropertyChangedCodes(CrInt32u num, CrInt32u* codes)
     //    tout << ", 0x" << codes[i];
     //}
     //tout << std::endl;
+    // 只拉取变化的code，更新预览元数据缓存（在SDK回调线程执行，不占用取帧线程）
+    {
+        SDK::CrLiveViewProperty* lvProperty = nullptr;
+        int32_t nprop = 0;
+        SDK::CrError err = SDK::GetSelectLiveViewProperties(m_device_handle, num, codes, &lvProperty, &nprop);
+        if (CR_SUCCEEDED(err) && lvProperty) {
+            m_lvInfo.update(lvProperty, nprop);
+            SDK::ReleaseLiveViewProperties(m_device_handle, lvProperty);
+        }
+        else {
+            LOG_EVERY_MS(LogLevel::Debug, 5000, "GetSelectLiveViewProperties FAILED 0x" << std::hex << err);
+            m_lvInfo.invalidate();
+        }
+    }
 #if 0
     SDK::CrLiveViewProperty* lvProperty = nullptr;
     int32_t nprop = 0;
@@ -5312,7 +5143,6 @@ void CameraDevice::OnLvPropertyChangedCodes(CrInt32u num, CrInt32u* codes)
         SDK::ReleaseLiveViewProperties(m_device_handle, lvProperty);
     }
 #endif
-    tout << std::dec;
 }
 
 void CameraDevice::OnError(CrInt32u error)
@@ -5321,16 +5151,15 @@ void CameraDevice::OnError(CrInt32u error)
     text msg = get_message_desc(error);
     if (!msg.empty()) {
         // output is 2 line
-        tout << std::endl << msg.data() << std::endl;
-        tout << m_info->GetModel() << " (" << id.data() << ")" << std::endl;
+        LOG_ERROR(msg.data() << ", " << m_info->GetModel() << " (" << id.data() << ")");
 
         if (SDK::CrError_Connect_FailBusy == error) {
-            tout << "Too many connections for camera" << std::endl;
+            LOG_ERROR("Too many connections for camera");
             return;
         }
         if (SDK::CrError_Connect_TimeOut == error) {
             // append 1 line
-            tout << "Please input '0' after Connect camera" << std::endl;
+            LOG_INFO("Please input '0' after Connect camera");
             return;
         }
         if (SDK::CrError_Connect_Disconnected == error)
@@ -5347,7 +5176,7 @@ void CameraDevice::OnError(CrInt32u error)
             m_fingerprint.clear();
             m_userPassword.clear();
         }
-        tout << "Please input '0' to return to the TOP-MENU\n";
+        LOG_INFO("Please input '0' to return to the TOP-MENU");
     }
 }
 
@@ -5370,7 +5199,7 @@ void CameraDevice::load_properties(CrInt32u num, CrInt32u* codes)
     }
 
     if (CR_FAILED(status)) {
-        tout << "Failed to get device properties.\n";
+        LOG_EVERY_MS(LogLevel::Warn, 5000, "Failed to get device properties.");
         return;
     }
 
@@ -9761,12 +9590,12 @@ void CameraDevice::set_ptzf_preset()
 }
 
 void CameraDevice::power_off() {
-    tout << "power_off\n";
+    LOG_INFO("power_off");
     SDK::SendCommand(m_device_handle, SDK::CrCommandId::CrCommandId_PowerOff, SDK::CrCommandParam::CrCommandParam_Down);
 }
 
 void CameraDevice::power_on() {
-    tout << "power_on\n";
+    LOG_INFO("power_on");
     SDK::SendCommand(m_device_handle, SDK::CrCommandId::CrCommandId_PowerOn, SDK::CrCommandParam::CrCommandParam_Down);
     std::this_thread::sleep_for(35ms);
     SDK::SendCommand(m_device_handle, SDK::CrCommandId::CrCommandId_PowerOn, SDK::CrCommandParam::CrCommandParam_Up);
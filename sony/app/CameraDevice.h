@@ -25,6 +25,8 @@ typedef int errno_t;
 #include "PropertyValueTable.h"
 #include "Text.h"
 #include "MessageDefine.h"
+#include "FramePool.h"
+#include "LiveViewInfo.h"
 
 namespace cli
 {
@@ -62,7 +64,6 @@ public:
     ~CameraDevice();
 
     void setCompeletedCallback(std::function<void (std::string)>* cb);
-    bool enable_live_view(bool enable, bool isLocal, std::string& rtmpUrl);
 
     // Get fingerprint
     bool getfingerprint();
@@ -98,9 +99,13 @@ public:
     void get_still_capture_mode();
     void get_focus_mode();
     void get_focus_area();
-    void get_live_view(bool isLocal);
-    void get_live_view_only(bool isLocal);
+    void get_live_view();
+    void get_live_view_only();
+    SCRSDK::CrError fetch_live_view_frame(FramePtr& frame);
     void get_live_view_and_OSD();
+    FramePool::Stats get_live_view_pool_stats() const { return m_lvFramePool.stats(); }
+    LiveViewInfoCache::FrameInfo get_live_view_frame_info() const { return m_lvInfo.frameInfo(); }
+    LiveViewInfoCache::Stats get_live_view_info_stats() const { return m_lvInfo.stats(); }
     void get_live_view_image_quality();
     void get_af_area_position();
     void get_select_media_format();
@@ -198,6 +203,7 @@ public:
     void execute_downup_property(CrInt16u code);
     void execute_pos_xy(CrInt16u code);
     void change_live_view_enable();
+    bool set_live_view_enable(bool enable);
     bool is_live_view_enable() { return m_lvEnbSet; };
     void execute_preset_focus();
     void execute_APS_C_or_Full();
@@ -358,6 +364,12 @@ private:
     CrInt32u m_getContentsData_notify;
     CrInt32u m_getContentsData_per;
     bool isLocal = false;
+    // 预览帧缓冲池，避免每帧重新分配图像缓冲
+    FramePool m_lvFramePool;
+    FramePool m_osdFramePool;
+    // 预览元数据缓存，由 OnLvPropertyChanged[Codes] 刷新
+    LiveViewInfoCache m_lvInfo;
+    SCRSDK::CrError refresh_live_view_info();
 
 #if defined(_UNICODE) || defined(UNICODE)
     std::wstring m_getContentsData_fileName;
@@ -1,89 +1,886 @@
+#pragma once
+
 #include <cstdio>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <cerrno>
+#include <csignal>
 #include <string>
-#include <iostream>
-#include <sys/stat.h>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include "FramePool.h"
+#include "FrameBus.h"
+#include "FrameRing.h"
+#include "MjpegMkvMuxer.h"
+#include "Logger.h"
+#include "Metrics.h"
 
+/**
+ * ffmpeg 编码推流/录像
+ * pushFrame 只把帧放进有界队列，由独立的写线程以非阻塞方式写入 ffmpeg 标准输入。
+ * ffmpeg 卡住（如 RTMP 重连）时管道写满，写线程等待，队列按丢帧策略丢帧，调用方永远不会被阻塞。
+ * 帧以 Matroska 封装写入，时间戳取采集时刻，ffmpeg 按真实帧间隔编码；framerate 参数只用来决定GOP大小。
+ *
+ * ffmpeg 由监护线程 fork/exec 启动并看护：标准输出接 -progress 进度，标准错误记录最近的错误；
+ * 进程意外退出后按指数退避自动重启（1秒起，最长30秒，稳定运行30秒后重置），无人值守的推流可以自行恢复。
+ *
+ * startMulti 用 tee 复用器把一次编码同时送往多个目标（RTMP、HLS、本地文件），每个目标 onfail=ignore，
+ * 某个目标失败只会被摘掉，其他目标继续；被摘掉的目标在 ffmpeg 下次重启时重新尝试。
+ *
+ * startPiped 的标准输出不接进度而交给调用方（如内存 LL-HLS 切片），同样由监护线程看护和重启。
+ *
+ * VideoCodec::Copy 为直通模式：相机JPEG不解码不转码，直接封装进 MKV/AVI 或以 RTP/JPEG 推给 RTSP 服务器，
+ * 适合本地存档和支持 MJPEG 的 NVR。监护线程每秒采样 ffmpeg 的CPU占用，便于比较转码和直通的开销。
+ */
 class FFmpegStreamer {
-    FILE* ffmpegPipe = nullptr;
-
 public:
-    // HLS推流
-    bool startHlsStream(const std::string& outputDir, int framerate = 25) {
-        // 创建输出目录
-        mkdir(outputDir.c_str(), 0755);
-
-        std::string cmd = "ffmpeg -y -f image2pipe -framerate " + std::to_string(framerate) + " -i - "
-                          "-c:v libx264 -preset ultrafast -tune zerolatency "
-                          "-g " + std::to_string(framerate * 2) + " "  // GOP大小
-                          "-f hls "
-                          "-hls_time 2 "              // 每个切片2秒
-                          "-hls_list_size 5 "         // 保留5个切片
-                          "-hls_flags delete_segments "  // 自动删除旧切片
-                          + outputDir + "/stream.m3u8 2>&1";
-        std::cout << "cmd: " << cmd << std::endl;
-        ffmpegPipe = popen(cmd.c_str(), "w");
-        return ffmpegPipe != nullptr;
-    }
-
-    // RTSP推流
-    bool startRtspStream(const std::string& rtspUrl, int framerate = 25, const std::string& transport = "tcp") {
-        std::string cmd = "ffmpeg -y -f image2pipe -framerate " + std::to_string(framerate) + " -i - "
-                          "-c:v libx264 -preset ultrafast -tune zerolatency "
-                          "-g " + std::to_string(framerate) + " "  // GOP大小，RTSP用小GOP降低延迟
-                          "-pix_fmt yuv420p "         // 像素格式
-                          "-f rtsp "
-                          "-rtsp_transport " + transport + " "  // TCP或UDP传输
-                          "-rtsp_flags prefer_tcp "   // 优先使用TCP
-                          + rtspUrl + " 2>&1";
-        std::cout << "cmd: " << cmd << std::endl;
-        ffmpegPipe = popen(cmd.c_str(), "w");
-        return ffmpegPipe != nullptr;
+    // 管道缓冲区目标大小，默认64KB放不下一帧预览JPEG
+    static constexpr int PipeSize = 1024 * 1024;
+    static constexpr int InitialBackoffMs = 1000;
+    static constexpr int MaxBackoffMs = 30000;
+    static constexpr int HealthyRunMs = 30000;
+    // stop() 关闭标准输入后等待 ffmpeg 收尾的时间，超时强制结束
+    static constexpr int StopTimeoutMs = 3000;
+
+    enum class State {
+        Stopped,
+        Starting,       // 进程已启动，还没有输出进度
+        Running,
+        Backoff         // 进程退出，等待重启
+    };
+
+    static const char* stateName(State state) {
+        switch (state) {
+        case State::Starting: return "starting";
+        case State::Running: return "running";
+        case State::Backoff: return "backoff";
+        default: return "stopped";
+        }
+    }
+
+    enum class VideoCodec {
+        H264,           // libx264 ultrafast 转码
+        Copy            // 直通，保持 MJPEG
+    };
+
+    static const char* codecName(VideoCodec codec) {
+        return codec == VideoCodec::Copy ? "copy" : "h264";
+    }
+
+    // 多路输出的一个目标
+    struct Output {
+        enum class Type { Rtmp, Hls, File };
+        Type type = Type::File;
+        std::string target;             // RTMP 地址、HLS 播放列表路径或录像文件路径
+    };
+
+    // ffmpeg -progress 输出的最近一次进度
+    struct Progress {
+        uint64_t frame = 0;
+        double fps = 0;
+        double bitrateKbps = 0;
+        double speed = 0;
+        uint64_t dupFrames = 0;
+        uint64_t dropFrames = 0;
+        uint64_t totalSize = 0;
+        int64_t outTimeUs = 0;
+    };
+
+    struct Stats {
+        uint32_t queued = 0;            // 当前排队帧数
+        uint32_t queueDepth = 0;
+        uint64_t written = 0;           // 完整写入管道的帧数
+        uint64_t dropped = 0;           // 队列满或 ffmpeg 重启期间丢弃的帧数
+        uint64_t aborted = 0;           // 写到一半因停止或管道断开放弃的帧数
+        int pipeSize = 0;               // 实际管道缓冲区大小
+        State state = State::Stopped;
+        int pid = -1;
+        uint32_t restarts = 0;
+        int lastExit = 0;               // 上次退出码，被信号结束为 128+信号
+        std::string lastError;          // ffmpeg 标准错误的最后一行
+        double uptime = 0;              // 当前进程已运行秒数
+        VideoCodec codec = VideoCodec::H264;
+        double cpu = 0;                 // ffmpeg 最近一秒的CPU占用，100 表示占满一个核
+        double cpuSeconds = 0;          // 当前进程累计CPU时间
+        Progress progress;
+        std::vector<Output> outputs;    // startMulti 的目标，路径为当前进程实际写入的路径
+        std::vector<bool> outputFailed; // 对应目标已被 tee 摘掉
+    };
+
+    /**
+     * @param name 作为指标的 sink 标签，如 rtmp、record
+     * @param queueDepth 写线程前的队列深度
+     * @param dropPolicy 队列满时的丢帧策略
+     */
+    explicit FFmpegStreamer(const std::string& name = "ffmpeg", size_t queueDepth = 8,
+                            FrameBus::DropPolicy dropPolicy = FrameBus::DropPolicy::DropOldest)
+        : name(name), queueDepth(queueDepth < 1 ? 1 : queueDepth), dropPolicy(dropPolicy), queue(this->queueDepth),
+          writeLatency(Metrics::instance().histogram("ffmpeg_pipe_write_seconds",
+              "Duration of writing one frame into the ffmpeg pipe", {{"sink", name}})),
+          queueLatency(Metrics::instance().histogram("ffmpeg_queue_seconds",
+              "Time a frame waits in the ffmpeg writer queue", {{"sink", name}})),
+          sinkMetrics(name),
+          droppedTotal(Metrics::instance().counter("ffmpeg_frames_dropped_total",
+              "Frames dropped because the ffmpeg writer queue was full or ffmpeg was restarting", {{"sink", name}})),
+          restartsTotal(Metrics::instance().counter("ffmpeg_restarts_total",
+              "Times a supervised ffmpeg process was restarted after exiting", {{"sink", name}})),
+          queueGauge(Metrics::instance().gauge("ffmpeg_queue_frames",
+              "Frames waiting in the ffmpeg writer queue", {{"sink", name}})),
+          upGauge(Metrics::instance().gauge("ffmpeg_up",
+              "Whether the supervised ffmpeg process is running", {{"sink", name}})),
+          bitrateGauge(Metrics::instance().gauge("ffmpeg_output_bitrate_bps",
+              "Output bitrate reported by ffmpeg -progress", {{"sink", name}})),
+          encoderDropGauge(Metrics::instance().gauge("ffmpeg_encoder_dropped_frames",
+              "Frames dropped by ffmpeg itself since the process started", {{"sink", name}})),
+          cpuGauge(Metrics::instance().gauge("ffmpeg_cpu_millicores",
+              "CPU used by the ffmpeg process over the last second, 1000 = one full core", {{"sink", name}})) {}
+
+    FFmpegStreamer(const FFmpegStreamer&) = delete;
+    FFmpegStreamer& operator=(const FFmpegStreamer&) = delete;
+
+    // RTSP推流，直通时以 RTP/JPEG 发送
+    bool startRtspStream(const std::string& rtspUrl, int framerate = 25, const std::string& transport = "tcp",
+                         VideoCodec codec = VideoCodec::H264) {
+        std::vector<std::string> args = input();
+        if (codec == VideoCodec::Copy) {
+            args.insert(args.end(), {"-c:v", "copy"});
+        } else {
+            args.insert(args.end(), {
+                "-c:v", "libx264", "-preset", "ultrafast", "-tune", "zerolatency",
+                "-g", std::to_string(framerate),    // GOP大小，RTSP用小GOP降低延迟
+                "-pix_fmt", "yuv420p"
+            });
+        }
+        args.insert(args.end(), {
+            "-f", "rtsp",
+            "-rtsp_transport", transport,           // TCP或UDP传输
+            "-rtsp_flags", "prefer_tcp",            // 优先使用TCP
+            rtspUrl
+        });
+        return launch([args](uint32_t) { return args; }, codec);
     }
 
     // RTMP推流
     bool startRtmpStream(const std::string& rtmpUrl, int framerate = 25, int bitrate = 2000) {
-        std::string cmd = "ffmpeg -y -f image2pipe -vcodec mjpeg -framerate " + std::to_string(framerate) + " -i - "
-                          "-c:v libx264 -preset ultrafast -tune zerolatency "
-                          "-b:v " + std::to_string(bitrate) + "k "  // 码率
-                          "-maxrate " + std::to_string(bitrate) + "k "
-                          "-bufsize " + std::to_string(bitrate * 2) + "k "
-                          "-g " + std::to_string(framerate * 2) + " "  // GOP大小
-                          "-pix_fmt yuv420p "         // 像素格式
-                          "-f flv "                   // RTMP使用flv格式
-                          "-flvflags no_duration_filesize "  // RTMP优化
-                          + rtmpUrl + " 2>&1";
-        std::cout << "cmd: " << cmd << std::endl;
-        ffmpegPipe = popen(cmd.c_str(), "w");
-        if (ffmpegPipe) {
-            std::cout << "RTMP stream started, pushing to: " << rtmpUrl << std::endl;
-        } else {
-            std::cerr << "Failed to start RTMP stream" << std::endl;
+        std::vector<std::string> args = input();
+        args.insert(args.end(), {
+            "-c:v", "libx264", "-preset", "ultrafast", "-tune", "zerolatency",
+            "-b:v", std::to_string(bitrate) + "k",  // 码率
+            "-maxrate", std::to_string(bitrate) + "k",
+            "-bufsize", std::to_string(bitrate * 2) + "k",
+            "-g", std::to_string(framerate * 2),    // GOP大小
+            "-pix_fmt", "yuv420p",
+            "-f", "flv",                            // RTMP使用flv格式
+            "-flvflags", "no_duration_filesize",    // RTMP优化
+            rtmpUrl
+        });
+        if (launch([args](uint32_t) { return args; }, VideoCodec::H264)) {
+            LOG_INFO("RTMP stream started, pushing to: " << rtmpUrl);
+            return true;
         }
-        return ffmpegPipe != nullptr;
+        LOG_ERROR("Failed to start RTMP stream");
+        return false;
+    }
+
+    // 本地录像，ffmpeg 重启后写入新的编号文件，不覆盖已录内容；直通时 .avi 路径写 AVI，其余写 MKV
+    bool startRecord(const std::string& path, int framerate = 25, VideoCodec codec = VideoCodec::H264) {
+        return launch([path, framerate, codec](uint32_t restarts) {
+            std::vector<std::string> args = input();
+            if (codec == VideoCodec::Copy) {
+                args.insert(args.end(), {"-c:v", "copy", "-f", hasExtension(path, ".avi") ? "avi" : "matroska"});
+            } else {
+                args.insert(args.end(), {
+                    "-c:v", "libx264", "-preset", "ultrafast",
+                    "-g", std::to_string(framerate * 2),    // GOP大小
+                    "-pix_fmt", "yuv420p",
+                    "-f", "matroska"                        // mkv异常中断也可播放
+                });
+            }
+            args.push_back(restarts > 0 ? numberedPath(path, restarts) : path);
+            return args;
+        }, codec);
     }
 
-    // 推送帧数据
-    void pushFrame(const char* data, size_t size) {
-        if (ffmpegPipe) {
-            std::cout << "push frame" << std::endl;
-            fwrite(data, 1, size, ffmpegPipe);
-            fflush(ffmpegPipe);
+    /**
+     * 一次编码，多路输出
+     * 目标地址中不能含有 tee 的分隔符 | [ ]，由调用方校验
+     * @param bitrate 码率（kbps），所有目标共用
+     * @param codec 直通时只能输出到文件（flv 和 HLS 不支持 MJPEG）
+     */
+    bool startMulti(const std::vector<Output>& outputs, int framerate = 25, int bitrate = 2000,
+                    VideoCodec codec = VideoCodec::H264) {
+        if (outputs.empty()) return false;
+        if (codec == VideoCodec::Copy) {
+            for (const auto& output : outputs) {
+                if (output.type != Output::Type::File) {
+                    LOG_ERROR("ffmpeg copy mode only supports file outputs: " << output.target);
+                    return false;
+                }
+            }
         }
+        return launch([outputs, framerate, bitrate, codec](uint32_t restarts) {
+            std::vector<std::string> args = input();
+            args.insert(args.end(), {"-map", "0:v"});
+            if (codec == VideoCodec::Copy) {
+                args.insert(args.end(), {"-c:v", "copy"});
+            } else {
+                args.insert(args.end(), {
+                    "-c:v", "libx264", "-preset", "ultrafast", "-tune", "zerolatency",
+                    "-b:v", std::to_string(bitrate) + "k",
+                    "-maxrate", std::to_string(bitrate) + "k",
+                    "-bufsize", std::to_string(bitrate * 2) + "k",
+                    "-g", std::to_string(framerate * 2),
+                    "-pix_fmt", "yuv420p",
+                    // flv 需要全局头（SPS/PPS 放在 extradata 中）
+                    "-flags", "+global_header"
+                });
+            }
+            args.insert(args.end(), {"-f", "tee", teeSpec(resolveOutputs(outputs, restarts))});
+            return args;
+        }, codec, outputs);
     }
 
+    // startPiped 的输出回调，返回 false 表示输出无法解析
+    typedef std::function<bool (const char* data, size_t size)> OutputHandler;
+    // 进程每次退出后调用，参数为退出码
+    typedef std::function<void (int exitCode)> ExitHandler;
+
+    /**
+     * 标准输出交给调用方的编码进程，不输出进度
+     * 两个回调都在监护线程中调用；onOutput 返回 false 时 ffmpeg 被强制结束，随后按退避时间重启
+     * @param encodeArgs 输入之后的编码和输出参数，输出应为 pipe:1
+     */
+    bool startPiped(const std::vector<std::string>& encodeArgs, OutputHandler onOutput, ExitHandler onExit,
+                    VideoCodec codec = VideoCodec::H264) {
+        if (active) return true;
+        std::vector<std::string> args = input(false);
+        args.insert(args.end(), encodeArgs.begin(), encodeArgs.end());
+        outputHandler = onOutput;
+        exitHandler = onExit;
+        return launch([args](uint32_t) { return args; }, codec);
+    }
+
+    // 推送池化帧，总线sink线程调用，只入队不写管道
+    void pushFrame(const FramePtr& frame) {
+        if (!frame || frame->empty() || !writing) return;
+        size_t lost = 0;
+        if (queue.size() >= queueDepth) {
+            if (dropPolicy == FrameBus::DropPolicy::DropNewest) {
+                dropped++;
+                droppedTotal.add();
+                return;
+            }
+            Entry oldest;
+            if (queue.pop(oldest)) lost++;
+        }
+        lost += queue.push(Entry{frame, std::chrono::steady_clock::now()});
+        if (lost > 0) {
+            dropped += lost;
+            droppedTotal.add(lost);
+            LOG_EVERY_MS(LogLevel::Warn, 5000, name << ": ffmpeg is not keeping up, " << dropped << " frames dropped so far");
+        }
+        queueGauge.set(static_cast<int64_t>(queue.size()));
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+        }
+        wakeCv.notify_one();
+    }
+
+    // 已启动且未停止，等待重启期间也为 true
     bool isRunning() const {
-        return ffmpegPipe != nullptr;
+        return active;
+    }
+
+    const std::string& sinkName() const { return name; }
+
+    SinkMetrics& metrics() { return sinkMetrics; }
+
+    Stats stats() {
+        Stats s;
+        s.queued = static_cast<uint32_t>(queue.size());
+        s.queueDepth = static_cast<uint32_t>(queueDepth);
+        s.written = written;
+        s.dropped = dropped;
+        s.aborted = aborted;
+        s.pipeSize = pipeSize;
+        std::lock_guard<std::mutex> lock(processMutex);
+        s.state = state;
+        s.pid = childPid;
+        s.restarts = restarts;
+        s.lastExit = lastExit;
+        s.lastError = lastError;
+        if (childPid > 0) {
+            s.uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startedAt).count();
+        }
+        s.codec = codec;
+        s.cpu = cpuPercent;
+        s.cpuSeconds = cpuSeconds;
+        s.progress = progress;
+        if (!multiOutputs.empty()) {
+            s.outputs = resolveOutputs(multiOutputs, restarts);
+            s.outputFailed = outputFailed;
+            s.outputFailed.resize(s.outputs.size(), false);
+        }
+        return s;
     }
 
     void stop() {
-        if (ffmpegPipe) {
-            pclose(ffmpegPipe);
-            ffmpegPipe = nullptr;
+        if (!active) return;
+        // 先停写线程，它在等待管道可写时每100ms检查一次
+        writing = false;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+        }
+        wakeCv.notify_all();
+        if (writer.joinable()) writer.join();
+        {
+            // 关闭标准输入让 ffmpeg 正常收尾（录像写完文件尾），监护线程超时后强制结束
+            std::lock_guard<std::mutex> lock(processMutex);
+            active = false;
+            stopDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(StopTimeoutMs);
+            inPipe.reset();
         }
+        backoffCv.notify_all();
+        if (supervisor.joinable()) supervisor.join();
+        outputHandler = nullptr;
+        exitHandler = nullptr;
+        queueGauge.set(0);
+        LOG_INFO(name << ": ffmpeg stopped, written " << written << ", dropped " << dropped
+            << ", aborted " << aborted << ", restarts " << restarts);
     }
 
     ~FFmpegStreamer() {
         stop();
     }
-};
\ No newline at end of file
+
+private:
+    struct Entry {
+        FramePtr frame;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    // ffmpeg 标准输入的写端，写线程持有引用期间不会被关闭
+    struct Pipe {
+        int fd;
+        explicit Pipe(int fd) : fd(fd) {}
+        ~Pipe() { close(fd); }
+    };
+
+    // 公共参数：进度写到标准输出，输入为带时间戳的 MJPEG/Matroska
+    static std::vector<std::string> input(bool progress = true) {
+        std::vector<std::string> args = {"ffmpeg", "-hide_banner", "-nostats", "-loglevel", "warning"};
+        if (progress) args.insert(args.end(), {"-progress", "pipe:1"});
+        args.insert(args.end(), {"-y", "-f", "matroska", "-i", "-"});
+        return args;
+    }
+
+    static bool hasExtension(const std::string& path, const std::string& ext) {
+        if (path.size() < ext.size()) return false;
+        return strcasecmp(path.c_str() + path.size() - ext.size(), ext.c_str()) == 0;
+    }
+
+    // /a/b.mkv -> /a/b_1.mkv
+    static std::string numberedPath(const std::string& path, uint32_t index) {
+        size_t slash = path.find_last_of('/');
+        size_t dot = path.find_last_of('.');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = path.size();
+        return path.substr(0, dot) + "_" + std::to_string(index) + path.substr(dot);
+    }
+
+    // 重启后文件目标改写到编号文件，HLS 和 RTMP 不变
+    static std::vector<Output> resolveOutputs(const std::vector<Output>& outputs, uint32_t restarts) {
+        std::vector<Output> resolved = outputs;
+        for (auto& output : resolved) {
+            if (output.type == Output::Type::File && restarts > 0) output.target = numberedPath(output.target, restarts);
+        }
+        return resolved;
+    }
+
+    // tee 目标：[f=格式:选项:onfail=ignore]地址|...
+    static std::string teeSpec(const std::vector<Output>& outputs) {
+        std::string spec;
+        for (const auto& output : outputs) {
+            if (!spec.empty()) spec += "|";
+            switch (output.type) {
+            case Output::Type::Rtmp:
+                spec += "[f=flv:flvflags=no_duration_filesize:onfail=ignore]";
+                break;
+            case Output::Type::Hls:
+                spec += "[f=hls:hls_time=2:hls_list_size=6:hls_flags=delete_segments+independent_segments:onfail=ignore]";
+                break;
+            case Output::Type::File:
+                spec += "[f=matroska:onfail=ignore]";
+                break;
+            }
+            spec += output.target;
+        }
+        return spec;
+    }
+
+    // 参数按重启次数生成，录像等文件目标在重启后写入编号文件
+    typedef std::function<std::vector<std::string> (uint32_t restarts)> CommandBuilder;
+
+    bool launch(CommandBuilder builder, VideoCodec videoCodec, const std::vector<Output>& outputs = std::vector<Output>()) {
+        if (active) return true;
+        std::vector<std::string> command = builder(0);
+        {
+            std::lock_guard<std::mutex> lock(processMutex);
+            buildCommand = builder;
+            args = command;
+            multiOutputs = outputs;
+            codec = videoCodec;
+            restarts = 0;
+            lastExit = 0;
+            lastError.clear();
+        }
+        std::string cmd;
+        for (const auto& arg : command) cmd += (cmd.empty() ? "" : " ") + arg;
+        LOG_INFO("cmd: " << cmd);
+        // 第一次启动同步进行，ffmpeg 不存在等错误直接返回给调用方
+        if (!spawn()) {
+            LOG_ERROR(name << ": " << lastError);
+            return false;
+        }
+        written = 0;
+        dropped = 0;
+        aborted = 0;
+        active = true;
+        writing = true;
+        writer = std::thread(&FFmpegStreamer::writeLoop, this);
+        supervisor = std::thread(&FFmpegStreamer::supervise, this);
+        return true;
+    }
+
+    // fork/exec ffmpeg：标准输入写帧，标准输出读进度，标准错误读日志
+    bool spawn() {
+        std::vector<std::string> command;
+        {
+            std::lock_guard<std::mutex> lock(processMutex);
+            command = args;
+        }
+        // fork 之后子进程里不再分配内存
+        std::vector<char*> argv;
+        for (auto& arg : command) argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+
+        int in[2] = {-1, -1};
+        int out[2] = {-1, -1};
+        int err[2] = {-1, -1};
+        int status[2] = {-1, -1};
+        auto closeAll = [&]() {
+            for (int fd : {in[0], in[1], out[0], out[1], err[0], err[1], status[0], status[1]}) {
+                if (fd >= 0) close(fd);
+            }
+        };
+        if (pipe2(in, O_CLOEXEC) < 0 || pipe2(out, O_CLOEXEC) < 0 || pipe2(err, O_CLOEXEC) < 0
+            || pipe2(status, O_CLOEXEC) < 0) {
+            setError(std::string("pipe failed: ") + strerror(errno));
+            closeAll();
+            return false;
+        }
+        pid_t child = fork();
+        if (child < 0) {
+            setError(std::string("fork failed: ") + strerror(errno));
+            closeAll();
+            return false;
+        }
+        if (child == 0) {
+            dup2(in[0], STDIN_FILENO);
+            dup2(out[1], STDOUT_FILENO);
+            dup2(err[1], STDERR_FILENO);
+            // 本进程异常退出时不留下孤儿 ffmpeg
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            execvp(argv[0], argv.data());
+            int code = errno;
+            ssize_t ignored = write(status[1], &code, sizeof(code));
+            (void)ignored;
+            _exit(127);
+        }
+        close(in[0]);
+        close(out[1]);
+        close(err[1]);
+        close(status[1]);
+        // exec 成功时状态管道随 O_CLOEXEC 关闭，读到EOF
+        int code = 0;
+        ssize_t n;
+        do {
+            n = read(status[0], &code, sizeof(code));
+        } while (n < 0 && errno == EINTR);
+        close(status[0]);
+        if (n > 0) {
+            waitpid(child, nullptr, 0);
+            close(in[1]);
+            close(out[0]);
+            close(err[0]);
+            setError(std::string("exec ") + argv[0] + " failed: " + strerror(code));
+            return false;
+        }
+
+        fcntl(in[1], F_SETFL, fcntl(in[1], F_GETFL) | O_NONBLOCK);
+        // 超过 /proc/sys/fs/pipe-max-size 时失败，保持默认大小
+        if (fcntl(in[1], F_SETPIPE_SZ, PipeSize) < 0) {
+            LOG_DEBUG(name << ": F_SETPIPE_SZ " << PipeSize << " failed: " << strerror(errno));
+        }
+        pipeSize = fcntl(in[1], F_GETPIPE_SZ);
+        std::lock_guard<std::mutex> lock(processMutex);
+        childPid = child;
+        outFd = out[0];
+        errFd = err[0];
+        inPipe = std::make_shared<Pipe>(in[1]);
+        generation++;
+        startedAt = std::chrono::steady_clock::now();
+        progress = Progress();
+        outputFailed.clear();
+        cpuPercent = 0;
+        cpuSeconds = 0;
+        state = State::Starting;
+        upGauge.set(1);
+        return true;
+    }
+
+    void setError(const std::string& message) {
+        std::lock_guard<std::mutex> lock(processMutex);
+        lastError = message;
+    }
+
+    // 监护线程：看护当前进程，退出后按退避时间重启，直到 stop()
+    void supervise() {
+        int backoffMs = InitialBackoffMs;
+        for (;;) {
+            auto started = std::chrono::steady_clock::now();
+            if (childPid > 0) {
+                watch();
+                if (exitHandler) exitHandler(lastExit);
+            }
+            if (!active) break;
+
+            if (std::chrono::steady_clock::now() - started >= std::chrono::milliseconds(HealthyRunMs)) {
+                backoffMs = InitialBackoffMs;
+            }
+            {
+                std::unique_lock<std::mutex> lock(processMutex);
+                state = State::Backoff;
+                LOG_WARN(name << ": ffmpeg exited with " << lastExit << " (" << lastError << "), restarting in "
+                    << backoffMs << "ms");
+                backoffCv.wait_for(lock, std::chrono::milliseconds(backoffMs), [this]() { return !active; });
+                if (!active) break;
+                restarts++;
+                args = buildCommand(restarts);
+            }
+            restartsTotal.add();
+            backoffMs = std::min(backoffMs * 2, MaxBackoffMs);
+            if (!spawn()) {
+                LOG_ERROR(name << ": restart failed: " << lastError);
+            }
+        }
+        std::lock_guard<std::mutex> lock(processMutex);
+        state = State::Stopped;
+    }
+
+    // 读进度和错误输出直到进程退出，只在监护线程调用
+    void watch() {
+        std::string outLine;
+        std::string errLine;
+        Progress pending;
+        bool outOpen = true;
+        bool errOpen = true;
+        bool killed = false;
+        CpuSample lastCpu{std::chrono::steady_clock::now(), 0};
+        while (outOpen || errOpen) {
+            pollfd fds[2] = {{outOpen ? outFd : -1, POLLIN, 0}, {errOpen ? errFd : -1, POLLIN, 0}};
+            int ready = poll(fds, 2, 100);
+            if (ready < 0 && errno != EINTR) break;
+            if (std::chrono::steady_clock::now() - lastCpu.at >= std::chrono::seconds(1)) {
+                sampleCpu(lastCpu);
+            }
+            if (!killed && stopExpired()) {
+                // stop() 后 ffmpeg 迟迟不退出（如卡在网络写），强制结束
+                LOG_WARN(name << ": ffmpeg did not exit in " << StopTimeoutMs << "ms, killing");
+                kill(childPid, SIGKILL);
+                killed = true;
+            }
+            if (ready <= 0) continue;
+            if (outOpen && (fds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+                if (outputHandler) {
+                    outOpen = readOutput();
+                } else {
+                    outOpen = readLines(outFd, outLine, [&](const std::string& line) { parseProgress(line, pending); });
+                }
+            }
+            if (errOpen && (fds[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+                errOpen = readLines(errFd, errLine, [&](const std::string& line) {
+                    LOG_EVERY_MS(LogLevel::Warn, 2000, name << ": ffmpeg: " << line);
+                    setError(line);
+                    markFailedOutput(line);
+                });
+            }
+        }
+
+        // 输出都关闭后进程应已退出
+        int status = 0;
+        while (waitpid(childPid, &status, WNOHANG) == 0) {
+            if (!killed && stopExpired()) {
+                kill(childPid, SIGKILL);
+                killed = true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        close(outFd);
+        close(errFd);
+        std::lock_guard<std::mutex> lock(processMutex);
+        lastExit = WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+        childPid = -1;
+        outFd = -1;
+        errFd = -1;
+        inPipe.reset();
+        upGauge.set(0);
+        cpuGauge.set(0);
+    }
+
+    // tee 摘掉目标时输出 "Slave muxer #N failed: ..., continuing with x/y slaves."
+    void markFailedOutput(const std::string& line) {
+        static const std::string marker = "Slave muxer #";
+        size_t pos = line.find(marker);
+        if (pos == std::string::npos) return;
+        size_t index = strtoul(line.c_str() + pos + marker.size(), nullptr, 10);
+        std::lock_guard<std::mutex> lock(processMutex);
+        if (index >= outputFailed.size()) outputFailed.resize(index + 1, false);
+        outputFailed[index] = true;
+        LOG_WARN(name << ": output #" << index << " failed, other outputs continue");
+    }
+
+    struct CpuSample {
+        std::chrono::steady_clock::time_point at;
+        uint64_t ticks;             // utime + stime
+    };
+
+    // 读 /proc/<pid>/stat 的 utime、stime，换算为最近一个采样周期的CPU占用
+    void sampleCpu(CpuSample& last) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(childPid));
+        FILE* file = fopen(path, "r");
+        if (!file) return;
+        char buf[1024];
+        size_t n = fread(buf, 1, sizeof(buf) - 1, file);
+        fclose(file);
+        buf[n] = '\0';
+        // 进程名可能含空格和括号，从最后一个 ')' 之后开始数：state 是第3个字段，utime/stime 是第14、15个
+        const char* p = strrchr(buf, ')');
+        unsigned long long utime = 0;
+        unsigned long long stime = 0;
+        if (!p || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2) return;
+
+        static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+        auto now = std::chrono::steady_clock::now();
+        uint64_t ticks = utime + stime;
+        double elapsed = std::chrono::duration<double>(now - last.at).count();
+        double percent = elapsed > 0 ? (ticks - last.ticks) * 100.0 / ticksPerSecond / elapsed : 0;
+        last.at = now;
+        last.ticks = ticks;
+        cpuGauge.set(static_cast<int64_t>(percent * 10));
+        std::lock_guard<std::mutex> lock(processMutex);
+        cpuPercent = percent;
+        cpuSeconds = static_cast<double>(ticks) / ticksPerSecond;
+    }
+
+    bool stopExpired() {
+        std::lock_guard<std::mutex> lock(processMutex);
+        return !active && std::chrono::steady_clock::now() > stopDeadline;
+    }
+
+    // 读出可用数据并按行回调，EOF 返回 false
+    template <typename Callback>
+    static bool readLines(int fd, std::string& partial, Callback callback) {
+        char buf[4096];
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0) return errno == EINTR || errno == EAGAIN;
+        if (n == 0) return false;
+        partial.append(buf, n);
+        size_t start = 0;
+        size_t end;
+        while ((end = partial.find_first_of("\r\n", start)) != std::string::npos) {
+            if (end > start) callback(partial.substr(start, end - start));
+            start = end + 1;
+        }
+        partial.erase(0, start);
+        // 没有换行的超长输出不会是进度，防止无限增长
+        if (partial.size() > 4096) partial.clear();
+        return true;
+    }
+
+    // 把标准输出交给 outputHandler，EOF 或输出无法解析时返回 false；无法解析时结束进程，等它退出后重启
+    bool readOutput() {
+        char buf[64 * 1024];
+        ssize_t n = read(outFd, buf, sizeof(buf));
+        if (n < 0) return errno == EINTR || errno == EAGAIN;
+        if (n == 0) return false;
+        {
+            std::lock_guard<std::mutex> lock(processMutex);
+            if (state == State::Starting) state = State::Running;
+        }
+        if (outputHandler(buf, n)) return true;
+        setError("unparsable output on stdout");
+        LOG_ERROR(name << ": unparsable ffmpeg output, killing pid " << childPid);
+        kill(childPid, SIGKILL);
+        return false;
+    }
+
+    // -progress 输出 key=value，每组以 progress=continue/end 结束；N/A 解析为0
+    void parseProgress(const std::string& line, Progress& pending) {
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) return;
+        std::string key = line.substr(0, eq);
+        const char* value = line.c_str() + eq + 1;
+        if (key == "frame") pending.frame = strtoull(value, nullptr, 10);
+        else if (key == "fps") pending.fps = atof(value);
+        else if (key == "bitrate") pending.bitrateKbps = atof(value);      // 形如 2000.1kbits/s
+        else if (key == "speed") pending.speed = atof(value);              // 形如 1.01x
+        else if (key == "dup_frames") pending.dupFrames = strtoull(value, nullptr, 10);
+        else if (key == "drop_frames") pending.dropFrames = strtoull(value, nullptr, 10);
+        else if (key == "total_size") pending.totalSize = strtoull(value, nullptr, 10);
+        else if (key == "out_time_us") pending.outTimeUs = strtoll(value, nullptr, 10);
+        else if (key == "progress") {
+            bitrateGauge.set(static_cast<int64_t>(pending.bitrateKbps * 1000));
+            encoderDropGauge.set(static_cast<int64_t>(pending.dropFrames));
+            std::lock_guard<std::mutex> lock(processMutex);
+            progress = pending;
+            if (state == State::Starting) state = State::Running;
+        }
+    }
+
+    void writeLoop() {
+        Entry entry;
+        std::shared_ptr<Pipe> pipe;
+        uint64_t pipeGeneration = 0;
+        while (writing) {
+            if (!queue.pop(entry)) {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wakeCv.wait_for(lock, std::chrono::milliseconds(100), [this]() {
+                    return !writing || queue.size() > 0;
+                });
+                continue;
+            }
+            queueGauge.set(static_cast<int64_t>(queue.size()));
+            {
+                std::lock_guard<std::mutex> lock(processMutex);
+                if (generation != pipeGeneration) {
+                    // 新进程需要重新发送文件头
+                    pipe = inPipe;
+                    pipeGeneration = generation;
+                    muxer.reset();
+                }
+            }
+            if (!pipe) {
+                // ffmpeg 正在重启
+                dropped++;
+                droppedTotal.add();
+                continue;
+            }
+            auto start = std::chrono::steady_clock::now();
+            queueLatency.observe(start - entry.enqueued);
+            std::string header = muxer.frameHeader(entry.frame);
+            size_t sent = writeAll(pipe->fd, header.data(), header.size());
+            if (sent == header.size()) sent += writeAll(pipe->fd, entry.frame->data(), entry.frame->size);
+            sinkMetrics.addBytes(sent);
+            if (sent < header.size() + entry.frame->size) {
+                aborted++;
+                if (writing) {
+                    // ffmpeg 已退出，丢掉这个管道，等监护线程重启
+                    LOG_EVERY_MS(LogLevel::Warn, 5000, name << ": ffmpeg pipe closed: " << strerror(errno));
+                    pipe.reset();
+                }
+                continue;
+            }
+            writeLatency.observeSince(start);
+            sinkMetrics.observeWire(entry.frame->timestamp);
+            written++;
+            entry.frame.reset();
+        }
+        while (queue.pop(entry)) {}
+        queueGauge.set(0);
+    }
+
+    // 写完整一帧，管道满时等待可写；停止或管道断开时返回已写字节数
+    size_t writeAll(int fd, const char* data, size_t size) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = write(fd, data + done, size - done);
+            if (n > 0) {
+                done += n;
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && errno != EAGAIN) return done;
+            if (!writing) return done;
+            pollfd pfd{fd, POLLOUT, 0};
+            poll(&pfd, 1, 100);
+        }
+        return done;
+    }
+
+    std::string name;
+    size_t queueDepth;
+    FrameBus::DropPolicy dropPolicy;
+    FrameRing<Entry> queue;
+    MjpegMkvMuxer muxer;                    // 只在写线程使用
+    std::thread writer;
+    std::atomic<bool> writing{false};
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> aborted{0};
+    std::atomic<int> pipeSize{0};
+
+    // 进程状态，由 processMutex 保护；childPid/outFd/errFd 只在启动和监护线程中修改
+    std::mutex processMutex;
+    std::condition_variable backoffCv;
+    std::thread supervisor;
+    std::atomic<bool> active{false};
+    CommandBuilder buildCommand;
+    std::vector<std::string> args;
+    std::vector<Output> multiOutputs;
+    std::vector<bool> outputFailed;
+    OutputHandler outputHandler;            // 启动前设置、stop() 后清除，期间只在监护线程使用
+    ExitHandler exitHandler;
+    VideoCodec codec = VideoCodec::H264;
+    double cpuPercent = 0;
+    double cpuSeconds = 0;
+    pid_t childPid = -1;
+    int outFd = -1;
+    int errFd = -1;
+    std::shared_ptr<Pipe> inPipe;
+    uint64_t generation = 0;
+    State state = State::Stopped;
+    std::chrono::steady_clock::time_point startedAt;
+    std::chrono::steady_clock::time_point stopDeadline;
+    uint32_t restarts = 0;
+    int lastExit = 0;
+    std::string lastError;
+    Progress progress;
+
+    MetricHistogram& writeLatency;
+    MetricHistogram& queueLatency;
+    SinkMetrics sinkMetrics;
+    MetricCounter& droppedTotal;
+    MetricCounter& restartsTotal;
+    MetricGauge& queueGauge;
+    MetricGauge& upGauge;
+    MetricGauge& bitrateGauge;
+    MetricGauge& encoderDropGauge;
+    MetricGauge& cpuGauge;
+};
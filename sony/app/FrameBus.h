@@ -0,0 +1,285 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+#include "FramePool.h"
+#include "FrameRing.h"
+#include "Metrics.h"
+
+/**
+ * 预览帧分发总线
+ * 一次取帧可同时分发给任意数量的sink（局域网预览、RTMP推流、本地录像、分析等），
+ * 每个sink有独立的队列深度、丢帧策略、帧率上限和工作线程，互不阻塞。
+ */
+class FrameBus {
+public:
+    enum class DropPolicy {
+        DropOldest,     // 队列满时丢弃最旧的帧（预览、推流）
+        DropNewest      // 队列满时丢弃新到的帧（需要连续帧的分析）
+    };
+
+    struct SinkOptions {
+        size_t queueDepth;
+        DropPolicy dropPolicy;
+        double maxFps;      // 0 表示不限制
+        bool resident;      // 常驻sink（快照等），不计入 subscriberCount()，不会让流水线保持运行
+        SinkMetrics* metrics = nullptr;     // sink自己的输出指标，由总线按相机编号绑定，须比订阅活得久
+
+        SinkOptions(size_t queueDepth = 4, DropPolicy dropPolicy = DropPolicy::DropOldest, double maxFps = 0,
+                    bool resident = false, SinkMetrics* metrics = nullptr)
+            : queueDepth(queueDepth), dropPolicy(dropPolicy), maxFps(maxFps), resident(resident), metrics(metrics) {}
+    };
+
+    struct SinkStats {
+        std::string name;
+        uint64_t received = 0;      // 总线发布给该sink的帧数
+        uint64_t delivered = 0;     // 已交给sink处理的帧数
+        uint64_t dropped = 0;       // 队列满丢弃的帧数
+        uint64_t throttled = 0;     // 超过帧率上限跳过的帧数
+        uint32_t queued = 0;        // 当前排队帧数
+    };
+
+    typedef std::function<void (const FramePtr&)> Handler;
+    typedef uint64_t SubscriptionId;
+
+    FrameBus() : sinks(std::make_shared<SinkList>()) {}
+    ~FrameBus() { clear(); }
+
+    FrameBus(const FrameBus&) = delete;
+    FrameBus& operator=(const FrameBus&) = delete;
+
+    /**
+     * 订阅预览帧
+     * handler 在该sink自己的线程中调用，不能在 handler 内取消自身订阅
+     * @return 订阅ID，用于取消订阅
+     */
+    SubscriptionId subscribe(const std::string& name, Handler handler, const SinkOptions& options = SinkOptions()) {
+        auto sink = std::make_shared<Sink>(name, handler, options);
+        sink->id = ++lastId;
+        sink->running = true;
+        sink->worker = std::thread(&Sink::run, sink.get());
+        std::lock_guard<std::mutex> lock(mutex);
+        if (camera >= 0) sink->bindMetrics(camera);
+        auto next = std::make_shared<SinkList>(*sinks);
+        next->push_back(sink);
+        sinks = next;
+        return sink->id;
+    }
+
+    void unsubscribe(SubscriptionId id) {
+        std::shared_ptr<Sink> removed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto next = std::make_shared<SinkList>();
+            for (auto& sink : *sinks) {
+                if (sink->id == id) {
+                    removed = sink;
+                } else {
+                    next->push_back(sink);
+                }
+            }
+            sinks = next;
+        }
+        if (removed) removed->stop();
+    }
+
+    void clear() {
+        std::shared_ptr<SinkList> old;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            old = sinks;
+            sinks = std::make_shared<SinkList>();
+        }
+        for (auto& sink : *old) sink->stop();
+    }
+
+    /**
+     * 按相机编号给各sink的指标打 camera 标签，之后订阅的sink也使用该编号
+     * 取帧开始前调用，未绑定时sink不记录指标
+     */
+    void bindCamera(int cameraId) {
+        std::shared_ptr<SinkList> current;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            camera = cameraId;
+            current = sinks;
+        }
+        for (auto& sink : *current) sink->bindMetrics(cameraId);
+    }
+
+    // 发布一帧，采集线程调用，不会阻塞
+    void publish(const FramePtr& frame) {
+        auto current = snapshot();
+        auto now = std::chrono::steady_clock::now();
+        for (auto& sink : *current) {
+            sink->offer(frame, now);
+        }
+    }
+
+    // 非常驻sink的数量，为0时表示没有输出需要取帧
+    size_t subscriberCount() const {
+        size_t count = 0;
+        for (auto& sink : *snapshot()) {
+            if (!sink->options.resident) count++;
+        }
+        return count;
+    }
+
+    std::vector<SinkStats> stats() const {
+        std::vector<SinkStats> ret;
+        for (auto& sink : *snapshot()) {
+            SinkStats s;
+            s.name = sink->name;
+            s.received = sink->received;
+            s.delivered = sink->delivered;
+            s.dropped = sink->dropped;
+            s.throttled = sink->throttled;
+            s.queued = static_cast<uint32_t>(sink->ring.size());
+            ret.push_back(s);
+        }
+        return ret;
+    }
+
+private:
+    // 队列中的帧及其入队时刻
+    struct Entry {
+        FramePtr frame;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    struct Sink {
+        SubscriptionId id = 0;
+        std::string name;
+        Handler handler;
+        SinkOptions options;
+        FrameRing<Entry> ring;
+        std::atomic<bool> running{false};
+        std::thread worker;
+        std::mutex wakeMutex;
+        std::condition_variable wakeCv;
+        std::chrono::steady_clock::time_point lastOffered;
+        double credit = 0;
+        std::atomic<uint64_t> received{0};
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> throttled{0};
+        // 按 {camera, sink} 打标签，bindMetrics 之前为空
+        std::atomic<MetricHistogram*> queueLatency{nullptr};     // 入队到开始处理
+        std::atomic<MetricHistogram*> handlerLatency{nullptr};   // handler 执行耗时
+        std::atomic<MetricCounter*> deliveredTotal{nullptr};
+        std::atomic<MetricCounter*> droppedTotal{nullptr};
+
+        Sink(const std::string& name, Handler handler, const SinkOptions& options)
+            : name(name), handler(handler), options(options), ring(options.queueDepth) {
+            if (this->options.queueDepth < 1) this->options.queueDepth = 1;
+        }
+
+        void bindMetrics(int camera) {
+            Metrics& metrics = Metrics::instance();
+            Metrics::Labels labels = {{"camera", std::to_string(camera)}, {"sink", name}};
+            queueLatency = &metrics.histogram("live_sink_queue_seconds",
+                "Time a frame waits in a sink queue before its handler runs", labels);
+            handlerLatency = &metrics.histogram("live_sink_handler_seconds",
+                "Sink handler duration per frame", labels);
+            deliveredTotal = &metrics.counter("live_sink_frames_total",
+                "Frames handed to a sink handler", labels);
+            droppedTotal = &metrics.counter("live_sink_dropped_total",
+                "Frames dropped because a sink queue was full", labels);
+            if (options.metrics) options.metrics->bind(camera);
+        }
+
+        void countDropped(size_t n) {
+            dropped += n;
+            MetricCounter* counter = droppedTotal.load();
+            if (counter) counter->add(n);
+        }
+
+        void offer(const FramePtr& frame, std::chrono::steady_clock::time_point now) {
+            received++;
+            if (options.maxFps > 0) {
+                // 令牌桶限速：按时间累积额度，相机帧率略高于上限时只跳过多出的帧
+                if (lastOffered.time_since_epoch().count() == 0) {
+                    credit = 1.0;
+                } else {
+                    credit += std::chrono::duration<double>(now - lastOffered).count() * options.maxFps;
+                    // 桶容量为2帧，容量为1时相机帧率略高于上限会被减半
+                    if (credit > 2.0) credit = 2.0;
+                }
+                lastOffered = now;
+                if (credit < 1.0) {
+                    throttled++;
+                    return;
+                }
+                credit -= 1.0;
+            }
+            size_t lost = 0;
+            if (ring.size() >= options.queueDepth) {
+                if (options.dropPolicy == DropPolicy::DropNewest) {
+                    countDropped(1);
+                    return;
+                }
+                Entry oldest;
+                if (ring.pop(oldest)) lost++;
+            }
+            lost += ring.push(Entry{frame, now});
+            if (lost > 0) countDropped(lost);
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+            }
+            wakeCv.notify_one();
+        }
+
+        void run() {
+            Entry entry;
+            while (running) {
+                if (!ring.pop(entry)) {
+                    std::unique_lock<std::mutex> lock(wakeMutex);
+                    wakeCv.wait_for(lock, std::chrono::milliseconds(100), [this]() {
+                        return !running || ring.size() > 0;
+                    });
+                    continue;
+                }
+                auto start = std::chrono::steady_clock::now();
+                MetricHistogram* queued = queueLatency.load();
+                if (queued) queued->observe(start - entry.enqueued);
+                handler(entry.frame);
+                MetricHistogram* handled = handlerLatency.load();
+                if (handled) handled->observeSince(start);
+                entry.frame.reset();
+                delivered++;
+                MetricCounter* counter = deliveredTotal.load();
+                if (counter) counter->add();
+            }
+            while (ring.pop(entry)) {}
+        }
+
+        void stop() {
+            running = false;
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+            }
+            wakeCv.notify_all();
+            if (worker.joinable()) worker.join();
+        }
+    };
+
+    typedef std::vector<std::shared_ptr<Sink>> SinkList;
+
+    std::shared_ptr<const SinkList> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sinks;
+    }
+
+    mutable std::mutex mutex;
+    std::shared_ptr<SinkList> sinks;
+    int camera = -1;                        // 指标的 camera 标签，由 mutex 保护
+    std::atomic<SubscriptionId> lastId{0};
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <chrono>
+
+/**
+ * 一帧图像数据
+ * 由 FramePool 分配，最后一个 FramePtr 释放时缓冲区自动归还到池中
+ */
+struct LiveFrame {
+    std::unique_ptr<uint8_t[]> buffer;
+    uint32_t capacity = 0;      // 缓冲区大小
+    uint32_t offset = 0;        // 图像数据在缓冲区中的偏移（SDK返回的图像不一定从头开始）
+    uint32_t size = 0;          // 图像数据长度
+    uint32_t frameNo = 0;       // 相机帧序号
+    std::chrono::steady_clock::time_point fetchStart;   // 调用 GetLiveViewImage 的时刻
+    std::chrono::steady_clock::time_point timestamp;    // GetLiveViewImage 返回的时刻
+
+    uint8_t* raw() { return buffer.get(); }
+    const char* data() const { return reinterpret_cast<const char*>(buffer.get() + offset); }
+    bool empty() const { return size == 0; }
+};
+
+typedef std::shared_ptr<LiveFrame> FramePtr;
+
+/**
+ * 帧缓冲池
+ * 按 GetLiveViewImageInfo::GetBufferSize() 的大小复用缓冲区，避免每帧申请/释放大块内存。
+ * 返回的 FramePtr 可被多个sink同时持有，无需拷贝。
+ */
+class FramePool {
+public:
+    struct Stats {
+        uint64_t hits = 0;          // 从池中直接取到缓冲区
+        uint64_t misses = 0;        // 池为空或尺寸变化，重新分配
+        uint32_t inUse = 0;         // 当前被持有的帧数
+        uint32_t highWater = 0;     // 同时被持有的最大帧数
+        uint32_t pooled = 0;        // 池中空闲缓冲区数
+        uint32_t bufferSize = 0;    // 当前缓冲区大小
+    };
+
+    explicit FramePool(size_t maxPooled = 8) : state(std::make_shared<State>()) {
+        state->maxPooled = maxPooled;
+    }
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * 获取一个至少 bufferSize 字节的帧缓冲
+     * 缓冲区尺寸变化时丢弃池中旧尺寸的缓冲区
+     */
+    FramePtr acquire(uint32_t bufferSize) {
+        LiveFrame* frame = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (bufferSize != state->stats.bufferSize) {
+                state->free.clear();
+                state->stats.bufferSize = bufferSize;
+            }
+            if (!state->free.empty()) {
+                frame = state->free.back().release();
+                state->free.pop_back();
+                state->stats.hits++;
+            } else {
+                state->stats.misses++;
+            }
+            state->stats.inUse++;
+            if (state->stats.inUse > state->stats.highWater) {
+                state->stats.highWater = state->stats.inUse;
+            }
+        }
+        if (!frame) {
+            frame = new LiveFrame();
+            frame->buffer.reset(new uint8_t[bufferSize]);
+            frame->capacity = bufferSize;
+        }
+        frame->offset = 0;
+        frame->size = 0;
+        frame->frameNo = 0;
+        frame->fetchStart = std::chrono::steady_clock::time_point();
+        frame->timestamp = std::chrono::steady_clock::time_point();
+
+        std::weak_ptr<State> weak = state;
+        return FramePtr(frame, [weak](LiveFrame* f) {
+            if (auto s = weak.lock()) {
+                s->recycle(f);
+            } else {
+                delete f;
+            }
+        });
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        Stats ret = state->stats;
+        ret.pooled = static_cast<uint32_t>(state->free.size());
+        return ret;
+    }
+
+private:
+    struct State {
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<LiveFrame>> free;
+        size_t maxPooled = 8;
+        Stats stats;
+
+        void recycle(LiveFrame* f) {
+            std::unique_ptr<LiveFrame> holder(f);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stats.inUse > 0) stats.inUse--;
+            // 尺寸已变化或池已满的缓冲区直接释放
+            if (f->capacity == stats.bufferSize && free.size() < maxPooled) {
+                free.push_back(std::move(holder));
+            }
+        }
+    };
+
+    std::shared_ptr<State> state;
+};
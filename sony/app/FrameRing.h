@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/**
+ * 有界无锁帧环形队列
+ * 单生产者写入，队列满时生产者回收最旧的一帧（drop-oldest），保证写入永不阻塞。
+ * 基于序号槽位实现（Vyukov bounded queue），生产者回收旧帧时与消费者并发安全。
+ */
+template <typename T>
+class FrameRing {
+public:
+    explicit FrameRing(size_t capacity) {
+        size_t n = 2;
+        while (n < capacity) n <<= 1;
+        mask = n - 1;
+        cells.reset(new Cell[n]);
+        for (size_t i = 0; i < n; ++i) {
+            cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    /**
+     * 写入一帧
+     * @return 为腾出空间而丢弃的旧帧数量
+     */
+    size_t push(T value) {
+        size_t dropped = 0;
+        while (!tryPush(value)) {
+            T oldest;
+            if (pop(oldest)) {
+                dropped++;
+            } else {
+                // 消费者正在取走最旧的槽位
+                std::this_thread::yield();
+            }
+        }
+        return dropped;
+    }
+
+    bool pop(T& out) {
+        Cell* cell;
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(cell->value);
+        cell->value = T();
+        cell->seq.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        size_t tail = enqueuePos.load(std::memory_order_acquire);
+        size_t head = dequeuePos.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    bool tryPush(T& value) {
+        Cell* cell;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+};
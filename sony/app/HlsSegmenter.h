@@ -0,0 +1,622 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include "FramePool.h"
+#include "FFmpegStreamer.h"
+#include "Logger.h"
+#include "Metrics.h"
+
+/**
+ * 内存 LL-HLS 切片
+ * ffmpeg 把预览JPEG编码为 H.264，以分片 MP4（fMP4）写到标准输出，不落盘：
+ *   ftyp+moov 作为初始化段，每个 moof+mdat 是一个部分切片（part，约200ms），
+ *   以关键帧开头的 part 开始一个新切片（segment，一个GOP）。
+ * 输入帧带采集时间戳、帧率不固定，关键帧按时间戳每 segmentMs 强制插入，切片时长不随帧率变化。
+ * 切片、部分切片和播放列表都只保存在内存环形队列里，由 drogon 按 LL-HLS 提供，
+ * 支持阻塞式播放列表刷新（_HLS_msn/_HLS_part）和预加载提示（PRELOAD-HINT）。
+ *
+ * ffmpeg 由 FFmpegStreamer 写入和看护：帧以 Matroska 带采集时间戳写入，进程退出或输出无法解析时
+ * 未完成的切片就此结束、所有等待以失败结束，再按退避时间重启。每个 ffmpeg 进程是一代，
+ * 有自己的初始化段 init<代>.mp4，切片序号跨代继续递增，播放列表在代之间插入 EXT-X-DISCONTINUITY。
+ */
+class HlsSegmenter {
+public:
+    struct Config {
+        int framerate = 25;
+        int bitrate = 2000;         // kbps
+        int partMs = 200;           // 部分切片时长
+        int segmentMs = 1000;       // 切片时长，按时间戳强制关键帧的间隔
+        size_t maxSegments = 6;     // 内存中保留的完整切片数
+    };
+
+    struct Stats {
+        bool running = false;
+        uint64_t firstMsn = 0;
+        uint64_t lastMsn = 0;       // 当前（未完成）切片序号
+        size_t segments = 0;
+        uint64_t parts = 0;         // 累计生成的部分切片数
+        uint64_t bytes = 0;         // 累计收到的 fMP4 字节数
+        size_t memory = 0;          // 环形队列当前占用
+        size_t waiters = 0;
+        uint32_t restarts = 0;      // ffmpeg 重启次数
+        uint64_t dropped = 0;       // 写入 ffmpeg 前丢弃的帧数
+        std::string lastError;
+    };
+
+    typedef std::shared_ptr<const std::string> Blob;
+    // 等待的切片/部分切片就绪时调用；ok 为 false 表示分段器已停止
+    typedef std::function<void (bool ok)> Waiter;
+    typedef uint64_t WaiterId;
+
+    ~HlsSegmenter() { stop(); }
+
+    bool start(const Config& cfg) {
+        if (encoder.isRunning()) return true;
+        char keyframes[64];
+        snprintf(keyframes, sizeof(keyframes), "expr:gte(t,n_forced*%.3f)", cfg.segmentMs / 1000.0);
+        // 按帧数的GOP只作上限，防止时间戳异常时长时间没有关键帧
+        int maxGop = std::max(1, cfg.framerate * cfg.segmentMs / 1000) * 2;
+        std::vector<std::string> args = {
+            "-c:v", "libx264", "-preset", "ultrafast", "-tune", "zerolatency",
+            "-b:v", std::to_string(cfg.bitrate) + "k",
+            "-maxrate", std::to_string(cfg.bitrate) + "k",
+            "-bufsize", std::to_string(cfg.bitrate) + "k",
+            // 时间戳每越过一个切片时长强制一个关键帧，每个切片以关键帧开头
+            "-force_key_frames", keyframes, "-g", std::to_string(maxGop), "-sc_threshold", "0", "-bf", "0",
+            "-pix_fmt", "yuv420p",
+            "-f", "mp4", "-movflags", "empty_moov+default_base_moof+frag_keyframe",
+            "-frag_duration", std::to_string(cfg.partMs * 1000),
+            "pipe:1"
+        };
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            config = cfg;
+            resetLocked();
+            running = true;
+        }
+        resetParser();
+        if (!encoder.startPiped(args, [this](const char* data, size_t size) { return consume(data, size); },
+                                [this](int exitCode) { onEncoderExit(exitCode); })) {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+            return false;
+        }
+        LOG_INFO("hls segmenter start, keyframe every " << cfg.segmentMs << "ms, part " << cfg.partMs << "ms");
+        return true;
+    }
+
+    // 已开启，ffmpeg 重启期间也为 true
+    bool isEnabled() const {
+        return encoder.isRunning();
+    }
+
+    // 正在编码，ffmpeg 重启期间为 false
+    bool isRunning() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return running;
+    }
+
+    // 总线sink线程调用，只入队，由 FFmpegStreamer 的写线程写入 ffmpeg
+    void pushFrame(const FramePtr& frame) {
+        encoder.pushFrame(frame);
+    }
+
+    void stop() {
+        if (!encoder.isRunning()) return;
+        // 退出回调让所有等待以失败结束
+        encoder.stop();
+        failWaiters();
+        LOG_INFO("hls segmenter stop");
+    }
+
+    // 第 generation 代的初始化段，已淘汰返回空
+    Blob init(uint32_t generation) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = initSegments.find(generation);
+        return it != initSegments.end() ? it->second : Blob();
+    }
+
+    // 完整切片，未完成或已淘汰返回空
+    Blob segment(uint64_t msn) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const Segment* seg = findSegment(msn);
+        return seg && seg->complete ? seg->data : Blob();
+    }
+
+    Blob part(uint64_t msn, size_t index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const Segment* seg = findSegment(msn);
+        if (!seg || index >= seg->parts.size()) return Blob();
+        return seg->parts[index].data;
+    }
+
+    /**
+     * 阻塞式刷新：等待切片 msn（part 为 -1）完成，或它的第 part 个部分切片生成
+     * 已就绪时立即在当前线程调用 waiter(true) 并返回0；
+     * 请求的切片超出当前切片的下一个，或分段器未运行时，置 invalid 并返回0，不调用 waiter，调用方应答 400
+     * 否则登记等待并返回等待ID，waiter 在读线程中调用
+     */
+    WaiterId wait(uint64_t msn, int part, Waiter waiter, bool& invalid) {
+        invalid = false;
+        bool ready = false;
+        WaiterId id = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running) {
+                invalid = true;
+                return 0;
+            }
+            uint64_t current = segments.empty() ? nextMsn : segments.back().msn;
+            if (msn > current + 1) {
+                invalid = true;
+                return 0;
+            }
+            ready = reachedLocked(msn, part);
+            if (!ready) {
+                id = ++lastWaiterId;
+                waiters[id] = PendingWait{msn, part, waiter};
+                waitersGauge.set(waiters.size());
+            }
+        }
+        if (ready) waiter(true);
+        return id;
+    }
+
+    /**
+     * 取消等待（超时）
+     * @return true 表示等待仍未完成且已取消，调用方负责应答
+     */
+    bool cancel(WaiterId id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        bool removed = waiters.erase(id) > 0;
+        waitersGauge.set(waiters.size());
+        return removed;
+    }
+
+    // LL-HLS 播放列表，URI 相对于播放列表所在目录
+    std::string playlist() {
+        std::lock_guard<std::mutex> lock(mutex);
+        char buf[256];
+        std::string m3u8 = "#EXTM3U\n#EXT-X-VERSION:9\n";
+        int target = static_cast<int>(std::ceil(config.segmentMs / 1000.0)) + 1;
+        double partTarget = config.partMs / 1000.0;
+        snprintf(buf, sizeof(buf), "#EXT-X-TARGETDURATION:%d\n#EXT-X-PART-INF:PART-TARGET=%.3f\n"
+                 "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=%.3f\n",
+                 target, partTarget, partTarget * 3);
+        m3u8 += buf;
+        if (segments.empty()) return m3u8;
+        snprintf(buf, sizeof(buf), "#EXT-X-MEDIA-SEQUENCE:%llu\n#EXT-X-DISCONTINUITY-SEQUENCE:%llu\n",
+                 static_cast<unsigned long long>(segments.front().msn),
+                 static_cast<unsigned long long>(discontinuitySequence));
+        m3u8 += buf;
+
+        // 最近三个切片列出部分切片，更早的只列完整切片
+        size_t partsFrom = segments.size() > 3 ? segments.size() - 3 : 0;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            const Segment& seg = segments[i];
+            // ffmpeg 重启后时间戳和编码参数都可能变化，换代处标记不连续并引用新的初始化段
+            if (i == 0 || seg.generation != segments[i - 1].generation) {
+                if (i > 0) m3u8 += "#EXT-X-DISCONTINUITY\n";
+                snprintf(buf, sizeof(buf), "#EXT-X-MAP:URI=\"init%u.mp4\"\n", seg.generation);
+                m3u8 += buf;
+                m3u8 += "#EXT-X-PROGRAM-DATE-TIME:" + isoTime(seg.start) + "\n";
+            }
+            if (i >= partsFrom) {
+                for (size_t p = 0; p < seg.parts.size(); ++p) {
+                    snprintf(buf, sizeof(buf), "#EXT-X-PART:DURATION=%.3f,URI=\"part%llu.%zu.m4s\"%s\n",
+                             seg.parts[p].duration, static_cast<unsigned long long>(seg.msn), p,
+                             seg.parts[p].independent ? ",INDEPENDENT=YES" : "");
+                    m3u8 += buf;
+                }
+            }
+            if (seg.complete) {
+                snprintf(buf, sizeof(buf), "#EXTINF:%.3f,\nseg%llu.m4s\n", seg.duration,
+                         static_cast<unsigned long long>(seg.msn));
+                m3u8 += buf;
+            }
+        }
+        // 下一个部分切片的预加载提示，播放器提前发起请求，服务端在它生成后立即应答
+        const Segment& last = segments.back();
+        bool nextSegment = last.complete || startsSegmentLocked(last);
+        uint64_t hintMsn = nextSegment ? last.msn + 1 : last.msn;
+        size_t hintPart = nextSegment ? 0 : last.parts.size();
+        snprintf(buf, sizeof(buf), "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"part%llu.%zu.m4s\"\n",
+                 static_cast<unsigned long long>(hintMsn), hintPart);
+        m3u8 += buf;
+        return m3u8;
+    }
+
+    SinkMetrics& metrics() { return encoder.metrics(); }
+
+    Stats stats() {
+        Stats s;
+        FFmpegStreamer::Stats encoderStats = encoder.stats();
+        s.restarts = encoderStats.restarts;
+        s.dropped = encoderStats.dropped;
+        s.lastError = encoderStats.lastError;
+        std::lock_guard<std::mutex> lock(mutex);
+        s.running = running;
+        s.segments = segments.size();
+        if (!segments.empty()) {
+            s.firstMsn = segments.front().msn;
+            s.lastMsn = segments.back().msn;
+        }
+        s.parts = partCount;
+        s.bytes = byteCount;
+        s.memory = 0;
+        for (const auto& item : initSegments) s.memory += item.second->size();
+        for (const auto& seg : segments) {
+            for (const auto& part : seg.parts) s.memory += part.data->size();
+            if (seg.data) s.memory += seg.data->size();
+        }
+        s.waiters = waiters.size();
+        return s;
+    }
+
+private:
+    struct Part {
+        Blob data;                  // moof + mdat
+        double start = 0;           // 第一个样本的解码时间（秒，tfdt），每个 ffmpeg 进程从0开始
+        double duration = 0;
+        bool independent = false;   // 以关键帧开头
+    };
+
+    struct Segment {
+        uint64_t msn = 0;
+        uint32_t generation = 0;    // 生成该切片的 ffmpeg 进程代数，对应 init<代>.mp4
+        double mediaStart = 0;      // 第一个部分切片的 start
+        std::vector<Part> parts;
+        double duration = 0;
+        bool complete = false;
+        Blob data;                  // 完成后拼接所有部分切片
+        std::chrono::system_clock::time_point start;
+    };
+
+    struct PendingWait {
+        uint64_t msn;
+        int part;
+        Waiter callback;
+    };
+
+    static std::string isoTime(std::chrono::system_clock::time_point t) {
+        time_t seconds = std::chrono::system_clock::to_time_t(t);
+        int ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count() % 1000);
+        struct tm tmUtc;
+        gmtime_r(&seconds, &tmUtc);
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", tmUtc.tm_year + 1900, tmUtc.tm_mon + 1,
+                 tmUtc.tm_mday, tmUtc.tm_hour, tmUtc.tm_min, tmUtc.tm_sec, ms);
+        return buf;
+    }
+
+    static uint32_t be32(const uint8_t* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+    }
+
+    static uint64_t be64(const uint8_t* p) {
+        return (uint64_t(be32(p)) << 32) | be32(p + 4);
+    }
+
+    // 在 [p, end) 中查找类型为 type 的子盒子，返回盒子内容区间
+    static bool findBox(const uint8_t* p, const uint8_t* end, const char* type, const uint8_t*& body, const uint8_t*& bodyEnd) {
+        while (p + 8 <= end) {
+            uint64_t size = be32(p);
+            size_t header = 8;
+            if (size == 1) {
+                if (p + 16 > end) return false;
+                size = be64(p + 8);
+                header = 16;
+            } else if (size == 0) {
+                size = end - p;
+            }
+            if (size < header || p + size > end) return false;
+            if (memcmp(p + 4, type, 4) == 0) {
+                body = p + header;
+                bodyEnd = p + size;
+                return true;
+            }
+            p += size;
+        }
+        return false;
+    }
+
+    static bool findPath(const std::string& data, const std::vector<const char*>& path, const uint8_t*& body, const uint8_t*& bodyEnd) {
+        body = reinterpret_cast<const uint8_t*>(data.data());
+        bodyEnd = body + data.size();
+        for (const char* type : path) {
+            if (!findBox(body, bodyEnd, type, body, bodyEnd)) return false;
+        }
+        return true;
+    }
+
+    // 从初始化段取时间刻度和 trex 默认值，需持有 mutex
+    void parseInit(const std::string& data) {
+        const uint8_t* body;
+        const uint8_t* end;
+        if (findPath(data, {"moov", "trak", "mdia", "mdhd"}, body, end) && end - body >= 24) {
+            timescale = body[0] == 1 ? be32(body + 20) : be32(body + 12);
+        }
+        if (findPath(data, {"moov", "mvex", "trex"}, body, end) && end - body >= 24) {
+            defaultDuration = be32(body + 12);
+            defaultFlags = be32(body + 20);
+        }
+    }
+
+    // 解析 moof：时长（秒）和第一个样本是否为同步样本，需持有 mutex
+    void parseFragment(const std::string& moof, Part& part) {
+        const uint8_t* traf;
+        const uint8_t* trafEnd;
+        if (!findPath(moof, {"moof", "traf"}, traf, trafEnd)) return;
+        uint32_t sampleDuration = defaultDuration;
+        uint32_t sampleFlags = defaultFlags;
+        const uint8_t* body;
+        const uint8_t* end;
+        if (findBox(traf, trafEnd, "tfhd", body, end) && end - body >= 8) {
+            uint32_t flags = be32(body) & 0xFFFFFF;
+            const uint8_t* p = body + 8;
+            if (flags & 0x01) p += 8;
+            if (flags & 0x02) p += 4;
+            if (flags & 0x08) { if (p + 4 <= end) sampleDuration = be32(p); p += 4; }
+            if (flags & 0x10) p += 4;
+            if ((flags & 0x20) && p + 4 <= end) sampleFlags = be32(p);
+        }
+        if (findBox(traf, trafEnd, "tfdt", body, end) && end - body >= 8 && timescale > 0) {
+            uint64_t decodeTime = body[0] == 1 ? (end - body >= 12 ? be64(body + 4) : 0) : be32(body + 4);
+            part.start = static_cast<double>(decodeTime) / timescale;
+        }
+        if (!findBox(traf, trafEnd, "trun", body, end) || end - body < 8) return;
+        uint32_t flags = be32(body) & 0xFFFFFF;
+        uint32_t count = be32(body + 4);
+        const uint8_t* p = body + 8;
+        if (flags & 0x01) p += 4;
+        uint32_t firstFlags = sampleFlags;
+        if (flags & 0x04) {
+            if (p + 4 > end) return;
+            firstFlags = be32(p);
+            p += 4;
+        }
+        size_t fieldSize = 4 * (((flags & 0x100) ? 1 : 0) + ((flags & 0x200) ? 1 : 0)
+                                + ((flags & 0x400) ? 1 : 0) + ((flags & 0x800) ? 1 : 0));
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (fieldSize > 0 && p + fieldSize > end) break;
+            const uint8_t* f = p;
+            uint32_t duration = sampleDuration;
+            if (flags & 0x100) { duration = be32(f); f += 4; }
+            if (flags & 0x200) f += 4;
+            if ((flags & 0x400) && i == 0 && !(flags & 0x04)) firstFlags = be32(f);
+            total += duration;
+            p += fieldSize;
+        }
+        // sample_is_non_sync_sample
+        part.independent = (firstFlags & 0x10000) == 0;
+        if (timescale > 0) part.duration = static_cast<double>(total) / timescale;
+    }
+
+    // 需持有 mutex
+    const Segment* findSegment(uint64_t msn) const {
+        if (segments.empty() || msn < segments.front().msn || msn > segments.back().msn) return nullptr;
+        return &segments[msn - segments.front().msn];
+    }
+
+    /**
+     * 当前切片之后的下一个部分切片是否以关键帧开头、开始新切片；需持有 mutex
+     * ffmpeg 在时间戳首次越过切片时长整数倍的帧上强制关键帧，切片从第 n 个边界开始时，
+     * 下一个部分切片的开始时刻（最后一个部分切片的 start + duration）越过第 n+1 个边界即为新切片
+     */
+    bool startsSegmentLocked(const Segment& seg) const {
+        if (seg.parts.empty()) return false;
+        double segmentSeconds = config.segmentMs / 1000.0;
+        double boundary = (std::floor(seg.mediaStart / segmentSeconds + 1e-6) + 1) * segmentSeconds;
+        const Part& tail = seg.parts.back();
+        // 时间刻度换算的舍入误差
+        return tail.start + tail.duration + 1e-3 >= boundary;
+    }
+
+    // 需持有 mutex
+    bool reachedLocked(uint64_t msn, int part) const {
+        if (segments.empty()) return false;
+        const Segment& last = segments.back();
+        if (msn < last.msn) return true;
+        if (msn > last.msn) return false;
+        if (last.complete) return true;
+        return part >= 0 && static_cast<size_t>(part) < last.parts.size();
+    }
+
+    // 监护线程调用：按顶层盒子切分 ffmpeg 输出，盒子长度非法时返回 false
+    bool consume(const char* data, size_t size) {
+        pendingBytes.append(data, size);
+        size_t pos = 0;
+        while (pendingBytes.size() - pos >= 8) {
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(pendingBytes.data() + pos);
+            uint64_t boxSize = be32(p);
+            if (boxSize == 1) {
+                if (pendingBytes.size() - pos < 16) break;
+                boxSize = be64(p + 8);
+            }
+            if (boxSize < 8) {
+                LOG_ERROR("hls: bad mp4 box from ffmpeg");
+                return false;
+            }
+            if (pendingBytes.size() - pos < boxSize) break;
+            std::string type(reinterpret_cast<const char*>(p + 4), 4);
+            std::string box = pendingBytes.substr(pos, boxSize);
+            pos += boxSize;
+            if (type == "moof") {
+                pendingMoof.swap(box);
+            } else if (type == "mdat") {
+                if (!pendingMoof.empty()) addPart(pendingMoof + box);
+                pendingMoof.clear();
+            } else if (type == "ftyp") {
+                pendingInit = box;
+            } else if (type == "moov") {
+                pendingInit += box;
+                std::lock_guard<std::mutex> lock(mutex);
+                generation++;
+                initSegments[generation] = std::make_shared<const std::string>(pendingInit);
+                parseInit(pendingInit);
+                running = true;
+            }
+            // 其他顶层盒子（mfra 等）忽略
+        }
+        pendingBytes.erase(0, pos);
+        return true;
+    }
+
+    // 监护线程调用：当前切片就此结束，已完成的切片继续保留，新进程的切片从下一代开始；等待以失败结束
+    void onEncoderExit(int exitCode) {
+        LOG_WARN("hls: ffmpeg exited with " << exitCode << ", closing generation " << generation);
+        resetParser();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!segments.empty()) {
+                Segment& last = segments.back();
+                if (last.parts.empty()) {
+                    segments.pop_back();
+                } else if (!last.complete) {
+                    completeLocked(last);
+                }
+            }
+            if (!segments.empty()) nextMsn = segments.back().msn + 1;
+            running = false;
+        }
+        failWaiters();
+    }
+
+    void resetParser() {
+        pendingBytes.clear();
+        pendingInit.clear();
+        pendingMoof.clear();
+    }
+
+    // 重新开启时丢弃上次的切片，序号和代数继续递增，播放器不会把新切片当成旧切片；需持有 mutex
+    void resetLocked() {
+        if (!segments.empty()) nextMsn = segments.back().msn + 1;
+        if (!segments.empty() || !initSegments.empty()) discontinuitySequence++;
+        initSegments.clear();
+        segments.clear();
+        timescale = 0;
+        defaultDuration = 0;
+        defaultFlags = 0;
+    }
+
+    void failWaiters() {
+        std::vector<Waiter> pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& item : waiters) pending.push_back(item.second.callback);
+            waiters.clear();
+            waitersGauge.set(0);
+        }
+        for (auto& waiter : pending) waiter(false);
+    }
+
+    void addPart(const std::string& data) {
+        std::vector<Waiter> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Part part;
+            part.data = std::make_shared<const std::string>(data);
+            parseFragment(data, part);
+            auto now = std::chrono::system_clock::now();
+            if (segments.empty() || segments.back().complete
+                || (part.independent && !segments.back().parts.empty())) {
+                if (!segments.empty() && !segments.back().complete) completeLocked(segments.back());
+                Segment seg;
+                seg.msn = segments.empty() ? nextMsn : segments.back().msn + 1;
+                seg.generation = generation;
+                seg.mediaStart = part.start;
+                seg.start = now - std::chrono::microseconds(static_cast<int64_t>(part.duration * 1e6));
+                segments.push_back(std::move(seg));
+                // 当前切片之外最多保留 maxSegments 个完整切片
+                while (segments.size() > config.maxSegments + 1) evictLocked();
+            }
+            Segment& current = segments.back();
+            current.parts.push_back(part);
+            current.duration += part.duration;
+            nextMsn = current.msn;
+            partCount++;
+            byteCount += data.size();
+            partsTotal.add();
+
+            for (auto it = waiters.begin(); it != waiters.end();) {
+                if (reachedLocked(it->second.msn, it->second.part)) {
+                    ready.push_back(it->second.callback);
+                    it = waiters.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            waitersGauge.set(waiters.size());
+        }
+        for (auto& waiter : ready) waiter(true);
+    }
+
+    // 淘汰最旧的切片，越过的代之间的不连续计入 EXT-X-DISCONTINUITY-SEQUENCE；需持有 mutex
+    void evictLocked() {
+        uint32_t evicted = segments.front().generation;
+        segments.pop_front();
+        if (segments.front().generation != evicted) discontinuitySequence++;
+        // 不再被任何切片引用的旧初始化段
+        while (!initSegments.empty() && initSegments.begin()->first < segments.front().generation) {
+            initSegments.erase(initSegments.begin());
+        }
+    }
+
+    // 需持有 mutex
+    void completeLocked(Segment& seg) {
+        std::string data;
+        size_t size = 0;
+        for (const auto& part : seg.parts) size += part.data->size();
+        data.reserve(size);
+        for (const auto& part : seg.parts) data += *part.data;
+        seg.data = std::make_shared<const std::string>(std::move(data));
+        seg.complete = true;
+        segmentDuration.observe(std::chrono::microseconds(static_cast<int64_t>(seg.duration * 1e6)));
+    }
+
+    // 解析中的输出，只在 start() 和监护线程中使用
+    std::string pendingBytes;               // 未凑满一个盒子的数据
+    std::string pendingInit;                // ftyp，等待 moov
+    std::string pendingMoof;                // moof，等待 mdat
+
+    std::mutex mutex;                       // 保护以下切片状态
+    Config config;
+    bool running = false;
+    uint32_t generation = 0;                // 当前 ffmpeg 进程的代数，每次输出初始化段时加一
+    std::map<uint32_t, Blob> initSegments;  // 各代的初始化段，保留到没有切片引用
+    std::deque<Segment> segments;
+    uint64_t nextMsn = 0;
+    uint64_t discontinuitySequence = 0;     // 已淘汰的切片之间的不连续次数
+    uint32_t timescale = 0;
+    uint32_t defaultDuration = 0;
+    uint32_t defaultFlags = 0;
+    uint64_t partCount = 0;
+    uint64_t byteCount = 0;
+    std::map<WaiterId, PendingWait> waiters;
+    WaiterId lastWaiterId = 0;
+
+    MetricHistogram& segmentDuration = Metrics::instance().histogram("hls_segment_seconds",
+        "Media duration of completed LL-HLS segments", {}, {0.25, 0.5, 1, 1.5, 2, 3, 4, 6});
+    MetricCounter& partsTotal = Metrics::instance().counter("hls_parts_total",
+        "LL-HLS partial segments produced");
+    MetricGauge& waitersGauge = Metrics::instance().gauge("hls_blocking_requests",
+        "Blocked LL-HLS playlist/part requests waiting for new media");
+
+    // 最后声明，析构时最先停止，回调不会用到已析构的成员
+    FFmpegStreamer encoder{"hls"};
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "CRSDK/CameraRemote_SDK.h"
+
+/**
+ * 预览元数据缓存（每台相机一份）
+ * 缓冲区大小和对焦框/人脸框/跟踪框信息很少变化，取帧热路径只读缓存，
+ * 由相机的 OnLvPropertyChanged / OnLvPropertyChangedCodes 回调负责刷新，
+ * 省掉每帧 GetLiveViewProperties + GetLiveViewImageInfo 两次SDK调用。
+ */
+class LiveViewInfoCache {
+public:
+    struct FrameInfo {
+        std::vector<SCRSDK::CrFocusFrameInfo> focus;
+        std::vector<SCRSDK::CrFaceFrameInfo> faces;
+        std::vector<SCRSDK::CrTrackingFrameInfo> tracking;
+        uint64_t version = 0;       // 每次刷新加一，调用方据此判断是否有变化
+    };
+
+    struct Stats {
+        uint32_t bufferSize = 0;
+        uint64_t bufferRefreshes = 0;   // GetLiveViewImageInfo 调用次数
+        uint64_t frameInfoRefreshes = 0;
+        size_t focusFrames = 0;
+        size_t faceFrames = 0;
+        size_t trackingFrames = 0;
+    };
+
+    // 缓存的缓冲区大小，0 表示失效，需要调用方重新 GetLiveViewImageInfo
+    uint32_t bufferSize() const { return bufSize.load(std::memory_order_acquire); }
+
+    void setBufferSize(uint32_t size) {
+        bufSize.store(size, std::memory_order_release);
+        bufferRefreshes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 画质/尺寸变化或取帧报内存不足时调用，下一帧重新取缓冲区大小
+    void invalidateBufferSize() { bufSize.store(0, std::memory_order_release); }
+
+    // 相机只通知“预览属性有变化”而不带code时调用，缓冲区大小和框信息都重新获取
+    void invalidate() {
+        frameInfoValid.store(false, std::memory_order_release);
+        invalidateBufferSize();
+    }
+
+    bool hasFrameInfo() const { return frameInfoValid.load(std::memory_order_acquire); }
+
+    /**
+     * 用 GetLiveViewProperties / GetSelectLiveViewProperties 的结果更新框信息
+     * 只覆盖结果中出现的类型，其余保持不变（增量通知只带变化的code）
+     */
+    void update(const SCRSDK::CrLiveViewProperty* props, int32_t count) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int32_t i = 0; props && i < count; ++i) {
+            const SCRSDK::CrLiveViewProperty& prop = props[i];
+            switch (prop.GetFrameInfoType()) {
+            case SCRSDK::CrFrameInfoType_FocusFrameInfo:
+                assign(info.focus, prop);
+                break;
+            case SCRSDK::CrFrameInfoType_FaceFrameInfo:
+                assign(info.faces, prop);
+                break;
+            case SCRSDK::CrFrameInfoType_TrackingFrameInfo:
+                assign(info.tracking, prop);
+                break;
+            default:
+                break;
+            }
+        }
+        ++info.version;
+        frameInfoValid.store(true, std::memory_order_release);
+        frameInfoRefreshes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    FrameInfo frameInfo() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return info;
+    }
+
+    Stats stats() const {
+        Stats s;
+        s.bufferSize = bufferSize();
+        s.bufferRefreshes = bufferRefreshes.load(std::memory_order_relaxed);
+        s.frameInfoRefreshes = frameInfoRefreshes.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex);
+        s.focusFrames = info.focus.size();
+        s.faceFrames = info.faces.size();
+        s.trackingFrames = info.tracking.size();
+        return s;
+    }
+
+    // 断开连接时清空，重连后重新获取
+    void reset() {
+        invalidate();
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t version = info.version;
+        info = FrameInfo();
+        info.version = version + 1;
+    }
+
+private:
+    template <typename T>
+    static void assign(std::vector<T>& out, const SCRSDK::CrLiveViewProperty& prop) {
+        const T* value = reinterpret_cast<const T*>(prop.GetValue());
+        size_t n = value ? prop.GetValueSize() / sizeof(T) : 0;
+        out.assign(value, value + n);
+    }
+
+    std::atomic<uint32_t> bufSize{0};
+    std::atomic<uint64_t> bufferRefreshes{0};
+    std::atomic<uint64_t> frameInfoRefreshes{0};
+    std::atomic<bool> frameInfoValid{false};
+    mutable std::mutex mutex;
+    FrameInfo info;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <memory>
+#include "FramePool.h"
+
+/**
+ * MJPEG分发用的帧负载
+ * 每帧只构造一次：multipart 分隔符、帧头、JPEG 和结尾拼成一个只读缓冲区，
+ * 同规格的所有观看者共享同一份，分块编码由各观看者的 ResponseStream 负责。
+ */
+class MjpegFrame {
+public:
+    static std::shared_ptr<const MjpegFrame> wrap(const FramePtr& frame) {
+        return std::shared_ptr<const MjpegFrame>(new MjpegFrame(frame));
+    }
+
+    const FramePtr& frame() const { return source; }
+
+    // 分隔符 + 帧头 + JPEG + 结尾\r\n
+    const std::string& part() const { return data; }
+
+    size_t totalSize() const { return data.size(); }
+
+private:
+    explicit MjpegFrame(const FramePtr& frame) : source(frame) {
+        std::string header = "--frame\r\n"
+                             "Content-Type: image/jpeg\r\n"
+                             "Content-Length: " + std::to_string(frame->size) + "\r\n\r\n";
+        data.reserve(header.size() + frame->size + 2);
+        data.append(header);
+        data.append(frame->data(), frame->size);
+        data.append("\r\n");
+    }
+
+    FramePtr source;
+    std::string data;
+};
+
+typedef std::shared_ptr<const MjpegFrame> MjpegFramePtr;
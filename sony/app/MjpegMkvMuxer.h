@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include "FramePool.h"
+
+/**
+ * 流式 Matroska 封装（V_MJPEG）
+ * 给 ffmpeg 的标准输入用：每帧带上采集时间戳，ffmpeg 按真实帧间隔编码，
+ * 不再像 image2pipe -framerate 那样按固定帧率重新打时间戳，长时间推流不会漂移、重复帧或越积越多的延迟。
+ * Segment 和 Cluster 都用未知长度，不需要回写；JPEG 数据不拷贝，调用方先写 frameHeader() 再写帧数据。
+ * 时间基为1毫秒，每秒或相对时间戳将要溢出时开一个新 Cluster。
+ */
+class MjpegMkvMuxer {
+public:
+    void reset() {
+        started = false;
+        firstTimestamp = std::chrono::steady_clock::time_point();
+        lastPts = -1;
+        clusterPts = -1;
+    }
+
+    /**
+     * 一帧数据前需要写入的字节：首帧前是文件头，必要时有新 Cluster，最后是 SimpleBlock 头
+     * @param frame 非空的JPEG帧
+     */
+    std::string frameHeader(const FramePtr& frame) {
+        std::string out;
+        if (!started) {
+            uint16_t width = 0;
+            uint16_t height = 0;
+            jpegSize(reinterpret_cast<const uint8_t*>(frame->data()), frame->size, width, height);
+            writeFileHeader(out, width, height);
+            firstTimestamp = frame->timestamp;
+            started = true;
+        }
+
+        // 采集时间相对第一帧，严格递增（同一毫秒内的两帧顺延1ms）
+        int64_t pts = std::chrono::duration_cast<std::chrono::milliseconds>(frame->timestamp - firstTimestamp).count();
+        if (pts <= lastPts) pts = lastPts + 1;
+        lastPts = pts;
+
+        if (clusterPts < 0 || pts - clusterPts >= ClusterMs) {
+            clusterPts = pts;
+            putId(out, 0x1F43B675);             // Cluster
+            putUnknownSize(out);
+            putUint(out, 0xE7, static_cast<uint64_t>(pts));    // Timecode
+        }
+
+        putId(out, 0xA3);                       // SimpleBlock
+        putSize(out, 4 + frame->size);
+        out.push_back(static_cast<char>(0x81)); // 轨道号1
+        int16_t relative = static_cast<int16_t>(pts - clusterPts);
+        out.push_back(static_cast<char>((relative >> 8) & 0xFF));
+        out.push_back(static_cast<char>(relative & 0xFF));
+        out.push_back(static_cast<char>(0x80)); // 关键帧
+        return out;
+    }
+
+private:
+    // int16 相对时间戳上限约32秒，1秒一个 Cluster 足够宽裕
+    static constexpr int64_t ClusterMs = 1000;
+
+    static void putId(std::string& out, uint32_t id) {
+        int bytes = id > 0xFFFFFF ? 4 : id > 0xFFFF ? 3 : id > 0xFF ? 2 : 1;
+        for (int i = bytes - 1; i >= 0; --i) out.push_back(static_cast<char>((id >> (i * 8)) & 0xFF));
+    }
+
+    // EBML 变长整数，取能表示该值的最短长度（全1保留给未知长度）
+    static void putSize(std::string& out, uint64_t size) {
+        int bytes = 1;
+        while (bytes < 8 && size >= (1ULL << (7 * bytes)) - 1) ++bytes;
+        uint64_t value = size | (1ULL << (7 * bytes));
+        for (int i = bytes - 1; i >= 0; --i) out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+
+    static void putUnknownSize(std::string& out) {
+        out.push_back(0x01);
+        out.append(7, static_cast<char>(0xFF));
+    }
+
+    static void putUint(std::string& out, uint32_t id, uint64_t value) {
+        int bytes = 1;
+        while (bytes < 8 && (value >> (bytes * 8)) != 0) ++bytes;
+        putId(out, id);
+        putSize(out, bytes);
+        for (int i = bytes - 1; i >= 0; --i) out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+
+    static void putString(std::string& out, uint32_t id, const std::string& value) {
+        putId(out, id);
+        putSize(out, value.size());
+        out += value;
+    }
+
+    static void putMaster(std::string& out, uint32_t id, const std::string& body) {
+        putId(out, id);
+        putSize(out, body.size());
+        out += body;
+    }
+
+    static void writeFileHeader(std::string& out, uint16_t width, uint16_t height) {
+        std::string ebml;
+        putUint(ebml, 0x4286, 1);               // EBMLVersion
+        putUint(ebml, 0x42F7, 1);               // EBMLReadVersion
+        putUint(ebml, 0x42F2, 4);               // EBMLMaxIDLength
+        putUint(ebml, 0x42F3, 8);               // EBMLMaxSizeLength
+        putString(ebml, 0x4282, "matroska");    // DocType
+        putUint(ebml, 0x4287, 4);               // DocTypeVersion
+        putUint(ebml, 0x4285, 2);               // DocTypeReadVersion
+        putMaster(out, 0x1A45DFA3, ebml);
+
+        putId(out, 0x18538067);                 // Segment
+        putUnknownSize(out);
+
+        std::string info;
+        putUint(info, 0x2AD7B1, 1000000);       // TimecodeScale：1ms
+        putString(info, 0x4D80, "digital_camera");  // MuxingApp
+        putString(info, 0x5741, "digital_camera");  // WritingApp
+        putMaster(out, 0x1549A966, info);
+
+        std::string video;
+        if (width > 0 && height > 0) {
+            putUint(video, 0xB0, width);        // PixelWidth
+            putUint(video, 0xBA, height);       // PixelHeight
+        }
+        std::string track;
+        putUint(track, 0xD7, 1);                // TrackNumber
+        putUint(track, 0x73C5, 1);              // TrackUID
+        putUint(track, 0x83, 1);                // TrackType：视频
+        putUint(track, 0x9C, 0);                // FlagLacing
+        putString(track, 0x86, "V_MJPEG");      // CodecID
+        putMaster(track, 0xE0, video);          // Video
+        std::string tracks;
+        putMaster(tracks, 0xAE, track);         // TrackEntry
+        putMaster(out, 0x1654AE6B, tracks);     // Tracks
+    }
+
+    // 从 SOF 取宽高，取不到时留空由解码器自己识别
+    static void jpegSize(const uint8_t* data, size_t size, uint16_t& width, uint16_t& height) {
+        size_t pos = 2;
+        while (pos + 9 <= size && data[pos] == 0xFF) {
+            uint8_t marker = data[pos + 1];
+            if (marker == 0xFF) { ++pos; continue; }
+            size_t length = (data[pos + 2] << 8) | data[pos + 3];
+            if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+                height = static_cast<uint16_t>((data[pos + 5] << 8) | data[pos + 6]);
+                width = static_cast<uint16_t>((data[pos + 7] << 8) | data[pos + 8]);
+                return;
+            }
+            if (marker == 0xDA) return;
+            pos += 2 + length;
+        }
+    }
+
+    bool started = false;
+    std::chrono::steady_clock::time_point firstTimestamp;
+    int64_t lastPts = -1;
+    int64_t clusterPts = -1;
+};
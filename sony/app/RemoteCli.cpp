@@ -1073,7 +1073,7 @@ int remotecli_main()
                         std::getline(cli::tin, select);
                         cli::tout << '\n';
                         if (select == TEXT("1")) { /* Live View */
-                            camera->get_live_view(true);
+                            camera->get_live_view();
                         }
                         else if (select == TEXT("2")) { /* Live View Image Quality */
                             camera->get_live_view_image_quality();
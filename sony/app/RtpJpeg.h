@@ -0,0 +1,286 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <sys/uio.h>
+#include "FramePool.h"
+
+/**
+ * JPEG 帧的 RTP 打包（RFC 2435）
+ * 只解析JPEG头部：取出量化表、尺寸、采样方式和重启间隔，熵编码数据原样分片，不转码。
+ * 负载直接引用帧缓冲，RTP头和 JPEG 头集中存放在一块小内存里，发送时用 iovec 拼接。
+ * 打包结果只读，可被多个会话（UDP/TCP交织/组播）同时发送。
+ *
+ * 限制：RFC 2435 假定使用标准霍夫曼表，接收端按标准表重建JPEG头；
+ * 只支持三分量、亮度 2x1（type 0）或 2x2（type 1）采样的基线JPEG，宽高不超过 2040。
+ */
+class RtpJpegFrame {
+public:
+    static constexpr uint8_t PayloadType = 26;
+    static constexpr uint32_t ClockRate = 90000;
+    static constexpr size_t RtpHeaderSize = 12;
+
+    struct Packet {
+        uint32_t headerOffset = 0;      // 在 headers 中的偏移，含RTP头
+        uint16_t headerSize = 0;
+        uint32_t payloadOffset = 0;     // 在 JPEG 数据中的偏移
+        uint32_t payloadSize = 0;
+    };
+
+    FramePtr frame() const { return source; }
+    uint32_t timestamp() const { return rtpTimestamp; }
+    uint16_t firstSeq() const { return seq; }
+    size_t packetCount() const { return packets.size(); }
+    size_t packetSize(size_t index) const {
+        return packets[index].headerSize + packets[index].payloadSize;
+    }
+    // 所有包的总字节数（不含TCP交织头）
+    size_t totalSize() const { return bytes; }
+
+    // 第 index 个包的 RTP 头 + 负载，返回 iovec 个数（2）
+    int fill(size_t index, struct iovec* iov) const {
+        const Packet& p = packets[index];
+        iov[0].iov_base = const_cast<uint8_t*>(headers.data() + p.headerOffset);
+        iov[0].iov_len = p.headerSize;
+        iov[1].iov_base = const_cast<char*>(source->data() + p.payloadOffset);
+        iov[1].iov_len = p.payloadSize;
+        return 2;
+    }
+
+private:
+    friend class RtpJpegPacketizer;
+    FramePtr source;
+    std::vector<uint8_t> headers;
+    std::vector<Packet> packets;
+    uint32_t rtpTimestamp = 0;
+    uint16_t seq = 0;
+    size_t bytes = 0;
+};
+
+typedef std::shared_ptr<const RtpJpegFrame> RtpJpegFramePtr;
+
+/**
+ * RTP/JPEG 打包器
+ * 维护一路RTP流的 SSRC、序号和时间戳，只在一个线程中调用 packetize。
+ */
+class RtpJpegPacketizer {
+public:
+    // 以太网 MTU 1500 减去 IP/UDP 头和 TCP 交织头后留有余量
+    static constexpr size_t DefaultMaxPacketSize = 1400;
+
+    explicit RtpJpegPacketizer(size_t maxPacketSize = DefaultMaxPacketSize)
+        : maxPacketSize(maxPacketSize), epoch(std::chrono::steady_clock::now()) {
+        std::random_device rd;
+        ssrc = rd();
+        nextSeq = static_cast<uint16_t>(rd());
+        timestampBase = rd();
+    }
+
+    uint32_t getSsrc() const { return ssrc; }
+    // 下一个包的序号，可在其他线程读取（PLAY 回复 RTP-Info）
+    uint16_t getNextSeq() const { return nextSeq.load(); }
+
+    // 任意时刻对应的RTP时间戳，帧时间戳和 RTP-Info 都用它换算
+    uint32_t rtpTime(std::chrono::steady_clock::time_point t) const {
+        int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(t - epoch).count();
+        return timestampBase + static_cast<uint32_t>(us * RtpJpegFrame::ClockRate / 1000000);
+    }
+
+    /**
+     * 打包一帧
+     * @return 不支持的JPEG（渐进式、非标准采样、尺寸超限等）返回空
+     */
+    RtpJpegFramePtr packetize(const FramePtr& frame) {
+        JpegInfo info;
+        if (!frame || frame->empty() || !parse(reinterpret_cast<const uint8_t*>(frame->data()), frame->size, info)) {
+            return RtpJpegFramePtr();
+        }
+
+        auto out = std::make_shared<RtpJpegFrame>();
+        out->source = frame;
+        out->rtpTimestamp = rtpTime(frame->timestamp);
+        out->seq = nextSeq.load();
+
+        uint8_t type = info.type | (info.restartInterval ? 0x40 : 0);
+        size_t fixedHeader = RtpJpegFrame::RtpHeaderSize + 8 + (info.restartInterval ? 4 : 0);
+        size_t qtableHeader = 4 + info.qtables.size();
+        size_t offset = 0;
+        while (offset < info.scanSize) {
+            size_t headerSize = fixedHeader + (offset == 0 ? qtableHeader : 0);
+            size_t chunk = info.scanSize - offset;
+            if (headerSize + chunk > maxPacketSize) chunk = maxPacketSize - headerSize;
+            bool last = offset + chunk == info.scanSize;
+
+            RtpJpegFrame::Packet packet;
+            packet.headerOffset = static_cast<uint32_t>(out->headers.size());
+            packet.headerSize = static_cast<uint16_t>(headerSize);
+            packet.payloadOffset = static_cast<uint32_t>(info.scanOffset + offset);
+            packet.payloadSize = static_cast<uint32_t>(chunk);
+            out->headers.resize(packet.headerOffset + headerSize);
+            uint8_t* p = out->headers.data() + packet.headerOffset;
+
+            // RTP 头
+            p[0] = 0x80;
+            p[1] = RtpJpegFrame::PayloadType | (last ? 0x80 : 0);
+            putBE(p + 2, nextSeq.fetch_add(1), 2);
+            putBE(p + 4, out->rtpTimestamp, 4);
+            putBE(p + 8, ssrc, 4);
+            p += RtpJpegFrame::RtpHeaderSize;
+
+            // JPEG 主头：type-specific | fragment offset(24) | type | Q | width/8 | height/8
+            p[0] = 0;
+            putBE(p + 1, static_cast<uint32_t>(offset), 3);
+            p[4] = type;
+            p[5] = 255;     // 量化表随第一个包带内发送
+            p[6] = static_cast<uint8_t>(info.width / 8);
+            p[7] = static_cast<uint8_t>(info.height / 8);
+            p += 8;
+
+            if (info.restartInterval) {
+                putBE(p, info.restartInterval, 2);
+                p[2] = 0xFF;    // F=1 L=1 count=0x3FFF，整帧不按重启间隔切分
+                p[3] = 0xFF;
+                p += 4;
+            }
+
+            if (offset == 0) {
+                p[0] = 0;
+                p[1] = info.precision;
+                putBE(p + 2, static_cast<uint32_t>(info.qtables.size()), 2);
+                memcpy(p + 4, info.qtables.data(), info.qtables.size());
+            }
+
+            out->bytes += headerSize + chunk;
+            out->packets.push_back(packet);
+            offset += chunk;
+        }
+        return out;
+    }
+
+private:
+    struct JpegInfo {
+        uint8_t type = 0;
+        uint16_t width = 0;
+        uint16_t height = 0;
+        uint16_t restartInterval = 0;
+        uint8_t precision = 0;          // 第 i 位为1表示第 i 个表是16位
+        std::vector<uint8_t> qtables;   // 亮度表在前，色度表在后，zigzag顺序
+        size_t scanOffset = 0;
+        size_t scanSize = 0;
+    };
+
+    static void putBE(uint8_t* p, uint32_t value, int bytes) {
+        for (int i = bytes - 1; i >= 0; --i) {
+            p[i] = static_cast<uint8_t>(value & 0xFF);
+            value >>= 8;
+        }
+    }
+
+    static uint16_t getBE16(const uint8_t* p) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    // 解析到 SOS 为止，熵编码数据不扫描
+    static bool parse(const uint8_t* data, size_t size, JpegInfo& info) {
+        if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) return false;
+        // 量化表按 Tq 存放，SOF 里再按分量取亮度/色度表
+        const uint8_t* tables[4] = {nullptr, nullptr, nullptr, nullptr};
+        bool wide[4] = {false, false, false, false};
+        uint8_t componentTable[3] = {0, 0, 0};
+        bool haveFrame = false;
+
+        size_t pos = 2;
+        while (pos + 4 <= size) {
+            if (data[pos] != 0xFF) return false;
+            uint8_t marker = data[pos + 1];
+            if (marker == 0xFF) { ++pos; continue; }     // 填充字节
+            size_t length = getBE16(data + pos + 2);
+            if (length < 2 || pos + 2 + length > size) return false;
+            const uint8_t* seg = data + pos + 4;
+            size_t segSize = length - 2;
+
+            switch (marker) {
+            case 0xDB: {    // DQT
+                size_t i = 0;
+                while (i < segSize) {
+                    uint8_t pq = seg[i] >> 4;
+                    uint8_t tq = seg[i] & 0x0F;
+                    size_t tableSize = pq ? 128 : 64;
+                    if (tq > 3 || i + 1 + tableSize > segSize) return false;
+                    tables[tq] = seg + i + 1;
+                    wide[tq] = pq != 0;
+                    i += 1 + tableSize;
+                }
+                break;
+            }
+            case 0xDD:      // DRI
+                if (segSize < 2) return false;
+                info.restartInterval = getBE16(seg);
+                break;
+            case 0xC0:      // SOF0 基线
+            case 0xC1: {    // SOF1 扩展顺序（霍夫曼）
+                if (segSize < 15 || seg[0] != 8 || seg[5] != 3) return false;
+                info.height = getBE16(seg + 1);
+                info.width = getBE16(seg + 3);
+                if (info.width == 0 || info.height == 0 || info.width > 2040 || info.height > 2040) return false;
+                uint8_t ySampling = seg[7];
+                if (seg[10] != 0x11 || seg[13] != 0x11) return false;
+                if (ySampling == 0x21) {
+                    info.type = 0;
+                } else if (ySampling == 0x22) {
+                    info.type = 1;
+                } else {
+                    return false;
+                }
+                componentTable[0] = seg[8] & 0x03;
+                componentTable[1] = seg[11] & 0x03;
+                componentTable[2] = seg[14] & 0x03;
+                haveFrame = true;
+                break;
+            }
+            case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+            case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+                return false;   // 渐进式/无损/算术编码
+            case 0xDA: {    // SOS，后面是熵编码数据
+                if (!haveFrame) return false;
+                const uint8_t* luma = tables[componentTable[0]];
+                const uint8_t* chroma = tables[componentTable[1]];
+                if (!luma || !chroma) return false;
+                bool lumaWide = wide[componentTable[0]];
+                bool chromaWide = wide[componentTable[1]];
+                info.qtables.assign(luma, luma + (lumaWide ? 128 : 64));
+                info.qtables.insert(info.qtables.end(), chroma, chroma + (chromaWide ? 128 : 64));
+                info.precision = (lumaWide ? 1 : 0) | (chromaWide ? 2 : 0);
+                info.scanOffset = pos + 2 + length;
+                // 去掉结尾的 EOI（只看末尾几个字节，允许少量填充），接收端会自己补上
+                size_t end = size;
+                size_t limit = size > info.scanOffset + 16 ? size - 16 : info.scanOffset;
+                for (size_t i = size; i >= limit + 2; --i) {
+                    if (data[i - 2] == 0xFF && data[i - 1] == 0xD9) {
+                        end = i - 2;
+                        break;
+                    }
+                }
+                info.scanSize = end - info.scanOffset;
+                return info.scanSize > 0;
+            }
+            default:
+                break;
+            }
+            pos += 2 + length;
+        }
+        return false;
+    }
+
+    size_t maxPacketSize;
+    std::chrono::steady_clock::time_point epoch;
+    uint32_t ssrc = 0;
+    std::atomic<uint16_t> nextSeq{0};
+    uint32_t timestampBase = 0;
+};
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "FramePool.h"
+#include "RtpJpeg.h"
+#include "Logger.h"
+#include "Metrics.h"
+
+/**
+ * 组播预览输出
+ * 把相机JPEG按 RFC 2435 打包为 RTP/JPEG 发往一个组播组，观看者数量不影响服务端开销，适合局域网大屏墙。
+ * 接收端通过REST接口取 SDP（ffplay/VLC 直接打开 .sdp 即可）。
+ * pushFrame 在总线sink线程中直接发送：sendmmsg 批量发出一帧的所有包，发送缓冲区满时丢弃本帧剩余的包。
+ */
+class RtpMulticastSender {
+public:
+    struct Config {
+        std::string group = "239.255.0.1";
+        int port = 5004;            // RTP 端口，RTCP 约定为 port+1
+        int ttl = 1;                // 默认不出本网段
+        std::string interface;      // 发送网卡的IPv4地址，空表示按路由表选择
+        bool loopback = true;       // 本机也能收到，便于调试
+    };
+
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        uint64_t dropped = 0;       // 发送缓冲区满丢弃的包数
+        uint64_t unsupported = 0;   // 无法按 RFC 2435 打包的帧数
+    };
+
+    bool start(const Config& cfg) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fd >= 0) return true;
+        sockaddr_in dest{};
+        dest.sin_family = AF_INET;
+        dest.sin_port = htons(cfg.port);
+        if (inet_pton(AF_INET, cfg.group.c_str(), &dest.sin_addr) != 1 || !IN_MULTICAST(ntohl(dest.sin_addr.s_addr))) {
+            LOG_ERROR("multicast: invalid group " << cfg.group);
+            return false;
+        }
+
+        fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            LOG_ERROR("multicast: socket failed: " << strerror(errno));
+            return false;
+        }
+        unsigned char ttl = static_cast<unsigned char>(cfg.ttl);
+        unsigned char loop = cfg.loopback ? 1 : 0;
+        int sndbuf = 2 * 1024 * 1024;
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        if (!cfg.interface.empty()) {
+            in_addr iface{};
+            if (inet_pton(AF_INET, cfg.interface.c_str(), &iface) != 1
+                || setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) < 0) {
+                LOG_ERROR("multicast: invalid interface " << cfg.interface);
+                closeLocked();
+                return false;
+            }
+        }
+        // 固定目的地址，发送时不再带地址
+        if (connect(fd, (sockaddr*)&dest, sizeof(dest)) < 0) {
+            LOG_ERROR("multicast: connect " << cfg.group << ":" << cfg.port << " failed: " << strerror(errno));
+            closeLocked();
+            return false;
+        }
+        config = cfg;
+        running = true;
+        LOG_INFO("multicast start, " << cfg.group << ":" << cfg.port << " ttl " << cfg.ttl);
+        return true;
+    }
+
+    bool isRunning() const { return running; }
+
+    Config currentConfig() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return config;
+    }
+
+    // 总线sink线程调用
+    void pushFrame(const FramePtr& frame) {
+        if (!running) return;
+        RtpJpegFramePtr packets = packetizer.packetize(frame);
+        if (!packets) {
+            unsupported++;
+            unsupportedTotal.add();
+            LOG_EVERY_MS(LogLevel::Warn, 5000, "multicast: frame " << (frame ? frame->frameNo : 0)
+                << " is not a baseline 4:2:x JPEG, skipped");
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fd < 0) return;
+        send(*packets);
+    }
+
+    /**
+     * 接收端用的 SDP
+     * @param origin o= 行中的本机地址，空则用发送网卡地址或 0.0.0.0
+     */
+    std::string sdp(const std::string& origin = std::string()) {
+        Config cfg = currentConfig();
+        std::string source = !origin.empty() ? origin : (!cfg.interface.empty() ? cfg.interface : "0.0.0.0");
+        std::string pt = std::to_string(RtpJpegFrame::PayloadType);
+        std::string sdp;
+        sdp += "v=0\r\n";
+        sdp += "o=- " + std::to_string(packetizer.getSsrc()) + " 1 IN IP4 " + source + "\r\n";
+        sdp += "s=Sony Live View (multicast)\r\n";
+        sdp += "c=IN IP4 " + cfg.group + "/" + std::to_string(cfg.ttl) + "\r\n";
+        sdp += "t=0 0\r\n";
+        sdp += "m=video " + std::to_string(cfg.port) + " RTP/AVP " + pt + "\r\n";
+        sdp += "a=rtpmap:" + pt + " JPEG/90000\r\n";
+        sdp += "a=recvonly\r\n";
+        return sdp;
+    }
+
+    SinkMetrics& metrics() { return sinkMetrics; }
+
+    Stats stats() {
+        Stats s;
+        s.frames = frames;
+        s.packets = packets;
+        s.bytes = bytes;
+        s.dropped = dropped;
+        s.unsupported = unsupported;
+        return s;
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fd < 0) return;
+        closeLocked();
+        LOG_INFO("multicast stop, frames " << frames << ", dropped packets " << dropped);
+    }
+
+    ~RtpMulticastSender() { stop(); }
+
+private:
+    // 每次 sendmmsg 的最大包数
+    static constexpr size_t Batch = 64;
+
+    // 需持有 mutex
+    void closeLocked() {
+        running = false;
+        close(fd);
+        fd = -1;
+    }
+
+    // 需持有 mutex
+    void send(const RtpJpegFrame& frame) {
+        mmsghdr msgs[Batch];
+        iovec iovs[Batch][2];
+        size_t total = frame.packetCount();
+        size_t index = 0;
+        size_t sentBytes = 0;
+        while (index < total) {
+            size_t batch = std::min(Batch, total - index);
+            memset(msgs, 0, sizeof(mmsghdr) * batch);
+            for (size_t i = 0; i < batch; ++i) {
+                frame.fill(index + i, iovs[i]);
+                msgs[i].msg_hdr.msg_iov = iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 2;
+            }
+            int n = sendmmsg(fd, msgs, static_cast<unsigned int>(batch), MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                LOG_EVERY_MS(LogLevel::Warn, 5000, "multicast send failed: " << strerror(errno));
+                break;
+            }
+            for (int i = 0; i < n; ++i) sentBytes += frame.packetSize(index + i);
+            index += n;
+        }
+        packets += index;
+        bytes += sentBytes;
+        sinkMetrics.addBytes(sentBytes);
+        if (index < total) {
+            dropped += total - index;
+            droppedTotal.add(total - index);
+        } else {
+            frames++;
+            sinkMetrics.observeWire(frame.frame()->timestamp);
+        }
+    }
+
+    std::mutex mutex;                       // 保护 fd 和 config
+    int fd = -1;
+    Config config;
+    std::atomic<bool> running{false};
+    RtpJpegPacketizer packetizer;           // 只在sink线程打包
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> packets{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> unsupported{0};
+    SinkMetrics sinkMetrics{"multicast"};
+    MetricCounter& droppedTotal = Metrics::instance().counter("multicast_packets_dropped_total",
+        "RTP packets dropped because the multicast send buffer was full");
+    MetricCounter& unsupportedTotal = Metrics::instance().counter("rtp_jpeg_unsupported_frames_total",
+        "Live-view frames that could not be packetized as RFC 2435 RTP/JPEG", {{"sink", "multicast"}});
+};
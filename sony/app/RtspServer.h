@@ -0,0 +1,881 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "FramePool.h"
+#include "RtpJpeg.h"
+#include "Logger.h"
+#include "Metrics.h"
+
+/**
+ * 内置 RTSP 服务
+ * 局域网内的 NVR、VLC、ffplay 直接拉流：rtsp://<ip>:8554/camera/<序号>
+ * 相机输出的JPEG按 RFC 2435 打包为 RTP/JPEG，不转码；支持 UDP 单播和 TCP 交织（RTP/AVP/TCP）两种传输。
+ *
+ * 单个IO线程跑边沿触发的 epoll 循环，所有socket非阻塞。
+ * pushFrame 在总线sink线程打包（只解析JPEG头），把打包结果放进共享槽并唤醒IO线程；
+ * 所有会话共用一路RTP流（同一 SSRC/序号），每帧只打包一次。
+ * UDP 会话用 sendmmsg 批量发送，内核缓冲区满时丢弃本帧剩余的包；
+ * TCP 会话有“最新帧”信箱，上一帧没发完时新帧覆盖旧帧，慢客户端只会跳帧。
+ */
+class RtspServer {
+public:
+    static constexpr int DefaultPort = 8554;
+
+    struct SessionStats {
+        std::string id;
+        std::string transport;      // udp / tcp
+        std::string client;         // 客户端地址
+        bool playing = false;
+        uint64_t frames = 0;        // 已发送的帧数
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        uint64_t skipped = 0;       // TCP：信箱中被新帧替换的帧数
+        uint64_t dropped = 0;       // UDP：发送缓冲区满丢弃的包数
+        double fractionLost = 0;    // 最近一次 RTCP 接收报告
+        uint32_t cumulativeLost = 0;
+        uint32_t jitter = 0;        // RTP 时间戳单位
+        int64_t ageMs = 0;
+    };
+
+    // 播放中的会话数量变化回调，在IO线程中调用
+    void setClientCountCallback(std::function<void (size_t)> cb) {
+        onClientCountChanged = cb;
+    }
+
+    size_t clientCount() {
+        return playingCount.load();
+    }
+
+    /**
+     * 启动服务
+     * @param port RTSP 端口
+     * @param rtpPort UDP 传输的服务端 RTP 端口（RTCP 为 rtpPort+1），0 表示 port+2
+     */
+    bool start(int port, int rtpPort = 0) {
+        if (running) return true;
+        if (rtpPort == 0) rtpPort = port + 2;
+        serverFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        rtpFd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        rtcpFd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (serverFd < 0 || rtpFd < 0 || rtcpFd < 0) {
+            closeFds();
+            return false;
+        }
+
+        int opt = 1;
+        setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        // 一帧几百个包一次性发出，发送缓冲区要能放下整帧
+        int sndbuf = 2 * 1024 * 1024;
+        setsockopt(rtpFd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+        if (!bindPort(serverFd, port) || listen(serverFd, 16) < 0
+            || !bindPort(rtpFd, rtpPort) || !bindPort(rtcpFd, rtpPort + 1)) {
+            LOG_ERROR("rtsp server bind/listen failed, port " << port << "/" << rtpPort << ": " << strerror(errno));
+            closeFds();
+            return false;
+        }
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        // wakeFd 只在析构时关闭，stop 之后迟到的 pushFrame 不会写到被复用的fd上
+        if (wakeFd < 0) wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0) {
+            LOG_ERROR("rtsp server epoll init failed: " << strerror(errno));
+            closeFds();
+            return false;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.fd = serverFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, serverFd, &ev);
+        ev.data.fd = wakeFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+        ev.data.fd = rtcpFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, rtcpFd, &ev);
+
+        listenPort = port;
+        serverRtpPort = rtpPort;
+        running = true;
+        serverThread = std::thread(&RtspServer::ioLoop, this);
+        LOG_INFO("rtsp server start, port " << port << ", rtp port " << rtpPort);
+        return true;
+    }
+
+    bool isRunning() const { return running; }
+    int port() const { return listenPort; }
+
+    // 总线sink线程调用：没有播放中的会话时不打包
+    void pushFrame(const FramePtr& frame) {
+        if (!running || playingCount.load() == 0) return;
+        RtpJpegFramePtr packets = packetizer.packetize(frame);
+        if (!packets) {
+            unsupportedTotal.add();
+            LOG_EVERY_MS(LogLevel::Warn, 5000, "rtsp: frame " << (frame ? frame->frameNo : 0)
+                << " is not a baseline 4:2:x JPEG, skipped");
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(latestMutex);
+            latest = std::move(packets);
+        }
+        wake();
+    }
+
+    SinkMetrics& metrics() { return sinkMetrics; }
+
+    std::vector<SessionStats> stats() {
+        std::vector<SessionStats> ret;
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        for (auto& item : sessions) {
+            const Session& session = *item.second;
+            SessionStats s;
+            s.id = session.id;
+            s.transport = session.tcp ? "tcp" : "udp";
+            s.client = session.client;
+            s.playing = session.playing;
+            s.frames = session.frames;
+            s.packets = session.packets;
+            s.bytes = session.bytes;
+            s.skipped = session.skipped;
+            s.dropped = session.dropped;
+            s.fractionLost = session.fractionLost / 256.0;
+            s.cumulativeLost = session.cumulativeLost;
+            s.jitter = session.jitter;
+            s.ageMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - session.created).count();
+            ret.push_back(s);
+        }
+        return ret;
+    }
+
+    void stop() {
+        if (!running.exchange(false)) return;
+        wake();
+        if (serverThread.joinable()) serverThread.join();
+        for (auto& item : connections) {
+            close(item.first);
+        }
+        connections.clear();
+        {
+            std::lock_guard<std::mutex> lock(sessionsMutex);
+            sessions.clear();
+        }
+        {
+            std::lock_guard<std::mutex> lock(latestMutex);
+            latest.reset();
+        }
+        closeFds();
+        size_t before = playingCount.exchange(0);
+        sessionsGauge.set(0);
+        if (before > 0 && onClientCountChanged) onClientCountChanged(0);
+        LOG_INFO("rtsp server stop");
+    }
+
+    ~RtspServer() {
+        stop();
+        if (wakeFd >= 0) close(wakeFd);
+    }
+
+private:
+    // 一个RTSP会话（单轨道），只在IO线程中修改；统计字段供 stats() 跨线程读取
+    struct Session {
+        std::string id;
+        std::string client;
+        std::string url;                    // SETUP 的轨道地址，用于 RTP-Info
+        bool tcp = false;
+        int connFd = -1;                    // TCP 交织会话所属连接
+        uint8_t rtpChannel = 0;
+        uint8_t rtcpChannel = 1;
+        sockaddr_in rtpAddr{};              // UDP 目的地址
+        sockaddr_in rtcpAddr{};
+        std::atomic<bool> playing{false};
+        std::chrono::steady_clock::time_point created;
+        std::chrono::steady_clock::time_point lastActivity;
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> packets{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> skipped{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint32_t> fractionLost{0};
+        std::atomic<uint32_t> cumulativeLost{0};
+        std::atomic<uint32_t> jitter{0};
+    };
+    typedef std::shared_ptr<Session> SessionPtr;
+
+    // 一个RTSP控制连接，只在IO线程中访问
+    struct Connection {
+        int fd = -1;
+        std::string peer;                   // 客户端IP
+        std::string local;                  // 本机IP，SDP 用
+        std::string request;                // 未处理完的输入
+        std::string out;                    // 待发送的RTSP应答
+        size_t outSent = 0;
+        SessionPtr session;                 // 该连接上的 TCP 交织会话
+        uint8_t channel = 0;                // RTP 交织通道号
+        RtpJpegFramePtr sending;            // 正在发送的帧
+        size_t packetIndex = 0;
+        size_t packetSent = 0;              // 当前包已发送的字节数，含4字节交织头
+        RtpJpegFramePtr mailbox;            // 等待发送的最新帧
+        std::chrono::steady_clock::time_point lastProgress;
+    };
+
+    struct Request {
+        std::string method;
+        std::string url;
+        std::map<std::string, std::string> headers;     // 键为小写
+        std::string header(const std::string& name) const {
+            auto it = headers.find(name);
+            return it == headers.end() ? std::string() : it->second;
+        }
+    };
+
+    // 请求头上限，超过视为非法请求
+    static constexpr size_t MaxRequestSize = 8192;
+    static constexpr size_t MaxSessions = 32;
+    // UDP 会话超过此时间没有RTSP请求或RTCP报告则回收
+    static constexpr int SessionTimeoutSec = 60;
+    // TCP 连接在此时间内没有任何发送进展则断开
+    static constexpr int StallTimeoutMs = 10000;
+    // 每次 sendmmsg 的最大包数
+    static constexpr size_t UdpBatch = 64;
+
+    bool bindPort(int fd, int port) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = INADDR_ANY;
+        addr.sin_port = htons(port);
+        return bind(fd, (sockaddr*)&addr, sizeof(addr)) == 0;
+    }
+
+    void wake() {
+        if (wakeFd < 0) return;
+        uint64_t one = 1;
+        ssize_t n = write(wakeFd, &one, sizeof(one));
+        (void)n;
+    }
+
+    void closeFds() {
+        if (serverFd >= 0) { close(serverFd); serverFd = -1; }
+        if (rtpFd >= 0) { close(rtpFd); rtpFd = -1; }
+        if (rtcpFd >= 0) { close(rtcpFd); rtcpFd = -1; }
+        if (epollFd >= 0) { close(epollFd); epollFd = -1; }
+    }
+
+    void ioLoop() {
+        epoll_event events[64];
+        while (running) {
+            int n = epoll_wait(epollFd, events, 64, 1000);
+            if (n < 0 && errno != EINTR) {
+                LOG_ERROR("rtsp epoll_wait failed: " << strerror(errno));
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == serverFd) {
+                    acceptConnections();
+                } else if (fd == wakeFd) {
+                    uint64_t value;
+                    while (read(wakeFd, &value, sizeof(value)) > 0) {}
+                    dispatchLatest();
+                } else if (fd == rtcpFd) {
+                    readRtcp();
+                } else {
+                    auto it = connections.find(fd);
+                    if (it == connections.end()) continue;
+                    bool alive = !(events[i].events & (EPOLLHUP | EPOLLERR));
+                    if (alive && (events[i].events & (EPOLLIN | EPOLLRDHUP))) alive = readConnection(it->second);
+                    if (alive) alive = flushConnection(it->second);
+                    if (!alive) dropConnection(fd);
+                }
+            }
+            expireSessions();
+            updatePlayingCount();
+        }
+        LOG_DEBUG("rtsp ioLoop exit");
+    }
+
+    void acceptConnections() {
+        // 边沿触发，必须一直 accept 到 EAGAIN
+        while (true) {
+            sockaddr_in peer{};
+            socklen_t peerLen = sizeof(peer);
+            int fd = accept4(serverFd, (sockaddr*)&peer, &peerLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            int flag = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            ev.data.fd = fd;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                close(fd);
+                continue;
+            }
+            sockaddr_in local{};
+            socklen_t localLen = sizeof(local);
+            getsockname(fd, (sockaddr*)&local, &localLen);
+            Connection& conn = connections[fd];
+            conn.fd = fd;
+            conn.peer = addressString(peer.sin_addr);
+            conn.local = addressString(local.sin_addr);
+            conn.lastProgress = std::chrono::steady_clock::now();
+            LOG_DEBUG("rtsp connection " << fd << " from " << conn.peer);
+        }
+    }
+
+    static std::string addressString(const in_addr& addr) {
+        char buf[INET_ADDRSTRLEN] = {0};
+        inet_ntop(AF_INET, &addr, buf, sizeof(buf));
+        return buf;
+    }
+
+    // 读取输入：RTSP 请求，或 TCP 交织模式下客户端发来的 '$' 数据（RTCP）
+    bool readConnection(Connection& conn) {
+        char buf[2048];
+        while (true) {
+            ssize_t n = recv(conn.fd, buf, sizeof(buf), 0);
+            if (n > 0) {
+                conn.request.append(buf, n);
+                continue;
+            }
+            if (n == 0) return false;
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        while (!conn.request.empty()) {
+            if (conn.request[0] == '$') {
+                if (conn.request.size() < 4) break;
+                size_t length = (static_cast<uint8_t>(conn.request[2]) << 8) | static_cast<uint8_t>(conn.request[3]);
+                if (conn.request.size() < 4 + length) break;
+                if (conn.session && static_cast<uint8_t>(conn.request[1]) == conn.session->rtcpChannel) {
+                    handleRtcp(*conn.session, reinterpret_cast<const uint8_t*>(conn.request.data() + 4), length);
+                }
+                conn.request.erase(0, 4 + length);
+                continue;
+            }
+            size_t end = conn.request.find("\r\n\r\n");
+            if (end == std::string::npos) {
+                return conn.request.size() <= MaxRequestSize;
+            }
+            Request req;
+            if (!parseRequest(conn.request.substr(0, end), req)) return false;
+            size_t bodySize = static_cast<size_t>(atoi(req.header("content-length").c_str()));
+            if (conn.request.size() < end + 4 + bodySize) {
+                return end + 4 + bodySize <= MaxRequestSize;
+            }
+            conn.request.erase(0, end + 4 + bodySize);
+            handleRequest(conn, req);
+        }
+        return true;
+    }
+
+    static std::string trim(const std::string& s) {
+        size_t begin = s.find_first_not_of(" \t");
+        if (begin == std::string::npos) return std::string();
+        size_t end = s.find_last_not_of(" \t\r");
+        return s.substr(begin, end - begin + 1);
+    }
+
+    static bool parseRequest(const std::string& head, Request& req) {
+        size_t lineEnd = head.find("\r\n");
+        std::string line = head.substr(0, lineEnd);
+        size_t sp1 = line.find(' ');
+        size_t sp2 = line.rfind(' ');
+        if (sp1 == std::string::npos || sp2 == sp1 || line.compare(sp2 + 1, 5, "RTSP/") != 0) return false;
+        req.method = line.substr(0, sp1);
+        req.url = line.substr(sp1 + 1, sp2 - sp1 - 1);
+        while (lineEnd != std::string::npos) {
+            size_t start = lineEnd + 2;
+            lineEnd = head.find("\r\n", start);
+            line = head.substr(start, lineEnd == std::string::npos ? std::string::npos : lineEnd - start);
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string key = line.substr(0, colon);
+            for (auto& c : key) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+            req.headers[key] = trim(line.substr(colon + 1));
+        }
+        return true;
+    }
+
+    void reply(Connection& conn, const Request& req, const std::string& status,
+               const std::string& headers = std::string(), const std::string& body = std::string()) {
+        conn.out += "RTSP/1.0 " + status + "\r\n";
+        conn.out += "CSeq: " + req.header("cseq") + "\r\n";
+        conn.out += "Server: sony-camera-rtsp\r\n";
+        conn.out += headers;
+        if (!body.empty()) conn.out += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+        conn.out += "\r\n";
+        conn.out += body;
+    }
+
+    // 在请求的 Session 头中找到会话，顺带刷新活动时间
+    SessionPtr findSession(const Request& req) {
+        std::string id = req.header("session");
+        size_t semicolon = id.find(';');
+        if (semicolon != std::string::npos) id = id.substr(0, semicolon);
+        if (id.empty()) return SessionPtr();
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        auto it = sessions.find(id);
+        if (it == sessions.end()) return SessionPtr();
+        it->second->lastActivity = std::chrono::steady_clock::now();
+        return it->second;
+    }
+
+    void handleRequest(Connection& conn, const Request& req) {
+        LOG_DEBUG("rtsp " << conn.peer << " " << req.method << " " << req.url);
+        if (req.method == "OPTIONS") {
+            reply(conn, req, "200 OK", "Public: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, TEARDOWN, GET_PARAMETER\r\n");
+        } else if (req.method == "DESCRIBE") {
+            std::string base = req.url;
+            if (base.empty() || base.back() != '/') base += '/';
+            reply(conn, req, "200 OK",
+                  "Content-Base: " + base + "\r\nContent-Type: application/sdp\r\n", describe(conn));
+        } else if (req.method == "SETUP") {
+            handleSetup(conn, req);
+        } else if (req.method == "PLAY") {
+            SessionPtr session = findSession(req);
+            if (!session) {
+                reply(conn, req, "454 Session Not Found");
+                return;
+            }
+            session->playing = true;
+            // 共享流，告诉客户端下一个包的序号和当前RTP时间
+            std::string rtpInfo = "RTP-Info: url=" + session->url
+                + ";seq=" + std::to_string(packetizer.getNextSeq())
+                + ";rtptime=" + std::to_string(packetizer.rtpTime(std::chrono::steady_clock::now())) + "\r\n";
+            reply(conn, req, "200 OK", "Session: " + session->id + "\r\nRange: npt=0.000-\r\n" + rtpInfo);
+            LOG_INFO("rtsp session " << session->id << " play (" << (session->tcp ? "tcp" : "udp") << ", " << session->client << ")");
+        } else if (req.method == "PAUSE") {
+            SessionPtr session = findSession(req);
+            if (!session) {
+                reply(conn, req, "454 Session Not Found");
+                return;
+            }
+            session->playing = false;
+            reply(conn, req, "200 OK", "Session: " + session->id + "\r\n");
+        } else if (req.method == "TEARDOWN") {
+            SessionPtr session = findSession(req);
+            if (session) {
+                removeSession(session->id);
+                if (conn.session == session) {
+                    conn.session.reset();
+                    conn.mailbox.reset();
+                }
+            }
+            reply(conn, req, "200 OK");
+        } else if (req.method == "GET_PARAMETER" || req.method == "SET_PARAMETER") {
+            // 客户端保活
+            SessionPtr session = findSession(req);
+            reply(conn, req, "200 OK", session ? "Session: " + session->id + "\r\n" : std::string());
+        } else {
+            reply(conn, req, "501 Not Implemented");
+        }
+    }
+
+    std::string describe(const Connection& conn) {
+        std::string sdp;
+        sdp += "v=0\r\n";
+        sdp += "o=- " + std::to_string(packetizer.getSsrc()) + " 1 IN IP4 " + conn.local + "\r\n";
+        sdp += "s=Sony Live View\r\n";
+        sdp += "c=IN IP4 0.0.0.0\r\n";
+        sdp += "t=0 0\r\n";
+        sdp += "a=control:*\r\n";
+        sdp += "a=range:npt=0-\r\n";
+        sdp += "m=video 0 RTP/AVP " + std::to_string(RtpJpegFrame::PayloadType) + "\r\n";
+        sdp += "a=rtpmap:" + std::to_string(RtpJpegFrame::PayloadType) + " JPEG/90000\r\n";
+        sdp += "a=control:track1\r\n";
+        return sdp;
+    }
+
+    // 解析 Transport 中 key=a-b 形式的端口/通道对
+    static bool transportPair(const std::string& transport, const std::string& key, int& first, int& second) {
+        size_t pos = transport.find(key + "=");
+        if (pos == std::string::npos) return false;
+        const char* p = transport.c_str() + pos + key.size() + 1;
+        char* end = nullptr;
+        first = static_cast<int>(strtol(p, &end, 10));
+        if (end == p) return false;
+        second = (*end == '-') ? static_cast<int>(strtol(end + 1, nullptr, 10)) : first + 1;
+        return true;
+    }
+
+    void handleSetup(Connection& conn, const Request& req) {
+        std::string transport = req.header("transport");
+        bool tcp = transport.find("RTP/AVP/TCP") != std::string::npos;
+        int first = 0;
+        int second = 0;
+        if (transport.find("multicast") != std::string::npos
+            || (!tcp && !transportPair(transport, "client_port", first, second))) {
+            reply(conn, req, "461 Unsupported Transport");
+            return;
+        }
+        if (tcp && !transportPair(transport, "interleaved", first, second)) {
+            first = 0;
+            second = 1;
+        }
+
+        SessionPtr session = findSession(req);
+        bool created = false;
+        if (!session) {
+            std::lock_guard<std::mutex> lock(sessionsMutex);
+            if (sessions.size() >= MaxSessions) {
+                reply(conn, req, "453 Not Enough Bandwidth");
+                return;
+            }
+            session = std::make_shared<Session>();
+            session->id = newSessionId();
+            session->created = std::chrono::steady_clock::now();
+            session->lastActivity = session->created;
+            created = true;
+        }
+        char ssrc[16];
+        snprintf(ssrc, sizeof(ssrc), "%08X", packetizer.getSsrc());
+        std::string replyTransport;
+        // stats() 会跨线程读取会话字段
+        {
+            std::lock_guard<std::mutex> lock(sessionsMutex);
+            session->url = req.url;
+            session->tcp = tcp;
+            if (tcp) {
+                session->connFd = conn.fd;
+                session->rtpChannel = static_cast<uint8_t>(first);
+                session->rtcpChannel = static_cast<uint8_t>(second);
+                session->client = conn.peer + " (tcp)";
+                conn.session = session;
+                conn.channel = session->rtpChannel;
+                replyTransport = "RTP/AVP/TCP;unicast;interleaved=" + std::to_string(first) + "-" + std::to_string(second);
+            } else {
+                session->connFd = -1;
+                sockaddr_in addr{};
+                addr.sin_family = AF_INET;
+                inet_pton(AF_INET, conn.peer.c_str(), &addr.sin_addr);
+                session->rtpAddr = addr;
+                session->rtpAddr.sin_port = htons(first);
+                session->rtcpAddr = addr;
+                session->rtcpAddr.sin_port = htons(second);
+                session->client = conn.peer + ":" + std::to_string(first);
+                replyTransport = "RTP/AVP;unicast;client_port=" + std::to_string(first) + "-" + std::to_string(second)
+                    + ";server_port=" + std::to_string(serverRtpPort) + "-" + std::to_string(serverRtpPort + 1);
+            }
+            if (created) sessions[session->id] = session;
+        }
+        reply(conn, req, "200 OK", "Transport: " + replyTransport + ";ssrc=" + ssrc + "\r\n"
+              + "Session: " + session->id + ";timeout=" + std::to_string(SessionTimeoutSec) + "\r\n");
+    }
+
+    std::string newSessionId() {
+        char buf[20];
+        snprintf(buf, sizeof(buf), "%016llX", static_cast<unsigned long long>(rng()));
+        return buf;
+    }
+
+    void removeSession(const std::string& id) {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        auto it = sessions.find(id);
+        if (it == sessions.end()) return;
+        LOG_INFO("rtsp session " << id << " closed, frames " << it->second->frames
+            << ", skipped " << it->second->skipped << ", dropped packets " << it->second->dropped);
+        it->second->playing = false;
+        sessions.erase(it);
+    }
+
+    // 把共享槽中的最新帧发给所有播放中的会话
+    void dispatchLatest() {
+        RtpJpegFramePtr frame;
+        {
+            std::lock_guard<std::mutex> lock(latestMutex);
+            frame = std::move(latest);
+            latest.reset();
+        }
+        if (!frame) return;
+        std::vector<SessionPtr> playing;
+        {
+            std::lock_guard<std::mutex> lock(sessionsMutex);
+            for (auto& item : sessions) {
+                if (item.second->playing) playing.push_back(item.second);
+            }
+        }
+        std::vector<int> dead;
+        for (auto& session : playing) {
+            if (!session->tcp) {
+                sendUdp(*session, frame);
+                continue;
+            }
+            auto it = connections.find(session->connFd);
+            if (it == connections.end()) continue;
+            Connection& conn = it->second;
+            if (conn.mailbox) {
+                session->skipped++;
+                skippedTotal.add();
+            }
+            conn.mailbox = frame;
+            if (!flushConnection(conn)) dead.push_back(conn.fd);
+        }
+        for (int fd : dead) dropConnection(fd);
+    }
+
+    // UDP：sendmmsg 批量发送，缓冲区满时丢弃本帧剩余的包，不重试
+    void sendUdp(Session& session, const RtpJpegFramePtr& frame) {
+        mmsghdr msgs[UdpBatch];
+        iovec iovs[UdpBatch][2];
+        size_t total = frame->packetCount();
+        size_t index = 0;
+        size_t sentBytes = 0;
+        while (index < total) {
+            size_t batch = std::min(UdpBatch, total - index);
+            memset(msgs, 0, sizeof(mmsghdr) * batch);
+            for (size_t i = 0; i < batch; ++i) {
+                frame->fill(index + i, iovs[i]);
+                msgs[i].msg_hdr.msg_iov = iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 2;
+                msgs[i].msg_hdr.msg_name = &session.rtpAddr;
+                msgs[i].msg_hdr.msg_namelen = sizeof(session.rtpAddr);
+            }
+            int n = sendmmsg(rtpFd, msgs, static_cast<unsigned int>(batch), MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            for (int i = 0; i < n; ++i) sentBytes += frame->packetSize(index + i);
+            index += n;
+        }
+        session.packets += index;
+        session.bytes += sentBytes;
+        sinkMetrics.addBytes(sentBytes);
+        if (index < total) {
+            session.dropped += total - index;
+            droppedTotal.add(total - index);
+            LOG_EVERY_MS(LogLevel::Warn, 5000, "rtsp udp session " << session.id << " send buffer full, dropped "
+                << (total - index) << " packets");
+        } else {
+            session.frames++;
+            sinkMetrics.observeWire(frame->frame()->timestamp);
+        }
+    }
+
+    // TCP：先发RTSP应答，再按包发送交织数据；应答只插在两个RTP包之间
+    bool flushConnection(Connection& conn) {
+        while (true) {
+            if (conn.packetSent == 0 && conn.outSent < conn.out.size()) {
+                ssize_t written = send(conn.fd, conn.out.data() + conn.outSent, conn.out.size() - conn.outSent, MSG_NOSIGNAL);
+                if (written < 0) {
+                    if (errno == EINTR) continue;
+                    return errno == EAGAIN || errno == EWOULDBLOCK;
+                }
+                conn.outSent += written;
+                conn.lastProgress = std::chrono::steady_clock::now();
+                if (conn.outSent == conn.out.size()) {
+                    conn.out.clear();
+                    conn.outSent = 0;
+                }
+                continue;
+            }
+            if (!conn.sending) {
+                if (!conn.session || !conn.mailbox) return true;
+                conn.sending = std::move(conn.mailbox);
+                conn.mailbox.reset();
+                conn.packetIndex = 0;
+                conn.packetSent = 0;
+            }
+
+            size_t packetSize = conn.sending->packetSize(conn.packetIndex);
+            uint8_t prefix[4] = {'$', conn.channel,
+                                 static_cast<uint8_t>(packetSize >> 8), static_cast<uint8_t>(packetSize & 0xFF)};
+            iovec iov[3];
+            iov[0].iov_base = prefix;
+            iov[0].iov_len = sizeof(prefix);
+            conn.sending->fill(conn.packetIndex, iov + 1);
+            // 跳过上次已发送的部分
+            size_t skip = conn.packetSent;
+            int first = 0;
+            while (skip >= iov[first].iov_len) {
+                skip -= iov[first].iov_len;
+                ++first;
+            }
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + skip;
+            iov[first].iov_len -= skip;
+
+            ssize_t written = writev(conn.fd, iov + first, 3 - first);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            conn.lastProgress = std::chrono::steady_clock::now();
+            conn.packetSent += written;
+            sinkMetrics.addBytes(written);
+            if (conn.session) conn.session->bytes += written;
+            if (conn.packetSent == sizeof(prefix) + packetSize) {
+                conn.packetSent = 0;
+                if (conn.session) conn.session->packets++;
+                if (++conn.packetIndex == conn.sending->packetCount()) {
+                    if (conn.session) conn.session->frames++;
+                    sinkMetrics.observeWire(conn.sending->frame()->timestamp);
+                    conn.sending.reset();
+                } else if (!conn.session) {
+                    // 会话已 TEARDOWN，在包边界停止发送
+                    conn.sending.reset();
+                }
+            }
+        }
+    }
+
+    void readRtcp() {
+        uint8_t buf[1500];
+        while (true) {
+            sockaddr_in from{};
+            socklen_t fromLen = sizeof(from);
+            ssize_t n = recvfrom(rtcpFd, buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            SessionPtr session;
+            {
+                std::lock_guard<std::mutex> lock(sessionsMutex);
+                for (auto& item : sessions) {
+                    const sockaddr_in& addr = item.second->rtcpAddr;
+                    if (!item.second->tcp && addr.sin_addr.s_addr == from.sin_addr.s_addr && addr.sin_port == from.sin_port) {
+                        session = item.second;
+                        break;
+                    }
+                }
+            }
+            if (session) handleRtcp(*session, buf, static_cast<size_t>(n));
+        }
+    }
+
+    // RTCP 复合包：取接收报告（RR/SR）中针对本流的报告块，记录丢包和抖动
+    void handleRtcp(Session& session, const uint8_t* data, size_t size) {
+        session.lastActivity = std::chrono::steady_clock::now();
+        size_t pos = 0;
+        while (pos + 8 <= size) {
+            const uint8_t* p = data + pos;
+            if ((p[0] >> 6) != 2) return;
+            uint8_t count = p[0] & 0x1F;
+            uint8_t type = p[1];
+            size_t length = (static_cast<size_t>((p[2] << 8) | p[3]) + 1) * 4;
+            if (pos + length > size) return;
+            size_t blocks = 0;
+            if (type == 201) blocks = 8;            // RR：头 + 发送者SSRC
+            else if (type == 200) blocks = 28;      // SR：多出20字节发送者信息
+            if (blocks != 0) {
+                for (uint8_t i = 0; i < count && blocks + 24 <= length; ++i, blocks += 24) {
+                    const uint8_t* b = p + blocks;
+                    uint32_t ssrc = (b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+                    if (ssrc != packetizer.getSsrc()) continue;
+                    session.fractionLost = b[4];
+                    session.cumulativeLost = (b[5] << 16) | (b[6] << 8) | b[7];
+                    session.jitter = (b[12] << 24) | (b[13] << 16) | (b[14] << 8) | b[15];
+                }
+            }
+            pos += length;
+        }
+    }
+
+    void expireSessions() {
+        auto now = std::chrono::steady_clock::now();
+        std::vector<std::string> expired;
+        {
+            std::lock_guard<std::mutex> lock(sessionsMutex);
+            for (auto& item : sessions) {
+                if (!item.second->tcp && now - item.second->lastActivity > std::chrono::seconds(SessionTimeoutSec)) {
+                    expired.push_back(item.first);
+                }
+            }
+        }
+        for (auto& id : expired) {
+            LOG_INFO("rtsp session " << id << " timeout");
+            removeSession(id);
+        }
+
+        std::vector<int> stalled;
+        for (auto& item : connections) {
+            const Connection& conn = item.second;
+            bool pending = conn.sending || conn.outSent < conn.out.size();
+            if (pending && now - conn.lastProgress > std::chrono::milliseconds(StallTimeoutMs)) {
+                stalled.push_back(item.first);
+            }
+        }
+        for (int fd : stalled) {
+            LOG_INFO("rtsp connection " << fd << " stalled, disconnect");
+            dropConnection(fd);
+        }
+    }
+
+    // 断开控制连接；TCP 交织会话随连接结束，UDP 会话保留到 TEARDOWN 或超时
+    void dropConnection(int fd) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) return;
+        if (it->second.session) removeSession(it->second.session->id);
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections.erase(it);
+    }
+
+    void updatePlayingCount() {
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(sessionsMutex);
+            for (auto& item : sessions) {
+                if (item.second->playing) ++count;
+            }
+        }
+        if (playingCount.exchange(count) != count) {
+            sessionsGauge.set(count);
+            if (onClientCountChanged) onClientCountChanged(count);
+        }
+    }
+
+    int serverFd = -1;
+    int rtpFd = -1;
+    int rtcpFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    int listenPort = 0;
+    int serverRtpPort = 0;
+    std::unordered_map<int, Connection> connections;
+    std::mutex sessionsMutex;                           // 保护 sessions 的增删，stats() 跨线程读取
+    std::map<std::string, SessionPtr> sessions;
+    std::atomic<size_t> playingCount{0};
+    std::mt19937_64 rng{std::random_device{}()};        // 会话ID，只在IO线程中使用
+    RtpJpegPacketizer packetizer;                       // 只在sink线程打包，IO线程只读SSRC/序号
+    std::mutex latestMutex;
+    RtpJpegFramePtr latest;                             // pushFrame 写入，IO线程取走
+    std::atomic<bool> running{false};
+    std::thread serverThread;
+    std::function<void (size_t)> onClientCountChanged;
+    SinkMetrics sinkMetrics{"rtsp"};
+    MetricGauge& sessionsGauge = Metrics::instance().gauge("rtsp_sessions",
+        "RTSP sessions currently playing");
+    MetricCounter& skippedTotal = Metrics::instance().counter("rtsp_frames_skipped_total",
+        "Frames replaced in a TCP-interleaved session mailbox before they could be sent");
+    MetricCounter& droppedTotal = Metrics::instance().counter("rtsp_udp_packets_dropped_total",
+        "RTP packets dropped because the UDP send buffer was full");
+    MetricCounter& unsupportedTotal = Metrics::instance().counter("rtp_jpeg_unsupported_frames_total",
+        "Live-view frames that could not be packetized as RFC 2435 RTP/JPEG", {{"sink", "rtsp"}});
+};
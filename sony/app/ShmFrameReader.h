@@ -0,0 +1,264 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/**
+ * 共享内存预览帧环：内存布局与只读读取端
+ * 本文件只依赖 libc 和标准库，可以单独拷给本机其他进程（推理服务等）使用。
+ *
+ * 布局：一个 Header，后面紧跟 slotCount 个槽位，每个槽位是 Slot 头 + 最多 slotSize 字节 JPEG，
+ * 槽位按页对齐。写入端按序号 i 写入槽位 i % slotCount：
+ *   - 每个槽位一个 seqlock，写入第 i 帧期间为 2i+1，写完为 2i+2，读取端据此判断数据是否完整、是否已被覆盖；
+ *   - Header::writeSeq 为已发布的帧数，Header::notify 每发布一帧加一，读取端在 notify 上 futex 等待。
+ * 读取端以只读方式映射，直接引用槽位中的JPEG，不拷贝；用完后调用 valid() 确认期间没有被覆盖。
+ */
+namespace ShmFrameRing {
+
+constexpr uint32_t Magic = 0x47525346;     // "FSRG"
+constexpr uint32_t Version = 1;
+
+enum State : uint32_t {
+    Initializing = 0,
+    Running = 1,
+    Closed = 2,         // 写入端已停止，读取端应关闭后重新打开
+};
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;                  // 每个槽位可存放的最大JPEG字节数
+    uint64_t slotStride;                // 相邻槽位的间距
+    uint64_t dataOffset;                // 第一个槽位相对映射起点的偏移
+    uint32_t cameraId;
+    uint32_t writerPid;
+    std::atomic<uint32_t> state;
+    alignas(64) std::atomic<uint64_t> writeSeq;     // 已发布的帧数
+    alignas(64) std::atomic<uint32_t> notify;       // futex 字
+};
+
+struct Slot {
+    std::atomic<uint64_t> seq;          // seqlock
+    uint64_t frameNo;                   // 相机帧序号
+    int64_t monotonicUs;                // 采集时刻，CLOCK_MONOTONIC 微秒
+    int64_t realtimeUs;                 // 采集时刻，CLOCK_REALTIME 微秒
+    uint32_t cameraId;
+    uint32_t size;                      // JPEG 字节数
+    alignas(64) uint8_t data[1];        // 实际长度为 Header::slotSize
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shm ring needs lock-free 64-bit atomics");
+
+constexpr size_t alignUp(size_t value, size_t align) { return (value + align - 1) / align * align; }
+
+inline size_t slotStride(uint32_t slotSize) {
+    return alignUp(offsetof(Slot, data) + slotSize, 4096);
+}
+
+inline size_t mappingSize(uint32_t slotCount, uint32_t slotSize) {
+    return alignUp(sizeof(Header), 4096) + slotStride(slotSize) * slotCount;
+}
+
+inline long futex(std::atomic<uint32_t>* word, int op, uint32_t value, const timespec* timeout) {
+    // 共享映射，不能用 FUTEX_PRIVATE_FLAG
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, timeout, nullptr, 0);
+}
+
+} // namespace ShmFrameRing
+
+/**
+ * 只读读取端
+ *
+ *   ShmFrameReader reader;
+ *   reader.open("/sony_live_0");
+ *   ShmFrameReader::Frame frame;
+ *   while (reader.next(frame, 1000)) {
+ *       infer(frame.data, frame.size);
+ *       if (!reader.valid(frame)) { ... 推理期间槽位被覆盖，结果作废 ... }
+ *   }
+ *
+ * next() 按顺序返回帧，落后超过一圈时跳到仍可读的最旧一帧并计入 skipped()；只关心最新帧时用 latest()。
+ * 一个读取端只在一个线程中使用。
+ */
+class ShmFrameReader {
+public:
+    struct Frame {
+        const uint8_t* data = nullptr;  // 指向共享内存，valid() 为 false 后内容不再可信
+        size_t size = 0;
+        uint64_t seq = 0;               // 环内序号，从0开始连续递增
+        uint64_t frameNo = 0;
+        int64_t monotonicUs = 0;
+        int64_t realtimeUs = 0;
+        uint32_t cameraId = 0;
+    };
+
+    ShmFrameReader() = default;
+    ShmFrameReader(const ShmFrameReader&) = delete;
+    ShmFrameReader& operator=(const ShmFrameReader&) = delete;
+    ~ShmFrameReader() { close(); }
+
+    /**
+     * 打开共享内存
+     * @param name shm_open 名称，如 "/sony_live_0"
+     * @return 不存在、版本不符或写入端尚未就绪时返回 false
+     */
+    bool open(const std::string& name) {
+        close();
+        int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(ShmFrameRing::Header)) {
+            ::close(fd);
+            return false;
+        }
+        void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) return false;
+        base = static_cast<const uint8_t*>(addr);
+        length = st.st_size;
+        header = reinterpret_cast<const ShmFrameRing::Header*>(base);
+        if (header->state.load(std::memory_order_acquire) != ShmFrameRing::Running
+            || header->magic != ShmFrameRing::Magic || header->version != ShmFrameRing::Version
+            || header->slotCount == 0
+            || header->dataOffset + header->slotStride * header->slotCount > length) {
+            close();
+            return false;
+        }
+        // 从当前最新一帧开始读
+        uint64_t written = header->writeSeq.load(std::memory_order_acquire);
+        cursor = written > 0 ? written - 1 : 0;
+        skippedFrames = 0;
+        return true;
+    }
+
+    void close() {
+        if (base) munmap(const_cast<uint8_t*>(base), length);
+        base = nullptr;
+        header = nullptr;
+        length = 0;
+    }
+
+    bool isOpen() const { return header != nullptr; }
+
+    // 写入端已停止或重建了共享内存，需要重新 open
+    bool writerClosed() const {
+        return !header || header->state.load(std::memory_order_acquire) != ShmFrameRing::Running;
+    }
+
+    uint32_t slotCount() const { return header ? header->slotCount : 0; }
+    uint32_t slotSize() const { return header ? header->slotSize : 0; }
+    uint32_t cameraId() const { return header ? header->cameraId : 0; }
+
+    // 因落后被跳过的帧数
+    uint64_t skipped() const { return skippedFrames; }
+
+    /**
+     * 取下一帧，没有新帧时等待
+     * @param timeoutMs 最长等待时间，负数表示一直等
+     * @return 超时或写入端已停止返回 false
+     */
+    bool next(Frame& out, int timeoutMs = -1) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+        for (;;) {
+            if (writerClosed()) return false;
+            // 先取 futex 字再检查条件，避免错过唤醒
+            uint32_t notify = header->notify.load(std::memory_order_acquire);
+            uint64_t written = header->writeSeq.load(std::memory_order_acquire);
+            while (cursor < written) {
+                // 最旧的槽位可能正被改写，从它的下一帧开始才可读
+                uint64_t oldest = written > header->slotCount ? written - header->slotCount + 1 : 0;
+                if (cursor < oldest) {
+                    skippedFrames += oldest - cursor;
+                    cursor = oldest;
+                }
+                if (read(cursor, out)) {
+                    cursor++;
+                    return true;
+                }
+                // 读的过程中被覆盖，重新取 writeSeq
+                written = header->writeSeq.load(std::memory_order_acquire);
+            }
+            if (!wait(notify, timeoutMs, deadline)) return false;
+        }
+    }
+
+    /**
+     * 取最新一帧，跳过中间所有未读的帧
+     * @return 还没有任何帧或写入端已停止返回 false，不等待
+     */
+    bool latest(Frame& out) {
+        for (int retry = 0; retry < 4 && !writerClosed(); ++retry) {
+            uint64_t written = header->writeSeq.load(std::memory_order_acquire);
+            if (written == 0) return false;
+            if (read(written - 1, out)) {
+                if (written - 1 > cursor) skippedFrames += written - 1 - cursor;
+                cursor = written;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 帧在使用期间是否仍然有效（没有被写入端覆盖）
+    bool valid(const Frame& frame) const {
+        if (!header) return false;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot(frame.seq)->seq.load(std::memory_order_relaxed) == (frame.seq + 1) * 2;
+    }
+
+private:
+    const ShmFrameRing::Slot* slot(uint64_t seq) const {
+        return reinterpret_cast<const ShmFrameRing::Slot*>(
+            base + header->dataOffset + header->slotStride * (seq % header->slotCount));
+    }
+
+    // 读取第 seq 帧的元数据，槽位正在写或已被覆盖时返回 false
+    bool read(uint64_t seq, Frame& out) const {
+        const ShmFrameRing::Slot* s = slot(seq);
+        uint64_t expected = (seq + 1) * 2;
+        if (s->seq.load(std::memory_order_acquire) != expected) return false;
+        out.seq = seq;
+        out.frameNo = s->frameNo;
+        out.monotonicUs = s->monotonicUs;
+        out.realtimeUs = s->realtimeUs;
+        out.cameraId = s->cameraId;
+        out.size = s->size > header->slotSize ? header->slotSize : s->size;
+        out.data = s->data;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return s->seq.load(std::memory_order_relaxed) == expected;
+    }
+
+    bool wait(uint32_t notify, int timeoutMs, std::chrono::steady_clock::time_point deadline) {
+        timespec ts;
+        const timespec* timeout = nullptr;
+        if (timeoutMs >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) return false;
+            ts.tv_sec = static_cast<time_t>(left / 1000000000);
+            ts.tv_nsec = static_cast<long>(left % 1000000000);
+            timeout = &ts;
+        }
+        long ret = ShmFrameRing::futex(const_cast<std::atomic<uint32_t>*>(&header->notify), FUTEX_WAIT, notify, timeout);
+        if (ret < 0 && errno == ETIMEDOUT) return false;
+        return true;
+    }
+
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+    const ShmFrameRing::Header* header = nullptr;
+    uint64_t cursor = 0;
+    uint64_t skippedFrames = 0;
+};
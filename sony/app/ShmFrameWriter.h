@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <cctype>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "ShmFrameReader.h"
+#include "FramePool.h"
+#include "Logger.h"
+#include "Metrics.h"
+
+/**
+ * 共享内存预览输出
+ * 把预览JPEG和元数据（帧号、采集时间、相机序号）写入 POSIX 共享内存环，本机的推理等进程
+ * 用 ShmFrameReader 只读映射后直接读取，省去 MJPEG over HTTP 的 TCP、multipart 解析和每帧拷贝。
+ * 布局见 ShmFrameReader.h。写入端从不等待读取端，读取端落后一圈后自行跳帧。
+ * pushFrame 在总线sink线程中调用。
+ */
+class ShmFrameWriter {
+public:
+    struct Config {
+        std::string name;                   // shm_open 名称，需以 /sony_live_ 开头，空则为 /sony_live_<相机序号>
+        uint32_t slotCount = 8;
+        uint32_t slotSize = 2 * 1024 * 1024;    // 超过的帧丢弃
+    };
+
+    struct Stats {
+        std::string name;
+        uint32_t slotCount = 0;
+        uint32_t slotSize = 0;
+        uint64_t frames = 0;
+        uint64_t bytes = 0;
+        uint64_t oversize = 0;              // 超过槽位大小被丢弃的帧数
+    };
+
+    static constexpr const char* NamePrefix = "/sony_live_";
+
+    static std::string defaultName(int cameraId) {
+        return NamePrefix + std::to_string(cameraId);
+    }
+
+    /**
+     * 名称限定在本服务的前缀下，只含字母、数字和 _-.
+     * start() 会删除同名的遗留对象，不能让外部传入的名称删掉其他程序的共享内存
+     */
+    static bool isValidName(const std::string& name) {
+        size_t prefix = strlen(NamePrefix);
+        if (name.size() <= prefix || name.size() > NAME_MAX || name.compare(0, prefix, NamePrefix) != 0) {
+            return false;
+        }
+        for (size_t i = prefix; i < name.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(name[i]);
+            if (!isalnum(c) && c != '_' && c != '-' && c != '.') return false;
+        }
+        return true;
+    }
+
+    bool start(const Config& cfg, uint32_t cameraId) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (header) return true;
+        if (cfg.slotCount < 2 || cfg.slotSize == 0) {
+            LOG_ERROR("shm: invalid ring size " << cfg.slotCount << "x" << cfg.slotSize);
+            return false;
+        }
+        std::string name = cfg.name.empty() ? defaultName(cameraId) : cfg.name;
+        if (!isValidName(name)) {
+            LOG_ERROR("shm: name " << name << " is outside " << NamePrefix << "*");
+            return false;
+        }
+        size_t size = ShmFrameRing::mappingSize(cfg.slotCount, cfg.slotSize);
+
+        // 上次异常退出可能留下同名对象，重新创建，已映射旧对象的读取端看到的状态不会变成 Running
+        // 名称已限定在本服务的前缀下，删除的只会是本服务创建的对象
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            LOG_ERROR("shm: shm_open " << name << " failed: " << strerror(errno));
+            return false;
+        }
+        if (ftruncate(fd, static_cast<off_t>(size)) < 0) {
+            LOG_ERROR("shm: ftruncate " << name << " to " << size << " failed: " << strerror(errno));
+            close(fd);
+            shm_unlink(name.c_str());
+            return false;
+        }
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            LOG_ERROR("shm: mmap " << name << " failed: " << strerror(errno));
+            shm_unlink(name.c_str());
+            return false;
+        }
+
+        // ftruncate 后内容全为0，槽位 seq 为0即“未写入”
+        base = static_cast<uint8_t*>(addr);
+        length = size;
+        header = reinterpret_cast<ShmFrameRing::Header*>(base);
+        header->magic = ShmFrameRing::Magic;
+        header->version = ShmFrameRing::Version;
+        header->slotCount = cfg.slotCount;
+        header->slotSize = cfg.slotSize;
+        header->slotStride = ShmFrameRing::slotStride(cfg.slotSize);
+        header->dataOffset = ShmFrameRing::alignUp(sizeof(ShmFrameRing::Header), 4096);
+        header->cameraId = cameraId;
+        header->writerPid = static_cast<uint32_t>(getpid());
+        header->writeSeq.store(0, std::memory_order_relaxed);
+        header->notify.store(0, std::memory_order_relaxed);
+        header->state.store(ShmFrameRing::Running, std::memory_order_release);
+
+        config = cfg;
+        config.name = name;
+        nextSeq = 0;
+        running = true;
+        LOG_INFO("shm start, " << name << " " << cfg.slotCount << " slots x " << cfg.slotSize << " bytes");
+        return true;
+    }
+
+    bool isRunning() const { return running; }
+
+    // 总线sink线程调用
+    void pushFrame(const FramePtr& frame) {
+        if (!running || !frame || frame->empty()) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!header) return;
+        if (frame->size > header->slotSize) {
+            oversize++;
+            oversizeTotal.add();
+            LOG_EVERY_MS(LogLevel::Warn, 5000, "shm: frame " << frame->frameNo << " of " << frame->size
+                << " bytes exceeds slot size " << header->slotSize << ", dropped");
+            return;
+        }
+
+        // 采集时刻换算到两个系统时钟，读取端可直接和 clock_gettime 比较
+        auto sinceCapture = std::chrono::steady_clock::now() - frame->timestamp;
+        int64_t realtimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            (std::chrono::system_clock::now() - sinceCapture).time_since_epoch()).count();
+        int64_t monotonicUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            frame->timestamp.time_since_epoch()).count();
+
+        uint64_t seq = nextSeq++;
+        ShmFrameRing::Slot* slot = reinterpret_cast<ShmFrameRing::Slot*>(
+            base + header->dataOffset + header->slotStride * (seq % header->slotCount));
+        slot->seq.store(seq * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot->frameNo = frame->frameNo;
+        slot->monotonicUs = monotonicUs;
+        slot->realtimeUs = realtimeUs;
+        slot->cameraId = header->cameraId;
+        slot->size = frame->size;
+        memcpy(slot->data, frame->data(), frame->size);
+        slot->seq.store(seq * 2 + 2, std::memory_order_release);
+
+        header->writeSeq.store(seq + 1, std::memory_order_release);
+        header->notify.fetch_add(1, std::memory_order_release);
+        // 读取端只读映射，无法登记等待者，每帧都唤醒一次；无人等待时只是一次轻量系统调用
+        ShmFrameRing::futex(&header->notify, FUTEX_WAKE, INT_MAX, nullptr);
+
+        frames++;
+        bytes += frame->size;
+        sinkMetrics.addBytes(frame->size);
+        sinkMetrics.observeWire(frame->timestamp);
+    }
+
+    SinkMetrics& metrics() { return sinkMetrics; }
+
+    Stats stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats s;
+        s.name = config.name;
+        s.slotCount = config.slotCount;
+        s.slotSize = config.slotSize;
+        s.frames = frames;
+        s.bytes = bytes;
+        s.oversize = oversize;
+        return s;
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!header) return;
+        running = false;
+        // 先通知读取端再解除映射，读取端自己的映射仍然有效，直到它关闭
+        header->state.store(ShmFrameRing::Closed, std::memory_order_release);
+        header->notify.fetch_add(1, std::memory_order_release);
+        ShmFrameRing::futex(&header->notify, FUTEX_WAKE, INT_MAX, nullptr);
+        munmap(base, length);
+        shm_unlink(config.name.c_str());
+        base = nullptr;
+        header = nullptr;
+        length = 0;
+        LOG_INFO("shm stop, " << config.name << " frames " << frames << ", oversize " << oversize);
+    }
+
+    ~ShmFrameWriter() { stop(); }
+
+private:
+    std::mutex mutex;                       // 保护映射和 config
+    uint8_t* base = nullptr;
+    size_t length = 0;
+    ShmFrameRing::Header* header = nullptr;
+    Config config;
+    uint64_t nextSeq = 0;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> oversize{0};
+    SinkMetrics sinkMetrics{"shm"};
+    MetricCounter& oversizeTotal = Metrics::instance().counter("shm_frames_oversize_total",
+        "Live-view frames dropped because they did not fit a shared-memory slot");
+};
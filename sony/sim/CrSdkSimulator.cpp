@@ -0,0 +1,1881 @@
+/**
+ * CRSDK 模拟后端
+ * 以 USE_CRSDK_SIMULATOR 编译时替代 libCr_Core，实现应用用到的 SCRSDK 接口，
+ * 无需相机即可跑通整个服务：枚举/连接、预览帧、OSD、属性读写、拍照、内容传输及回调。
+ *
+ * 预览帧为预先编码的确定性 JPEG（滚动彩条 + 移动方块 + 帧序号），按相机帧率出帧，
+ * 同一帧周期内重复获取返回 CrWarning_Frame_NotUpdated，与真机行为一致。
+ * 通过环境变量配置（Init 时读取）：
+ *   CRSIM_CAMERAS            枚举到的相机数量（默认 1）
+ *   CRSIM_WIDTH / CRSIM_HEIGHT 预览分辨率（默认 1024x576）
+ *   CRSIM_FPS                相机出帧率（默认 30）
+ *   CRSIM_QUALITY            预览 JPEG 质量，画质 Low 时再降低 30（默认 80）
+ *   CRSIM_DISTINCT_FRAMES    循环使用的不同帧数量（默认 30）
+ *   CRSIM_JPEG_SAMPLING      预览 JPEG 色度采样 420 / 422 / 444（默认 420）
+ *   CRSIM_JPEG_RST           预览 JPEG 重启间隔（MCU 数，写入 DRI），0 表示不用（默认 0）
+ *   CRSIM_LATENCY_US         GetLiveViewImage 固定耗时（默认 0）
+ *   CRSIM_JITTER_US          GetLiveViewImage 额外随机耗时上限（默认 0）
+ *   CRSIM_ERROR_RATE         GetLiveViewImage 返回 CrError_Generic 的概率（默认 0）
+ *   CRSIM_MEMORY_ERROR_RATE  GetLiveViewImage 返回 CrError_Memory_Insufficient 的概率（默认 0）
+ *   CRSIM_DROP_RATE          相机侧丢帧概率，表现为 frameNo 跳号（默认 0）
+ *   CRSIM_CONNECT_DELAY_MS   Connect 到 OnConnected 回调的延迟（默认 200）
+ *   CRSIM_SEED               随机种子，相同种子下注入的错误和丢帧序列一致（默认 1）
+ *
+ * 不支持的接口（固件升级、PTZF、FTP、播放控制等）返回 CrError_Generic_NotSupported。
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+#include <opencv2/opencv.hpp>
+#include "CRSDK/CameraRemote_SDK.h"
+#include "CRSDK/IDeviceCallback.h"
+#include "Logger.h"
+
+namespace SDK = SCRSDK;
+
+namespace {
+
+struct SimConfig {
+    int cameras = 1;
+    int width = 1024;
+    int height = 576;
+    double fps = 30;
+    int quality = 80;
+    int distinctFrames = 30;
+    int jpegSampling = 420;
+    int jpegRestartInterval = 0;
+    int latencyUs = 0;
+    int jitterUs = 0;
+    double errorRate = 0;
+    double memoryErrorRate = 0;
+    double dropRate = 0;
+    int connectDelayMs = 200;
+    uint32_t seed = 1;
+};
+
+long envLong(const char* name, long def, long minValue, long maxValue) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) return def;
+    return std::min(maxValue, std::max(minValue, std::strtol(value, nullptr, 10)));
+}
+
+double envDouble(const char* name, double def, double minValue, double maxValue) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) return def;
+    return std::min(maxValue, std::max(minValue, std::strtod(value, nullptr)));
+}
+
+SimConfig loadConfig() {
+    SimConfig config;
+    config.cameras = envLong("CRSIM_CAMERAS", config.cameras, 0, 16);
+    config.width = envLong("CRSIM_WIDTH", config.width, 64, 4096);
+    config.height = envLong("CRSIM_HEIGHT", config.height, 64, 4096);
+    config.fps = envDouble("CRSIM_FPS", config.fps, 1, 240);
+    config.quality = envLong("CRSIM_QUALITY", config.quality, 1, 100);
+    config.distinctFrames = envLong("CRSIM_DISTINCT_FRAMES", config.distinctFrames, 1, 600);
+    config.jpegSampling = envLong("CRSIM_JPEG_SAMPLING", config.jpegSampling, 420, 444);
+    config.jpegRestartInterval = envLong("CRSIM_JPEG_RST", config.jpegRestartInterval, 0, 65535);
+    config.latencyUs = envLong("CRSIM_LATENCY_US", config.latencyUs, 0, 10000000);
+    config.jitterUs = envLong("CRSIM_JITTER_US", config.jitterUs, 0, 10000000);
+    config.errorRate = envDouble("CRSIM_ERROR_RATE", config.errorRate, 0, 1);
+    config.memoryErrorRate = envDouble("CRSIM_MEMORY_ERROR_RATE", config.memoryErrorRate, 0, 1);
+    config.dropRate = envDouble("CRSIM_DROP_RATE", config.dropRate, 0, 1);
+    config.connectDelayMs = envLong("CRSIM_CONNECT_DELAY_MS", config.connectDelayMs, 0, 60000);
+    config.seed = static_cast<uint32_t>(envLong("CRSIM_SEED", config.seed, 0, 0x7FFFFFFF));
+    return config;
+}
+
+// SDK 数据类的成员是私有的且没有 setter。模拟器自己实现这些类的构造函数：
+// 本线程有待写入的字段时构造函数用它初始化，再把构造出的对象赋值给调用方传入的对象
+struct ImageInfoFields {
+    CrInt32u width;
+    CrInt32u height;
+    CrInt32u bufferSize;
+};
+
+struct ImageDataBlockFields {
+    CrInt32u frameNo;
+    CrInt32u size;
+    CrInt8u* pData;
+    CrInt32u imageSize;
+    CrInt32u timeCode;
+};
+
+struct OSDImageDataBlockFields {
+    CrInt32u frameNo;
+    CrInt8u* pData;
+    CrInt32u imageSize;
+    SDK::CrOSDImageMetaInfo metaInfo;
+};
+
+thread_local const ImageInfoFields* pendingImageInfo = nullptr;
+thread_local const ImageDataBlockFields* pendingImageDataBlock = nullptr;
+thread_local const OSDImageDataBlockFields* pendingOSDImageDataBlock = nullptr;
+
+template <typename Block, typename Fields>
+void assignFields(Block* target, const Fields& fields, const Fields*& pending) {
+    pending = &fields;
+    Block filled;
+    pending = nullptr;
+    *target = filled;
+}
+
+// 预览 JPEG 前预留的头部，模拟真机图像数据不在缓冲区起始处
+const CrInt32u kLiveViewImageOffset = 32;
+
+const int kStillWidth = 1920;
+const int kStillHeight = 1080;
+const int kThumbnailWidth = 160;
+const int kThumbnailHeight = 90;
+
+const char* const kModelNames[] = {
+    "ILCE-7RM4", "ILCE-9M2", "ILCE-7C", "ILCE-7SM3", "ILCE-1", "ILCE-7RM4A", "DSC-RX0M2", "ILCE-7M4",
+    "ILME-FX3", "ILME-FX30", "ILME-FX6", "ILCE-7RM5", "ZV-E1", "ILCE-6700", "ILCE-7CM2", "ILCE-7CR",
+    "ILX-LR1", "MPC-2610", "ILCE-9M3", "ZV-E10M2", "PXW-Z200", "HXR-NX800", "ILCE-1M2", "ILME-FX3A",
+    "BRC-AM7", "ILME-FR7", "ILME-FX2",
+};
+
+std::string modelName(SDK::CrCameraDeviceModelList model) {
+    if (model < sizeof(kModelNames) / sizeof(kModelNames[0])) return kModelNames[model];
+    return "ILCE";
+}
+
+std::string toString(const CrChar* str) {
+    return str ? std::string(str) : std::string();
+}
+
+std::string joinPath(const std::string& dir, const std::string& name) {
+    if (dir.empty()) return name;
+    if (dir.back() == '/') return dir + name;
+    return dir + "/" + name;
+}
+
+CrChar* copyString(const std::string& str) {
+    CrChar* out = new CrChar[str.size() + 1];
+    std::memcpy(out, str.c_str(), str.size() + 1);
+    return out;
+}
+
+template <typename T>
+T* copyArray(const T* src, size_t n) {
+    if (!src || n == 0) return nullptr;
+    T* out = new T[n];
+    std::copy(src, src + n, out);
+    return out;
+}
+
+template <typename T>
+std::vector<CrInt8u> packValues(std::initializer_list<T> values) {
+    std::vector<CrInt8u> out(values.size() * sizeof(T));
+    size_t i = 0;
+    for (T value : values) {
+        std::memcpy(out.data() + i * sizeof(T), &value, sizeof(T));
+        ++i;
+    }
+    return out;
+}
+
+/**
+ * 测试画面：滚动彩条 + 底部移动方块 + 文字
+ * index 决定彩条偏移和方块位置，total 帧为一个循环
+ */
+cv::Mat renderPattern(int width, int height, int index, int total, const std::string& label) {
+    // BGR：白 黄 青 绿 品红 红 蓝
+    static const cv::Scalar bars[] = {
+        cv::Scalar(192, 192, 192), cv::Scalar(0, 192, 192), cv::Scalar(192, 192, 0), cv::Scalar(0, 192, 0),
+        cv::Scalar(192, 0, 192), cv::Scalar(0, 0, 192), cv::Scalar(192, 0, 0),
+    };
+    cv::Mat img(height, width, CV_8UC3, cv::Scalar(24, 24, 24));
+    int barHeight = height * 2 / 3;
+    int barWidth = (width + 6) / 7;
+    int shift = total > 0 ? (index % total) * width / total : 0;
+    for (int i = 0; i < 7; ++i) {
+        int x = (i * barWidth + shift) % width;
+        cv::rectangle(img, cv::Rect(x, 0, barWidth, barHeight), bars[i], cv::FILLED);
+        if (x + barWidth > width) {
+            cv::rectangle(img, cv::Rect(x - width, 0, barWidth, barHeight), bars[i], cv::FILLED);
+        }
+    }
+    int box = std::max(8, height / 8);
+    int travel = std::max(0, width - box);
+    int x = total > 1 ? (index % total) * travel / (total - 1) : 0;
+    cv::rectangle(img, cv::Rect(x, height - box - height / 24, box, box), cv::Scalar(255, 255, 255), cv::FILLED);
+    double scale = height / 480.0;
+    cv::putText(img, label, cv::Point(width / 32, barHeight + static_cast<int>(40 * scale)),
+                cv::FONT_HERSHEY_SIMPLEX, scale, cv::Scalar(255, 255, 255), std::max(1, static_cast<int>(2 * scale)));
+    return img;
+}
+
+std::vector<uchar> encodeJpeg(const cv::Mat& img, int quality, int sampling = 420, int restartInterval = 0) {
+    int factor = sampling == 444 ? cv::IMWRITE_JPEG_SAMPLING_FACTOR_444
+               : sampling == 422 ? cv::IMWRITE_JPEG_SAMPLING_FACTOR_422 : cv::IMWRITE_JPEG_SAMPLING_FACTOR_420;
+    std::vector<uchar> jpeg;
+    cv::imencode(".jpg", img, jpeg, {cv::IMWRITE_JPEG_QUALITY, quality, cv::IMWRITE_JPEG_SAMPLING_FACTOR, factor,
+                                     cv::IMWRITE_JPEG_RST_INTERVAL, restartInterval});
+    return jpeg;
+}
+
+// OSD 与真机一致：640x480 RGBA PNG，透明背景
+std::vector<uchar> renderOsd(const std::string& model) {
+    cv::Mat osd(480, 640, CV_8UC4, cv::Scalar(0, 0, 0, 0));
+    cv::rectangle(osd, cv::Rect(0, 0, 640, 40), cv::Scalar(0, 0, 0, 160), cv::FILLED);
+    cv::putText(osd, model + "  SIM  F4.0  1/60  ISO100", cv::Point(12, 28), cv::FONT_HERSHEY_SIMPLEX, 0.7,
+                cv::Scalar(255, 255, 255, 255), 2);
+    cv::rectangle(osd, cv::Rect(280, 200, 80, 80), cv::Scalar(0, 255, 0, 255), 2);
+    std::vector<uchar> png;
+    cv::imencode(".png", osd, png);
+    return png;
+}
+
+bool writeFile(const std::string& path, const std::vector<uchar>& data) {
+    std::ofstream file(path, std::ios::out | std::ios::binary);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return static_cast<bool>(file);
+}
+
+std::tm localTime(std::time_t t) {
+    std::tm tm;
+    localtime_r(&t, &tm);
+    return tm;
+}
+
+CrInt32u dayKey(std::time_t t) {
+    std::tm tm = localTime(t);
+    return static_cast<CrInt32u>((tm.tm_year + 1900) * 10000 + (tm.tm_mon + 1) * 100 + tm.tm_mday);
+}
+
+SDK::CrCaptureDate captureDate(std::time_t t) {
+    std::tm tm = localTime(t);
+    SDK::CrCaptureDate date;
+    date.year = static_cast<CrInt16u>(tm.tm_year + 1900);
+    date.month = static_cast<CrInt16u>(tm.tm_mon + 1);
+    date.day = static_cast<CrInt16u>(tm.tm_mday);
+    date.hour = static_cast<CrInt16u>(tm.tm_hour);
+    date.minute = static_cast<CrInt16u>(tm.tm_min);
+    date.sec = static_cast<CrInt16u>(tm.tm_sec);
+    date.msec = 0;
+    return date;
+}
+
+class SimCameraObjectInfo final : public SDK::ICrCameraObjectInfo {
+public:
+    std::string name;
+    std::string model;
+    std::string connectionType;
+    std::string adaptor;
+    std::string guid;
+    std::string pairing;
+    std::string ipChar;
+    std::string macChar;
+    std::vector<CrInt8u> id;   // 末尾附加 '\0'，不计入 GetIdSize
+    std::vector<CrInt8u> mac;
+    CrInt32u idType = 0;
+    CrInt16 usbPid = 0;
+    CrInt32u ssh = SDK::CrSSHsupport_OFF;
+    CrInt32u ip = 0;
+
+    void setId(const CrInt8u* data, CrInt32u size) {
+        id.assign(data, data + size);
+        id.push_back(0);
+    }
+
+    void Release() override { delete this; }
+    CrChar* GetName() const override { return str(name); }
+    CrInt32u GetNameSize() const override { return name.size(); }
+    CrChar* GetModel() const override { return str(model); }
+    CrInt32u GetModelSize() const override { return model.size(); }
+    CrInt16 GetUsbPid() const override { return usbPid; }
+    CrInt8u* GetId() const override { return const_cast<CrInt8u*>(id.data()); }
+    CrInt32u GetIdSize() const override { return id.empty() ? 0 : id.size() - 1; }
+    CrInt32u GetIdType() const override { return idType; }
+    CrInt32u GetConnectionStatus() const override { return 0; }
+    CrChar* GetConnectionTypeName() const override { return str(connectionType); }
+    CrChar* GetAdaptorName() const override { return str(adaptor); }
+    CrChar* GetGuid() const override { return str(guid); }
+    CrChar* GetPairingNecessity() const override { return str(pairing); }
+    CrInt16u GetAuthenticationState() const override { return 0; }
+    CrInt32u GetSSHsupport() const override { return ssh; }
+    CrInt32u GetIPAddress() const override { return ip; }
+    CrChar* GetIPAddressChar() const override { return str(ipChar); }
+    CrInt32u GetIPAddressCharSize() const override { return ipChar.size(); }
+    CrInt8u* GetMACAddress() const override { return const_cast<CrInt8u*>(mac.data()); }
+    CrInt32u GetMACAddressSize() const override { return mac.size(); }
+    CrChar* GetMACAddressChar() const override { return str(macChar); }
+    CrInt32u GetMACAddressCharSize() const override { return macChar.size(); }
+
+private:
+    static CrChar* str(const std::string& s) { return const_cast<CrChar*>(s.c_str()); }
+};
+
+class SimEnumCameraObjectInfo final : public SDK::ICrEnumCameraObjectInfo {
+public:
+    std::vector<SimCameraObjectInfo*> cameras;
+
+    ~SimEnumCameraObjectInfo() {
+        for (auto camera : cameras) camera->Release();
+    }
+
+    CrInt32u GetCount() const override { return cameras.size(); }
+    const SDK::ICrCameraObjectInfo* GetCameraObjectInfo(CrInt32u index) const override {
+        return index < cameras.size() ? cameras[index] : nullptr;
+    }
+    void Release() override { delete this; }
+};
+
+struct SimProperty {
+    SDK::CrDataType type = SDK::CrDataType_UInt16;
+    SDK::CrPropertyEnableFlag enable = SDK::CrEnableValue_True;
+    CrInt64u current = 0;
+    std::vector<CrInt8u> values;  // 候选值，按 type 的元素宽度紧密排列
+};
+
+struct SimContent {
+    CrInt32u id = 0;         // 同时作为 MTP content handle 和远程传输 contentsId
+    std::string fileName;    // DSC00001.JPG
+    std::time_t captured = 0;
+    std::vector<uchar> jpeg;
+};
+
+/**
+ * 一台已连接的模拟相机
+ * 状态由 mutex 保护；回调统一在 dispatcher 线程中按投递顺序执行，调用时不持有 mutex
+ */
+class SimDevice {
+public:
+    SimDevice(SDK::CrDeviceHandle handle, const SimConfig& config, const SimCameraObjectInfo& info,
+              SDK::IDeviceCallback* callback, SDK::CrSdkControlMode mode)
+        : handle(handle), config(config), model(info.model), callback(callback),
+          epoch(std::chrono::steady_clock::now()), rng(config.seed + static_cast<uint32_t>(handle)) {
+        label = "SIM " + std::to_string(handle);
+        initProperties(mode);
+        settings[SDK::Setting_Key_EnableLiveView] = 1;
+        renderFrames();
+        osd = renderOsd(model);
+        // 预置几张照片，内容传输模式下有内容可列
+        std::time_t now = std::time(nullptr);
+        for (int i = 0; i < 3; ++i) addContent(now - (3 - i) * 60);
+        dispatcher = std::thread(&SimDevice::dispatchLoop, this);
+    }
+
+    ~SimDevice() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueCv.notify_all();
+        if (dispatcher.get_id() == std::this_thread::get_id()) {
+            dispatcher.detach();
+        } else if (dispatcher.joinable()) {
+            dispatcher.join();
+        }
+    }
+
+    // 投递回调，delayMs 后在 dispatcher 线程执行
+    void post(std::function<void ()> task, int delayMs = 0) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back({std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs), std::move(task)});
+        }
+        queueCv.notify_one();
+    }
+
+    // 以下调用方需持有 mutex
+    void renderFrames() {
+        int quality = config.quality;
+        auto it = properties.find(SDK::CrDeviceProperty_LiveView_Image_Quality);
+        if (it != properties.end() && it->second.current == SDK::CrPropertyLiveViewImageQuality_Low) {
+            quality = std::max(10, quality - 30);
+        }
+        frames.clear();
+        size_t largest = 0;
+        for (int i = 0; i < config.distinctFrames; ++i) {
+            cv::Mat img = renderPattern(config.width, config.height, i, config.distinctFrames,
+                                        label + "  #" + std::to_string(i));
+            frames.push_back(encodeJpeg(img, quality, config.jpegSampling, config.jpegRestartInterval));
+            largest = std::max(largest, frames.back().size());
+        }
+        // 与真机一样给出带余量的缓冲区大小，按 4KB 对齐
+        bufferSize = static_cast<CrInt32u>((largest + kLiveViewImageOffset + 65536 + 4095) / 4096 * 4096);
+    }
+
+    const SimContent& addContent(std::time_t captured) {
+        SimContent content;
+        content.id = nextContentId++;
+        CrInt32 number = saveNo >= 0 ? saveNo++ : static_cast<CrInt32>(content.id);
+        char name[32];
+        std::snprintf(name, sizeof(name), "%05d.JPG", static_cast<int>(number % 100000));
+        content.fileName = savePrefix + name;
+        content.captured = captured;
+        cv::Mat img = renderPattern(kStillWidth, kStillHeight, content.id, config.distinctFrames,
+                                    label + "  " + content.fileName);
+        content.jpeg = encodeJpeg(img, 95);
+        contents.push_back(std::move(content));
+        return contents.back();
+    }
+
+    SimContent* findContent(CrInt32u id) {
+        for (auto& content : contents) {
+            if (content.id == id) return &content;
+        }
+        return nullptr;
+    }
+
+    std::vector<uchar> thumbnail(const SimContent& content, int width, int height) const {
+        return encodeJpeg(renderPattern(width, height, content.id, config.distinctFrames, content.fileName), 80);
+    }
+
+    const SDK::CrDeviceHandle handle;
+    const SimConfig config;
+    const std::string model;
+    SDK::IDeviceCallback* const callback;
+
+    std::mutex mutex;
+    bool connected = false;
+    std::string label;
+    std::map<CrInt32u, SimProperty> properties;
+    std::map<CrInt32u, CrInt32u> settings;
+    std::vector<std::vector<uchar>> frames;
+    CrInt32u bufferSize = 0;
+    std::vector<uchar> osd;
+    CrInt32u osdFrameNo = 0;
+    std::chrono::steady_clock::time_point epoch;
+    int64_t lastTick = -1;
+    CrInt32u droppedFrames = 0;
+    std::mt19937 rng;
+    std::string savePath;
+    std::string savePrefix = "DSC";
+    CrInt32 saveNo = -1;
+    CrInt32u nextContentId = 1;
+    std::vector<SimContent> contents;
+
+private:
+    struct Task {
+        std::chrono::steady_clock::time_point due;
+        std::function<void ()> run;
+    };
+
+    void initProperties(SDK::CrSdkControlMode mode) {
+        auto add = [this](CrInt32u code, SDK::CrDataType type, CrInt64u current, std::vector<CrInt8u> values) {
+            SimProperty& prop = properties[code];
+            prop.type = type;
+            prop.current = current;
+            prop.values = std::move(values);
+        };
+        add(SDK::CrDeviceProperty_SdkControlMode, SDK::CrDataType_UInt32, mode,
+            packValues<CrInt32u>({SDK::CrSdkControlMode_Remote, SDK::CrSdkControlMode_ContentsTransfer,
+                                  SDK::CrSdkControlMode_RemoteTransfer}));
+        add(SDK::CrDeviceProperty_FNumber, SDK::CrDataType_UInt16, 400,
+            packValues<CrInt16u>({350, 400, 560, 800, 1100, 1600}));
+        add(SDK::CrDeviceProperty_ShutterSpeed, SDK::CrDataType_UInt32, 0x0001003C,
+            packValues<CrInt32u>({0x0001001E, 0x0001003C, 0x0001007D, 0x000100FA, 0x000101F4}));
+        add(SDK::CrDeviceProperty_IsoSensitivity, SDK::CrDataType_UInt32, 100,
+            packValues<CrInt32u>({100, 200, 400, 800, 1600, 3200, 6400}));
+        add(SDK::CrDeviceProperty_ExposureProgramMode, SDK::CrDataType_UInt32, SDK::CrExposure_P_Auto,
+            packValues<CrInt32u>({SDK::CrExposure_M_Manual, SDK::CrExposure_P_Auto, SDK::CrExposure_A_AperturePriority,
+                                  SDK::CrExposure_S_ShutterSpeedPriority}));
+        add(SDK::CrDeviceProperty_FocusMode, SDK::CrDataType_UInt16, SDK::CrFocus_AF_C,
+            packValues<CrInt16u>({SDK::CrFocus_MF, SDK::CrFocus_AF_S, SDK::CrFocus_AF_C}));
+        add(SDK::CrDeviceProperty_S1, SDK::CrDataType_UInt16, SDK::CrLockIndicator_Unlocked,
+            packValues<CrInt16u>({SDK::CrLockIndicator_Unlocked, SDK::CrLockIndicator_Locked}));
+        add(SDK::CrDeviceProperty_Zoom_Operation_Status, SDK::CrDataType_UInt8, SDK::CrZoomOperationEnableStatus_Enable,
+            packValues<CrInt8u>({SDK::CrZoomOperationEnableStatus_Disable, SDK::CrZoomOperationEnableStatus_Enable}));
+        add(SDK::CrDeviceProperty_Zoom_Speed_Range, SDK::CrDataType_Int8Array, 0, packValues<CrInt8>({-8, 8}));
+        add(SDK::CrDeviceProperty_Zoom_Operation, SDK::CrDataType_Int8, 0, packValues<CrInt8>({-8, 8}));
+        add(SDK::CrDeviceProperty_OSDImageMode, SDK::CrDataType_UInt8, SDK::CrOSDImageMode_Off,
+            packValues<CrInt8u>({SDK::CrOSDImageMode_Off, SDK::CrOSDImageMode_On}));
+        add(SDK::CrDeviceProperty_LiveView_Image_Quality, SDK::CrDataType_UInt16, SDK::CrPropertyLiveViewImageQuality_High,
+            packValues<CrInt16u>({SDK::CrPropertyLiveViewImageQuality_Low, SDK::CrPropertyLiveViewImageQuality_High}));
+    }
+
+    void dispatchLoop() {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        while (!stopping) {
+            if (queue.empty()) {
+                queueCv.wait(lock);
+                continue;
+            }
+            auto due = queue.front().due;
+            if (std::chrono::steady_clock::now() < due) {
+                queueCv.wait_until(lock, due);
+                continue;
+            }
+            auto task = std::move(queue.front().run);
+            queue.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::thread dispatcher;
+    std::mutex queueMutex;
+    std::condition_variable queueCv;
+    std::deque<Task> queue;
+    bool stopping = false;
+};
+
+typedef std::shared_ptr<SimDevice> SimDevicePtr;
+
+std::mutex g_mutex;
+bool g_initialized = false;
+SimConfig g_config;
+SDK::CrDeviceHandle g_nextHandle = 1;
+std::map<SDK::CrDeviceHandle, SimDevicePtr> g_devices;
+// GetDeviceProperties 返回的属性数组所引用的候选值存储，ReleaseDeviceProperties 时释放
+std::map<const SDK::CrDeviceProperty*, std::vector<std::vector<CrInt8u>>> g_propertyStorage;
+
+SimDevicePtr findDevice(SDK::CrDeviceHandle handle) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = g_devices.find(handle);
+    return it == g_devices.end() ? nullptr : it->second;
+}
+
+SimCameraObjectInfo* newUsbCamera(const std::string& model, const std::string& serial) {
+    auto info = new SimCameraObjectInfo();
+    info->name = model;
+    info->model = model;
+    info->connectionType = "USB";
+    info->adaptor = "CRSDK Simulator";
+    info->pairing = "OFF";
+    info->idType = 1;
+    info->usbPid = 0x0E7B;
+    std::string id = serial;
+    id.resize(SDK::USB_SERIAL_LENGTH, '0');
+    info->setId(reinterpret_cast<const CrInt8u*>(id.data()), id.size());
+    return info;
+}
+
+SDK::CrError fillDeviceProperties(SimDevice& device, const std::vector<CrInt32u>& codes,
+                                  SDK::CrDeviceProperty** properties, CrInt32* numOfProperties) {
+    if (!properties || !numOfProperties) return SDK::CrError_Generic_InvalidParameter;
+    *properties = nullptr;
+    *numOfProperties = 0;
+    std::vector<const std::pair<const CrInt32u, SimProperty>*> selected;
+    std::vector<std::vector<CrInt8u>> storage;
+    {
+        std::lock_guard<std::mutex> lock(device.mutex);
+        for (const auto& item : device.properties) {
+            if (codes.empty() || std::find(codes.begin(), codes.end(), item.first) != codes.end()) {
+                selected.push_back(&item);
+                storage.push_back(item.second.values);
+            }
+        }
+        if (selected.empty()) return SDK::CrError_None;
+        auto list = new SDK::CrDeviceProperty[selected.size()];
+        for (size_t i = 0; i < selected.size(); ++i) {
+            const SimProperty& prop = selected[i]->second;
+            SDK::CrDeviceProperty& out = list[i];
+            out.SetCode(selected[i]->first);
+            out.SetValueType(prop.type);
+            out.SetPropertyEnableFlag(prop.enable);
+            out.SetPropertyVariableFlag(SDK::CrEnableValue_Variable);
+            out.SetCurrentValue(prop.current);
+            out.SetValueSize(storage[i].size());
+            out.SetValues(storage[i].empty() ? nullptr : storage[i].data());
+            out.SetSetValueSize(storage[i].size());
+            out.SetSetValues(storage[i].empty() ? nullptr : storage[i].data());
+        }
+        *properties = list;
+        *numOfProperties = static_cast<CrInt32>(selected.size());
+    }
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_propertyStorage[*properties] = std::move(storage);
+    return SDK::CrError_None;
+}
+
+SDK::CrError fillLiveViewProperties(SimDevice& device, const std::vector<CrInt32u>& codes,
+                                    SDK::CrLiveViewProperty** properties, CrInt32* numOfProperties) {
+    if (!properties || !numOfProperties) return SDK::CrError_Generic_InvalidParameter;
+    *properties = nullptr;
+    *numOfProperties = 0;
+    // 模拟机只上报对焦框属性，且当前无对焦框
+    CrInt32u code = SDK::CrLiveViewProperty_AF_Area_Position;
+    if (!codes.empty() && std::find(codes.begin(), codes.end(), code) == codes.end()) return SDK::CrError_None;
+    auto list = new SDK::CrLiveViewProperty[1];
+    list[0].SetCode(code);
+    list[0].SetPropertyEnableFlag(SDK::CrEnableValue_False);
+    list[0].SetFrameInfoType(SDK::CrFrameInfoType_FocusFrameInfo);
+    *properties = list;
+    *numOfProperties = 1;
+    return SDK::CrError_None;
+}
+
+// 把内容写到 dir/name，返回完整路径；失败返回空
+std::string saveContent(const std::string& dir, const std::string& name, const std::vector<uchar>& data) {
+    std::string path = joinPath(dir, name);
+    if (!writeFile(path, data)) {
+        LOG_WARN("[sim] write " << path << " failed");
+        return std::string();
+    }
+    return path;
+}
+
+// 拍照：生成新照片并模拟下载到 SetSaveInfo 指定的目录
+void capture(SimDevice* device) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(device->mutex);
+        if (!device->connected) return;
+        const SimContent& content = device->addContent(std::time(nullptr));
+        path = saveContent(device->savePath, content.fileName, content.jpeg);
+    }
+    if (path.empty()) return;
+    device->callback->OnCompleteDownload(const_cast<CrChar*>(path.c_str()), SDK::CrDownloadSettingFileType_None);
+    device->callback->OnNotifyRemoteTransferContentsListChanged(SDK::CrNotify_RemoteTransfer_Changed_Add,
+                                                                SDK::CrSlotNumber_Slot1, 1);
+}
+
+bool matchesDate(const SDK::CrCaptureDate& date, std::time_t t, SDK::CrGetContentsInfoListType type) {
+    SDK::CrCaptureDate other = captureDate(t);
+    switch (type) {
+    case SDK::CrGetContentsInfoListType_Range_Hour:
+        if (date.hour != other.hour) return false;
+        // fallthrough
+    case SDK::CrGetContentsInfoListType_Range_Day:
+        if (date.day != other.day) return false;
+        // fallthrough
+    case SDK::CrGetContentsInfoListType_Range_Month:
+        return date.year == other.year && date.month == other.month;
+    default:
+        return true;
+    }
+}
+
+} // namespace
+
+namespace SCRSDK {
+
+/* ---------------- SDK 数据类 ---------------- */
+
+CrCaptureDate::CrCaptureDate() : year(0), month(0), day(0), hour(0), minute(0), sec(0), msec(0) {}
+CrCaptureDate::~CrCaptureDate() {}
+
+CrCaptureDate::CrCaptureDate(const CrInt64u& unixTime) {
+    std::time_t t = static_cast<std::time_t>(unixTime);
+    std::tm tm;
+    gmtime_r(&t, &tm);
+    year = static_cast<CrInt16u>(tm.tm_year + 1900);
+    month = static_cast<CrInt16u>(tm.tm_mon + 1);
+    day = static_cast<CrInt16u>(tm.tm_mday);
+    hour = static_cast<CrInt16u>(tm.tm_hour);
+    minute = static_cast<CrInt16u>(tm.tm_min);
+    sec = static_cast<CrInt16u>(tm.tm_sec);
+    msec = 0;
+}
+
+CrCaptureDate::CrCaptureDate(const CrCaptureDate& ref) = default;
+CrCaptureDate& CrCaptureDate::operator =(const CrCaptureDate& ref) = default;
+
+bool CrCaptureDate::operator ==(const CrCaptureDate& ref) {
+    return year == ref.year && month == ref.month && day == ref.day && hour == ref.hour
+        && minute == ref.minute && sec == ref.sec && msec == ref.msec;
+}
+
+CrContentsFile::CrContentsFile()
+    : fileId(0), filePathLength(0), filePath(nullptr), fileFormat(CrContentsFile_FileFormat_Unspecified), fileSize(0),
+      umid(), isImageParamExsist(false), imageParam(), isVideoParamExsist(false), videoParam(),
+      isAudioParamExsist(false), audioParam() {}
+
+CrContentsFile::~CrContentsFile() {
+    delete[] filePath;
+}
+
+CrContentsFile::CrContentsFile(const CrContentsFile& ref) : filePath(nullptr) {
+    *this = ref;
+}
+
+CrContentsFile& CrContentsFile::operator =(const CrContentsFile& ref) {
+    if (this == &ref) return *this;
+    delete[] filePath;
+    fileId = ref.fileId;
+    filePathLength = ref.filePathLength;
+    filePath = copyArray(ref.filePath, ref.filePathLength);
+    fileFormat = ref.fileFormat;
+    fileSize = ref.fileSize;
+    std::memcpy(umid, ref.umid, sizeof(umid));
+    isImageParamExsist = ref.isImageParamExsist;
+    imageParam = ref.imageParam;
+    isVideoParamExsist = ref.isVideoParamExsist;
+    videoParam = ref.videoParam;
+    isAudioParamExsist = ref.isAudioParamExsist;
+    audioParam = ref.audioParam;
+    return *this;
+}
+
+CrContentsInfo::CrContentsInfo()
+    : contentType(CrContentsInfo_ContentType_Unspecified), contentId(0), dirNumber(0), fileNumber(0),
+      groupType(CrContentsInfo_GroupType_Unspecified), groupId(0), representative(false),
+      rating(CrContentsInfo_Rating_Nothing), protectionStatus(false), dummyContent(false), shotMarkNum(0),
+      shotMark(nullptr), filesNum(0), files(nullptr) {}
+
+CrContentsInfo::~CrContentsInfo() {
+    delete[] shotMark;
+    delete[] files;
+}
+
+CrContentsInfo::CrContentsInfo(const CrContentsInfo& ref) : shotMark(nullptr), files(nullptr) {
+    *this = ref;
+}
+
+CrContentsInfo& CrContentsInfo::operator =(const CrContentsInfo& ref) {
+    if (this == &ref) return *this;
+    delete[] shotMark;
+    delete[] files;
+    contentType = ref.contentType;
+    contentId = ref.contentId;
+    dirNumber = ref.dirNumber;
+    fileNumber = ref.fileNumber;
+    groupType = ref.groupType;
+    groupId = ref.groupId;
+    representative = ref.representative;
+    creationDatetimeUTC = ref.creationDatetimeUTC;
+    modificationDatetimeUTC = ref.modificationDatetimeUTC;
+    creationDatetimeLocaltime = ref.creationDatetimeLocaltime;
+    modificationDatetimeLocaltime = ref.modificationDatetimeLocaltime;
+    rating = ref.rating;
+    protectionStatus = ref.protectionStatus;
+    dummyContent = ref.dummyContent;
+    shotMarkNum = ref.shotMarkNum;
+    shotMark = copyArray(ref.shotMark, ref.shotMarkNum);
+    filesNum = ref.filesNum;
+    files = copyArray(ref.files, ref.filesNum);
+    return *this;
+}
+
+// CrDeviceProperty 不持有内存：SetCurrentStr/SetValues 的指针由调用方或属性列表管理
+CrDeviceProperty::CrDeviceProperty()
+    : code(0), valueType(CrDataType_Undefined), enableFlag(CrEnableValue_NotSupported),
+      variableFlag(CrEnableValue_Invalid), currentValue(0), currentStr(nullptr), valuesSize(0), values(nullptr),
+      getSetValuesSize(0), getSetValues(nullptr) {}
+
+CrDeviceProperty::~CrDeviceProperty() {}
+CrDeviceProperty::CrDeviceProperty(const CrDeviceProperty& ref) = default;
+CrDeviceProperty& CrDeviceProperty::operator =(const CrDeviceProperty& ref) = default;
+
+void CrDeviceProperty::Alloc(const CrInt32u size, const CrInt32u getSetSize, const CrInt16u getStrSize) {}
+
+bool CrDeviceProperty::IsGetEnableCurrentValue() const {
+    return enableFlag == CrEnableValue_True || enableFlag == CrEnableValue_DisplayOnly;
+}
+
+bool CrDeviceProperty::IsSetEnableCurrentValue() const {
+    return enableFlag == CrEnableValue_True || enableFlag == CrEnableValue_SetOnly;
+}
+
+void CrDeviceProperty::SetCode(CrInt32u code) { this->code = code; }
+CrInt32u CrDeviceProperty::GetCode() const { return code; }
+void CrDeviceProperty::SetValueType(CrDataType type) { valueType = type; }
+CrDataType CrDeviceProperty::GetValueType() const { return valueType; }
+void CrDeviceProperty::SetPropertyEnableFlag(CrPropertyEnableFlag flag) { enableFlag = flag; }
+CrPropertyEnableFlag CrDeviceProperty::GetPropertyEnableFlag() const { return enableFlag; }
+void CrDeviceProperty::SetPropertyVariableFlag(CrPropertyVariableFlag flag) { variableFlag = flag; }
+CrPropertyVariableFlag CrDeviceProperty::GetPropertyVariableFlag() const { return variableFlag; }
+void CrDeviceProperty::SetCurrentValue(CrInt64u value) { currentValue = value; }
+CrInt64u CrDeviceProperty::GetCurrentValue() const { return currentValue; }
+void CrDeviceProperty::SetCurrentStr(CrInt16u* str) { currentStr = str; }
+CrInt16u* CrDeviceProperty::GetCurrentStr() const { return currentStr; }
+void CrDeviceProperty::SetValueSize(CrInt32u size) { valuesSize = size; }
+CrInt32u CrDeviceProperty::GetValueSize() const { return valuesSize; }
+void CrDeviceProperty::SetValues(CrInt8u* value) { values = value; }
+CrInt8u* CrDeviceProperty::GetValues() const { return values; }
+void CrDeviceProperty::SetSetValueSize(CrInt32u size) { getSetValuesSize = size; }
+CrInt32u CrDeviceProperty::GetSetValueSize() const { return getSetValuesSize; }
+void CrDeviceProperty::SetSetValues(CrInt8u* value) { getSetValues = value; }
+CrInt8u* CrDeviceProperty::GetSetValues() const { return getSetValues; }
+CrInt32u CrDeviceProperty::GetDisplayValueSize() const { return valuesSize; }
+CrInt8u* CrDeviceProperty::GetDisplayValues() const { return values; }
+
+CrDisplayStringListInfo::CrDisplayStringListInfo()
+    : dataType(CrDataType_Undefined), listType(), value(0), displayStringSize(0), displayString(nullptr) {}
+
+CrDisplayStringListInfo::~CrDisplayStringListInfo() {
+    delete[] displayString;
+}
+
+CrDisplayStringListInfo::CrDisplayStringListInfo(const CrDisplayStringListInfo& ref) : displayString(nullptr) {
+    *this = ref;
+}
+
+CrDisplayStringListInfo& CrDisplayStringListInfo::operator =(const CrDisplayStringListInfo& ref) {
+    if (this == &ref) return *this;
+    delete[] displayString;
+    dataType = ref.dataType;
+    listType = ref.listType;
+    value = ref.value;
+    displayStringSize = ref.displayStringSize;
+    displayString = copyArray(ref.displayString, ref.displayStringSize);
+    return *this;
+}
+
+void CrDisplayStringListInfo::Alloc(const CrInt32u size) {
+    delete[] displayString;
+    displayStringSize = size;
+    displayString = size ? new CrInt8u[size]() : nullptr;
+}
+
+CrImageInfo::CrImageInfo() : width(0), height(0), bufferSize(0) {
+    if (pendingImageInfo) {
+        width = pendingImageInfo->width;
+        height = pendingImageInfo->height;
+        bufferSize = pendingImageInfo->bufferSize;
+    }
+}
+CrImageInfo::~CrImageInfo() {}
+CrInt32u CrImageInfo::GetBufferSize() const { return bufferSize; }
+
+CrImageDataBlock::CrImageDataBlock() : frameNo(0), size(0), pData(nullptr), imageSize(0), timeCode(0) {
+    if (pendingImageDataBlock) {
+        frameNo = pendingImageDataBlock->frameNo;
+        size = pendingImageDataBlock->size;
+        pData = pendingImageDataBlock->pData;
+        imageSize = pendingImageDataBlock->imageSize;
+        timeCode = pendingImageDataBlock->timeCode;
+    }
+}
+CrImageDataBlock::~CrImageDataBlock() {}
+CrInt32u CrImageDataBlock::GetFrameNo() const { return frameNo; }
+void CrImageDataBlock::SetSize(CrInt32u size) { this->size = size; }
+CrInt32u CrImageDataBlock::GetSize() const { return size; }
+void CrImageDataBlock::SetData(CrInt8u* data) { pData = data; }
+CrInt32u CrImageDataBlock::GetImageSize() const { return imageSize; }
+CrInt8u* CrImageDataBlock::GetImageData() const { return pData; }
+CrInt32u CrImageDataBlock::GetTimeCode() const { return timeCode; }
+
+CrOSDImageMetaInfo::CrOSDImageMetaInfo()
+    : isLvPosExist(CrIsLvPosExist_Disable), osdWidth(0), osdHeight(0), lvPosX(0), lvPosY(0), lvWidth(0),
+      lvHeight(0), degree(0) {}
+CrOSDImageMetaInfo::~CrOSDImageMetaInfo() {}
+
+CrOSDImageDataBlock::CrOSDImageDataBlock() : frameNo(0), pData(nullptr), imageSize(0) {
+    if (pendingOSDImageDataBlock) {
+        frameNo = pendingOSDImageDataBlock->frameNo;
+        pData = pendingOSDImageDataBlock->pData;
+        imageSize = pendingOSDImageDataBlock->imageSize;
+        metaInfo = pendingOSDImageDataBlock->metaInfo;
+    }
+}
+CrOSDImageDataBlock::~CrOSDImageDataBlock() {}
+CrInt32u CrOSDImageDataBlock::GetFrameNo() const { return frameNo; }
+CrInt32u CrOSDImageDataBlock::GetImageSize() const { return imageSize; }
+CrInt8u* CrOSDImageDataBlock::GetImageData() const { return pData; }
+void CrOSDImageDataBlock::SetData(CrInt8u* data) { pData = data; }
+CrOSDImageMetaInfo CrOSDImageDataBlock::GetMetaInfo() const { return metaInfo; }
+
+CrLiveViewProperty::CrLiveViewProperty()
+    : code(0), enableFlag(CrEnableValue_NotSupported), valueType(CrFrameInfoType_Unknown), valueSize(0),
+      value(nullptr), timeCode(0) {}
+
+CrLiveViewProperty::~CrLiveViewProperty() {
+    delete[] value;
+}
+
+CrLiveViewProperty::CrLiveViewProperty(const CrLiveViewProperty& ref) : value(nullptr) {
+    *this = ref;
+}
+
+CrLiveViewProperty& CrLiveViewProperty::operator =(const CrLiveViewProperty& ref) {
+    if (this == &ref) return *this;
+    delete[] value;
+    code = ref.code;
+    enableFlag = ref.enableFlag;
+    valueType = ref.valueType;
+    valueSize = ref.valueSize;
+    value = copyArray(ref.value, ref.valueSize);
+    timeCode = ref.timeCode;
+    return *this;
+}
+
+void CrLiveViewProperty::Alloc(const CrInt32u size) {
+    delete[] value;
+    valueSize = size;
+    value = size ? new CrInt8u[size]() : nullptr;
+}
+
+bool CrLiveViewProperty::IsGetEnableCurrentValue() const {
+    return enableFlag == CrEnableValue_True || enableFlag == CrEnableValue_DisplayOnly;
+}
+
+void CrLiveViewProperty::SetCode(CrInt32u code) { this->code = code; }
+CrInt32u CrLiveViewProperty::GetCode() const { return code; }
+void CrLiveViewProperty::SetPropertyEnableFlag(CrPropertyEnableFlag flag) { enableFlag = flag; }
+CrPropertyEnableFlag CrLiveViewProperty::GetPropertyEnableFlag() const { return enableFlag; }
+void CrLiveViewProperty::SetFrameInfoType(CrFrameInfoType type) { valueType = type; }
+CrFrameInfoType CrLiveViewProperty::GetFrameInfoType() const { return valueType; }
+void CrLiveViewProperty::SetValueSize(CrInt32u size) { valueSize = size; }
+CrInt32u CrLiveViewProperty::GetValueSize() const { return valueSize; }
+void CrLiveViewProperty::SetValue(CrInt8u* value) { this->value = value; }
+CrInt8u* CrLiveViewProperty::GetValue() const { return value; }
+CrInt32u CrLiveViewProperty::GetTimeCode() const { return timeCode; }
+
+// 以下三类的 ipAddress 等字段由应用自行分配和释放
+CrMediaProfileInfo::CrMediaProfileInfo()
+    : contentName(nullptr), contentUrl(nullptr), contentType(nullptr), contentFrameRate(nullptr),
+      contentAspectRatio(nullptr), contentChannel(nullptr), contentVideoType(nullptr), contentAudioType(nullptr),
+      proxyUrl(nullptr), proxyType(nullptr), proxyFrameRate(nullptr), proxyAspectRatio(nullptr), proxyChannel(nullptr),
+      proxyVideoType(nullptr), proxyAudioType(nullptr), thumbnailUrl(nullptr), metaUrl(nullptr), umid(), duration(0),
+      restrictionFrame(0), isTrimmingAvailable(false) {}
+CrMediaProfileInfo::~CrMediaProfileInfo() {}
+CrMediaProfileInfo::CrMediaProfileInfo(const CrMediaProfileInfo& ref) = default;
+CrMediaProfileInfo& CrMediaProfileInfo::operator =(const CrMediaProfileInfo& ref) = default;
+
+CrMonitoringDeliverySetting::CrMonitoringDeliverySetting()
+    : reserved1(0), type(), reserved2(0), ipAddress(nullptr), downTime(0), videoPort(0), metaPort(0),
+      deliveryImageQualityLevel(), transportProtocol() {}
+CrMonitoringDeliverySetting::~CrMonitoringDeliverySetting() {}
+CrMonitoringDeliverySetting::CrMonitoringDeliverySetting(const CrMonitoringDeliverySetting& ref) = default;
+
+CrMoviePlaybackSetting::CrMoviePlaybackSetting()
+    : reserved1(0), slotId(CrSlotNumber_Slot1), contentsId(0), fileId(0), ipAddress(nullptr), downTime(0),
+      videoPort(0), audioPort(0), metaPort(0), reserved2(0), reserved3(0) {}
+CrMoviePlaybackSetting::~CrMoviePlaybackSetting() {}
+CrMoviePlaybackSetting::CrMoviePlaybackSetting(const CrMoviePlaybackSetting& ref) = default;
+
+// 文件夹名/文件名由对象持有，析构时释放（应用释放后置空也不会重复释放）
+CrMtpFolderInfo::CrMtpFolderInfo() : handle(0), folderNameSize(0), folderName(nullptr) {}
+
+CrMtpFolderInfo::~CrMtpFolderInfo() {
+    delete[] folderName;
+}
+
+CrMtpFolderInfo::CrMtpFolderInfo(const CrMtpFolderInfo& ref) : folderName(nullptr) {
+    *this = ref;
+}
+
+CrMtpFolderInfo& CrMtpFolderInfo::operator =(const CrMtpFolderInfo& ref) {
+    if (this == &ref) return *this;
+    delete[] folderName;
+    handle = ref.handle;
+    folderNameSize = ref.folderNameSize;
+    folderName = copyArray(ref.folderName, ref.folderNameSize);
+    return *this;
+}
+
+void CrMtpFolderInfo::Alloc(const CrInt32u size) {
+    delete[] folderName;
+    folderNameSize = size;
+    folderName = size ? new CrChar[size]() : nullptr;
+}
+
+CrMtpContentsInfo::CrMtpContentsInfo()
+    : handle(0), parentFolderHandle(0), contentSize(0), dateChar(), width(0), height(0), fileNameSize(0),
+      fileName(nullptr) {}
+
+CrMtpContentsInfo::~CrMtpContentsInfo() {
+    delete[] fileName;
+}
+
+CrMtpContentsInfo::CrMtpContentsInfo(const CrMtpContentsInfo& ref) : fileName(nullptr) {
+    *this = ref;
+}
+
+CrMtpContentsInfo& CrMtpContentsInfo::operator =(const CrMtpContentsInfo& ref) {
+    if (this == &ref) return *this;
+    delete[] fileName;
+    handle = ref.handle;
+    parentFolderHandle = ref.parentFolderHandle;
+    contentSize = ref.contentSize;
+    std::memcpy(dateChar, ref.dateChar, sizeof(dateChar));
+    width = ref.width;
+    height = ref.height;
+    fileNameSize = ref.fileNameSize;
+    fileName = copyArray(ref.fileName, ref.fileNameSize);
+    return *this;
+}
+
+void CrMtpContentsInfo::Alloc(const CrInt32u size) {
+    delete[] fileName;
+    fileNameSize = size;
+    fileName = size ? new CrChar[size]() : nullptr;
+}
+
+CrError Set2byte_CharBuffer(CrInt8u** dp, const char* src) {
+    if (!dp) return CrError_Generic_InvalidParameter;
+    size_t len = src ? std::strlen(src) : 0;
+    if (len > 0xFFFF) return CrError_Generic_InvalidParameter;
+    CrInt8u* buffer = new CrInt8u[len + sizeof(CrInt16u) + 1]();
+    CrInt16u size = static_cast<CrInt16u>(len);
+    std::memcpy(buffer, &size, sizeof(size));
+    if (len) std::memcpy(buffer + sizeof(CrInt16u), src, len);
+    *dp = buffer;
+    return CrError_None;
+}
+
+/* ---------------- 初始化与枚举 ---------------- */
+
+bool Init(CrInt32u logtype) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_config = loadConfig();
+    g_initialized = true;
+    LOG_INFO("[sim] CRSDK simulator: " << g_config.cameras << " camera(s), " << g_config.width << "x" << g_config.height
+             << " @" << g_config.fps << "fps, q" << g_config.quality << ", latency " << g_config.latencyUs << "us +"
+             << g_config.jitterUs << "us, error " << g_config.errorRate << ", drop " << g_config.dropRate
+             << ", seed " << g_config.seed);
+    return true;
+}
+
+bool Release() {
+    std::map<CrDeviceHandle, SimDevicePtr> devices;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        devices.swap(g_devices);
+        g_initialized = false;
+    }
+    devices.clear();
+    return true;
+}
+
+CrError EnumCameraObjects(ICrEnumCameraObjectInfo** ppEnumCameraObjectInfo, CrInt8u timeInSec) {
+    if (!ppEnumCameraObjectInfo) return CrError_Generic_InvalidParameter;
+    *ppEnumCameraObjectInfo = nullptr;
+    SimConfig config;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (!g_initialized) return CrError_Init;
+        config = g_config;
+    }
+    if (config.cameras == 0) return CrError_Adaptor_EnumDevice;
+    auto list = new SimEnumCameraObjectInfo();
+    for (int i = 0; i < config.cameras; ++i) {
+        char serial[16];
+        std::snprintf(serial, sizeof(serial), "SIM%09d", i + 1);
+        list->cameras.push_back(newUsbCamera(modelName(CrCameraDeviceModel_ZV_E10M2), serial));
+    }
+    *ppEnumCameraObjectInfo = list;
+    return CrError_None;
+}
+
+ICrCameraObjectInfo* CreateCameraObjectInfo(CrChar* name, CrChar* model, CrInt16 usbPid, CrInt32u idType,
+                                            CrInt32u idSize, CrInt8u* id, CrChar* connectTypeName,
+                                            CrChar* adaptorName, CrChar* pairingNecessity, CrInt32u sshSupport) {
+    auto info = new SimCameraObjectInfo();
+    info->name = toString(name);
+    info->model = toString(model);
+    info->usbPid = usbPid;
+    info->idType = idType;
+    if (id) info->setId(id, idSize);
+    info->connectionType = toString(connectTypeName);
+    info->adaptor = toString(adaptorName);
+    info->pairing = toString(pairingNecessity);
+    info->ssh = sshSupport;
+    return info;
+}
+
+CrError CreateCameraObjectInfoUSBConnection(ICrCameraObjectInfo** pCameraObjectInfo, CrCameraDeviceModelList model,
+                                            CrInt8u* usbSerialNumber) {
+    if (!pCameraObjectInfo || !usbSerialNumber) return CrError_Generic_InvalidParameter;
+    std::string serial(reinterpret_cast<const char*>(usbSerialNumber),
+                       strnlen(reinterpret_cast<const char*>(usbSerialNumber), USB_SERIAL_LENGTH));
+    *pCameraObjectInfo = newUsbCamera(modelName(model), serial);
+    return CrError_None;
+}
+
+CrError CreateCameraObjectInfoEthernetConnection(ICrCameraObjectInfo** pCameraObjectInfo,
+                                                 CrCameraDeviceModelList model, CrInt32u ipAddress,
+                                                 CrInt8u* macAddress, CrInt32u sshSupport) {
+    if (!pCameraObjectInfo) return CrError_Generic_InvalidParameter;
+    auto info = new SimCameraObjectInfo();
+    info->name = modelName(model);
+    info->model = info->name;
+    info->connectionType = "IP";
+    info->adaptor = "CRSDK Simulator";
+    info->pairing = "OFF";
+    info->idType = 2;
+    info->ssh = sshSupport;
+    info->ip = ipAddress;
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", ipAddress & 0xFF, (ipAddress >> 8) & 0xFF,
+                  (ipAddress >> 16) & 0xFF, (ipAddress >> 24) & 0xFF);
+    info->ipChar = buffer;
+    if (macAddress) {
+        info->mac.assign(macAddress, macAddress + 6);
+        std::snprintf(buffer, sizeof(buffer), "%02X:%02X:%02X:%02X:%02X:%02X", macAddress[0], macAddress[1],
+                      macAddress[2], macAddress[3], macAddress[4], macAddress[5]);
+        info->macChar = buffer;
+    }
+    info->setId(reinterpret_cast<const CrInt8u*>(info->macChar.data()), info->macChar.size());
+    *pCameraObjectInfo = info;
+    return CrError_None;
+}
+
+CrError EditSDKInfo(CrInt16u infotype) {
+    return CrError_None;
+}
+
+CrError GetFingerprint(ICrCameraObjectInfo* pCameraObjectInfo, char* fingerprint, CrInt32u* fingerprintSize) {
+    if (!pCameraObjectInfo || !fingerprint || !fingerprintSize) return CrError_Generic_InvalidParameter;
+    static const char kFingerprint[] = "SHA256:crsdk-simulator";
+    std::memcpy(fingerprint, kFingerprint, sizeof(kFingerprint));
+    *fingerprintSize = sizeof(kFingerprint) - 1;
+    return CrError_None;
+}
+
+CrInt32u GetSDKVersion() {
+    return (1 << 24) | (14 << 16);
+}
+
+CrInt32u GetSDKSerial() {
+    return 0;
+}
+
+/* ---------------- 连接 ---------------- */
+
+CrError Connect(ICrCameraObjectInfo* pCameraObjectInfo, IDeviceCallback* callback, CrDeviceHandle* deviceHandle,
+                CrSdkControlMode openMode, CrReconnectingSet reconnect, const char* userId, const char* userPassword,
+                const char* fingerprint, CrInt32u fingerprintSize) {
+    if (!pCameraObjectInfo || !callback || !deviceHandle) return CrError_Generic_InvalidParameter;
+    auto info = dynamic_cast<SimCameraObjectInfo*>(pCameraObjectInfo);
+    if (!info) return CrError_Connect_Connect;
+    SimDevicePtr device;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (!g_initialized) return CrError_Init;
+        CrDeviceHandle handle = g_nextHandle++;
+        device = std::make_shared<SimDevice>(handle, g_config, *info, callback, openMode);
+        g_devices[handle] = device;
+    }
+    *deviceHandle = device->handle;
+    SimDevice* self = device.get();
+    self->post([self]() {
+        {
+            std::lock_guard<std::mutex> lock(self->mutex);
+            self->connected = true;
+            self->epoch = std::chrono::steady_clock::now();
+            self->lastTick = -1;
+        }
+        self->callback->OnConnected(DEVICE_CONNECTION_VERSION_RCP3);
+    }, device->config.connectDelayMs);
+    return CrError_None;
+}
+
+CrError Disconnect(CrDeviceHandle deviceHandle) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    SimDevice* self = device.get();
+    self->post([self]() {
+        {
+            std::lock_guard<std::mutex> lock(self->mutex);
+            self->connected = false;
+        }
+        self->callback->OnDisconnected(CrError_None);
+    });
+    return CrError_None;
+}
+
+CrError ReleaseDevice(CrDeviceHandle deviceHandle) {
+    SimDevicePtr device;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        auto it = g_devices.find(deviceHandle);
+        if (it == g_devices.end()) return CrError_Generic_InvalidHandle;
+        device = it->second;
+        g_devices.erase(it);
+    }
+    return CrError_None;
+}
+
+/* ---------------- 属性与设置 ---------------- */
+
+CrError GetDeviceProperties(CrDeviceHandle deviceHandle, CrDeviceProperty** properties, CrInt32* numOfProperties) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    return fillDeviceProperties(*device, std::vector<CrInt32u>(), properties, numOfProperties);
+}
+
+CrError GetSelectDeviceProperties(CrDeviceHandle deviceHandle, CrInt32u numOfCodes, CrInt32u* codes,
+                                  CrDeviceProperty** properties, CrInt32* numOfProperties) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!codes || numOfCodes == 0) return CrError_Generic_InvalidParameter;
+    return fillDeviceProperties(*device, std::vector<CrInt32u>(codes, codes + numOfCodes), properties, numOfProperties);
+}
+
+CrError ReleaseDeviceProperties(CrDeviceHandle deviceHandle, CrDeviceProperty* properties) {
+    if (!properties) return CrError_Generic_InvalidParameter;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_propertyStorage.erase(properties);
+    }
+    delete[] properties;
+    return CrError_None;
+}
+
+CrError SetDeviceProperty(CrDeviceHandle deviceHandle, CrDeviceProperty* pProperty) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!pProperty) return CrError_Generic_InvalidParameter;
+    CrInt32u code = pProperty->GetCode();
+    bool liveViewChanged = false;
+    {
+        std::lock_guard<std::mutex> lock(device->mutex);
+        auto it = device->properties.find(code);
+        if (it == device->properties.end()) return CrError_Generic_NotSupported;
+        if (it->second.current == pProperty->GetCurrentValue()) return CrError_None;
+        it->second.current = pProperty->GetCurrentValue();
+        if (code == CrDeviceProperty_LiveView_Image_Quality) {
+            device->renderFrames();
+            liveViewChanged = true;
+        }
+    }
+    SimDevice* self = device.get();
+    self->post([self, code, liveViewChanged]() {
+        CrInt32u codes[] = {code};
+        self->callback->OnPropertyChanged();
+        self->callback->OnPropertyChangedCodes(1, codes);
+        if (liveViewChanged) self->callback->OnLvPropertyChanged();
+    });
+    return CrError_None;
+}
+
+CrError SendCommand(CrDeviceHandle deviceHandle, CrInt32u commandId, CrCommandParam commandParam) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    SimDevice* self = device.get();
+    switch (commandId) {
+    case CrCommandId_Release:
+    case CrCommandId_S1andRelease:
+        // 松开快门时完成拍摄
+        if (commandParam == CrCommandParam_Up) self->post([self]() { capture(self); });
+        break;
+    case CrCommandId_PowerOff:
+        self->post([self]() {
+            {
+                std::lock_guard<std::mutex> lock(self->mutex);
+                if (!self->connected) return;
+                self->connected = false;
+            }
+            self->callback->OnDisconnected(CrError_Connect_Disconnected);
+        });
+        break;
+    case CrCommandId_PowerOn:
+        if (commandParam != CrCommandParam_Up) break;
+        self->post([self]() {
+            {
+                std::lock_guard<std::mutex> lock(self->mutex);
+                if (self->connected) return;
+                self->connected = true;
+                self->epoch = std::chrono::steady_clock::now();
+                self->lastTick = -1;
+            }
+            self->callback->OnConnected(DEVICE_CONNECTION_VERSION_RCP3);
+        }, self->config.connectDelayMs);
+        break;
+    default:
+        break;
+    }
+    return CrError_None;
+}
+
+CrError GetDeviceSetting(CrDeviceHandle deviceHandle, CrInt32u key, CrInt32u* value) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!value) return CrError_Generic_InvalidParameter;
+    std::lock_guard<std::mutex> lock(device->mutex);
+    auto it = device->settings.find(key);
+    *value = it == device->settings.end() ? 0 : it->second;
+    return CrError_None;
+}
+
+CrError SetDeviceSetting(CrDeviceHandle deviceHandle, CrInt32u key, CrInt32u value) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    std::lock_guard<std::mutex> lock(device->mutex);
+    device->settings[key] = value;
+    return CrError_None;
+}
+
+CrError SetSaveInfo(CrDeviceHandle deviceHandle, CrChar* path, CrChar* prefix, CrInt32 no) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    std::lock_guard<std::mutex> lock(device->mutex);
+    device->savePath = toString(path);
+    if (prefix && *prefix) device->savePrefix = prefix;
+    device->saveNo = no;
+    return CrError_None;
+}
+
+/* ---------------- 预览与 OSD ---------------- */
+
+CrError GetLiveViewImage(CrDeviceHandle deviceHandle, CrImageDataBlock* imageData) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!imageData || !imageData->GetImageData()) return CrError_Generic_InvalidParameter;
+
+    int delayUs = 0;
+    {
+        std::lock_guard<std::mutex> lock(device->mutex);
+        if (!device->connected) return CrError_Connect_Disconnected;
+        if (device->settings[Setting_Key_EnableLiveView] == 0) return CrError_Api_InvalidCalled;
+        delayUs = device->config.latencyUs;
+        if (device->config.jitterUs > 0) {
+            delayUs += std::uniform_int_distribution<int>(0, device->config.jitterUs)(device->rng);
+        }
+    }
+    // 模拟 USB 传输耗时，不持锁
+    if (delayUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(delayUs));
+
+    std::lock_guard<std::mutex> lock(device->mutex);
+    const SimConfig& config = device->config;
+    std::uniform_real_distribution<double> roll(0, 1);
+    if (config.errorRate > 0 && roll(device->rng) < config.errorRate) return CrError_Generic;
+    if (config.memoryErrorRate > 0 && roll(device->rng) < config.memoryErrorRate) return CrError_Memory_Insufficient;
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - device->epoch).count();
+    int64_t tick = static_cast<int64_t>(elapsed * config.fps);
+    if (tick == device->lastTick) return CrWarning_Frame_NotUpdated;
+    if (device->lastTick >= 0 && config.dropRate > 0 && roll(device->rng) < config.dropRate) {
+        device->droppedFrames++;
+    }
+    device->lastTick = tick;
+
+    CrInt32u frameNo = static_cast<CrInt32u>(tick + 1) + device->droppedFrames;
+    const std::vector<uchar>& jpeg = device->frames[frameNo % device->frames.size()];
+    CrInt8u* buffer = imageData->GetImageData();
+    if (imageData->GetSize() < kLiveViewImageOffset + jpeg.size()) return CrError_Memory_Insufficient;
+    std::memset(buffer, 0, kLiveViewImageOffset);
+    std::memcpy(buffer + kLiveViewImageOffset, jpeg.data(), jpeg.size());
+    // 与真机一致，图像数据指针指向缓冲区内的 JPEG 起始位置
+    ImageDataBlockFields fields = {frameNo, imageData->GetSize(), buffer + kLiveViewImageOffset,
+                                   static_cast<CrInt32u>(jpeg.size()), 0};
+    assignFields(imageData, fields, pendingImageDataBlock);
+    return CrError_None;
+}
+
+CrError GetLiveViewImageInfo(CrDeviceHandle deviceHandle, CrImageInfo* info) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!info) return CrError_Generic_InvalidParameter;
+    std::lock_guard<std::mutex> lock(device->mutex);
+    ImageInfoFields fields = {static_cast<CrInt32u>(device->config.width), static_cast<CrInt32u>(device->config.height),
+                              device->bufferSize};
+    assignFields(info, fields, pendingImageInfo);
+    return CrError_None;
+}
+
+CrError GetLiveViewProperties(CrDeviceHandle deviceHandle, CrLiveViewProperty** properties, CrInt32* numOfProperties) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    return fillLiveViewProperties(*device, std::vector<CrInt32u>(), properties, numOfProperties);
+}
+
+CrError GetSelectLiveViewProperties(CrDeviceHandle deviceHandle, CrInt32u numOfCodes, CrInt32u* codes,
+                                    CrLiveViewProperty** properties, CrInt32* numOfProperties) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!codes || numOfCodes == 0) return CrError_Generic_InvalidParameter;
+    return fillLiveViewProperties(*device, std::vector<CrInt32u>(codes, codes + numOfCodes), properties,
+                                  numOfProperties);
+}
+
+CrError ReleaseLiveViewProperties(CrDeviceHandle deviceHandle, CrLiveViewProperty* properties) {
+    if (!properties) return CrError_Generic_InvalidParameter;
+    delete[] properties;
+    return CrError_None;
+}
+
+CrError GetOSDImage(CrDeviceHandle deviceHandle, CrOSDImageDataBlock* imageData) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!imageData || !imageData->GetImageData()) return CrError_Generic_InvalidParameter;
+    std::lock_guard<std::mutex> lock(device->mutex);
+    if (!device->connected) return CrError_Connect_Disconnected;
+    auto mode = device->properties.find(CrDeviceProperty_OSDImageMode);
+    if (mode == device->properties.end() || mode->second.current != CrOSDImageMode_On) {
+        return CrError_Api_InvalidCalled;
+    }
+    // 应用按 CR_OSD_IMAGE_MAX_SIZE 分配缓冲区
+    if (device->osd.size() > CR_OSD_IMAGE_MAX_SIZE) return CrError_Memory_Insufficient;
+    std::memcpy(imageData->GetImageData(), device->osd.data(), device->osd.size());
+    OSDImageDataBlockFields fields = {++device->osdFrameNo, imageData->GetImageData(),
+                                      static_cast<CrInt32u>(device->osd.size()), CrOSDImageMetaInfo()};
+    fields.metaInfo.isLvPosExist = CrIsLvPosExist_Enable;
+    fields.metaInfo.osdWidth = 640;
+    fields.metaInfo.osdHeight = 480;
+    fields.metaInfo.lvPosX = 320;
+    fields.metaInfo.lvPosY = 240;
+    fields.metaInfo.lvWidth = 640;
+    fields.metaInfo.lvHeight = 360;
+    fields.metaInfo.degree = 0;
+    assignFields(imageData, fields, pendingOSDImageDataBlock);
+    return CrError_None;
+}
+
+/* ---------------- 内容传输（MTP） ---------------- */
+
+CrError GetDateFolderList(CrDeviceHandle deviceHandle, CrMtpFolderInfo** folders, CrInt32u* numOfFolders) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!folders || !numOfFolders) return CrError_Generic_InvalidParameter;
+    *folders = nullptr;
+    *numOfFolders = 0;
+    // 按拍摄日期分文件夹，handle 即 yyyymmdd
+    std::map<CrInt32u, std::string> days;
+    {
+        std::lock_guard<std::mutex> lock(device->mutex);
+        for (const auto& content : device->contents) {
+            CrInt32u key = dayKey(content.captured);
+            char name[16];
+            std::snprintf(name, sizeof(name), "%04u-%02u-%02u", key / 10000, key / 100 % 100, key % 100);
+            days[key] = name;
+        }
+    }
+    if (days.empty()) return CrError_None;
+    auto list = new CrMtpFolderInfo[days.size()];
+    size_t i = 0;
+    for (const auto& day : days) {
+        list[i].handle = day.first;
+        list[i].folderNameSize = static_cast<CrInt32u>(day.second.size() + 1);
+        list[i].folderName = copyString(day.second);
+        ++i;
+    }
+    *folders = list;
+    *numOfFolders = static_cast<CrInt32u>(days.size());
+    return CrError_None;
+}
+
+CrError GetContentsHandleList(CrDeviceHandle deviceHandle, CrFolderHandle folderHandle,
+                              CrContentHandle** contentsHandles, CrInt32u* numOfContents) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!contentsHandles || !numOfContents) return CrError_Generic_InvalidParameter;
+    *contentsHandles = nullptr;
+    *numOfContents = 0;
+    std::vector<CrContentHandle> handles;
+    {
+        std::lock_guard<std::mutex> lock(device->mutex);
+        for (const auto& content : device->contents) {
+            if (dayKey(content.captured) == folderHandle) handles.push_back(content.id);
+        }
+    }
+    if (handles.empty()) return CrError_None;
+    *contentsHandles = copyArray(handles.data(), handles.size());
+    *numOfContents = static_cast<CrInt32u>(handles.size());
+    return CrError_None;
+}
+
+CrError GetContentsDetailInfo(CrDeviceHandle deviceHandle, CrContentHandle contentHandle,
+                              CrMtpContentsInfo* contentsInfo) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!contentsInfo) return CrError_Generic_InvalidParameter;
+    std::lock_guard<std::mutex> lock(device->mutex);
+    const SimContent* content = device->findContent(contentHandle);
+    if (!content) return CrError_Generic_InvalidParameter;
+    contentsInfo->handle = content->id;
+    contentsInfo->parentFolderHandle = dayKey(content->captured);
+    contentsInfo->contentSize = content->jpeg.size();
+    std::tm tm = localTime(content->captured);
+    std::strftime(contentsInfo->dateChar, sizeof(contentsInfo->dateChar), "%Y%m%dT%H%M%S", &tm);
+    contentsInfo->width = kStillWidth;
+    contentsInfo->height = kStillHeight;
+    delete[] contentsInfo->fileName;
+    contentsInfo->fileNameSize = static_cast<CrInt32u>(content->fileName.size() + 1);
+    contentsInfo->fileName = copyString(content->fileName);
+    return CrError_None;
+}
+
+CrError ReleaseDateFolderList(CrDeviceHandle deviceHandle, CrMtpFolderInfo* folders) {
+    if (!folders) return CrError_Generic_InvalidParameter;
+    delete[] folders;
+    return CrError_None;
+}
+
+CrError ReleaseContentsHandleList(CrDeviceHandle deviceHandle, CrContentHandle* contentsHandles) {
+    if (!contentsHandles) return CrError_Generic_InvalidParameter;
+    delete[] contentsHandles;
+    return CrError_None;
+}
+
+CrError PullContentsFile(CrDeviceHandle deviceHandle, CrContentHandle contentHandle,
+                         CrPropertyStillImageTransSize size, CrChar* path, CrChar* fileName) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    SimDevice* self = device.get();
+    std::string dir = path ? toString(path) : std::string();
+    std::string name = toString(fileName);
+    {
+        std::lock_guard<std::mutex> lock(self->mutex);
+        if (!self->findContent(contentHandle)) return CrError_Generic_InvalidParameter;
+        if (dir.empty()) dir = self->savePath;
+    }
+    self->post([self, contentHandle, size, dir, name]() {
+        self->callback->OnNotifyContentsTransfer(CrNotify_ContentsTransfer_Start, contentHandle);
+        std::string saved;
+        {
+            std::lock_guard<std::mutex> lock(self->mutex);
+            const SimContent* content = self->findContent(contentHandle);
+            if (content) {
+                std::vector<uchar> data = size == CrPropertyStillImageTransSize_SmallSize
+                    ? self->thumbnail(*content, kStillWidth / 2, kStillHeight / 2) : content->jpeg;
+                saved = saveContent(dir, name.empty() ? content->fileName : name, data);
+            }
+        }
+        if (saved.empty()) {
+            self->callback->OnWarning(CrWarning_ContentsTransferMode_StatusError);
+        } else {
+            self->callback->OnNotifyContentsTransfer(CrNotify_ContentsTransfer_Complete, contentHandle,
+                                                     const_cast<CrChar*>(saved.c_str()));
+        }
+    });
+    return CrError_None;
+}
+
+CrError GetContentsThumbnailImage(CrDeviceHandle deviceHandle, CrContentHandle contentHandle,
+                                  CrImageDataBlock* imageData, CrFileType* fileType) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!imageData || !imageData->GetImageData() || !fileType) return CrError_Generic_InvalidParameter;
+    std::lock_guard<std::mutex> lock(device->mutex);
+    const SimContent* content = device->findContent(contentHandle);
+    if (!content) return CrError_Generic_InvalidParameter;
+    std::vector<uchar> jpeg = device->thumbnail(*content, kThumbnailWidth, kThumbnailHeight);
+    if (imageData->GetSize() < jpeg.size()) return CrError_Memory_Insufficient;
+    std::memcpy(imageData->GetImageData(), jpeg.data(), jpeg.size());
+    ImageDataBlockFields fields = {0, imageData->GetSize(), imageData->GetImageData(),
+                                   static_cast<CrInt32u>(jpeg.size()), imageData->GetTimeCode()};
+    assignFields(imageData, fields, pendingImageDataBlock);
+    *fileType = CrFileType_Jpeg;
+    return CrError_None;
+}
+
+/* ---------------- 远程传输 ---------------- */
+
+CrError GetRemoteTransferCapturedDateList(CrDeviceHandle deviceHandle, CrSlotNumber slotNumber,
+                                          CrCaptureDate** captureDateList, CrInt32u* nums) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!captureDateList || !nums) return CrError_Generic_InvalidParameter;
+    *captureDateList = nullptr;
+    *nums = 0;
+    std::map<CrInt32u, std::time_t> days;
+    {
+        std::lock_guard<std::mutex> lock(device->mutex);
+        if (slotNumber == CrSlotNumber_Slot1) {
+            for (const auto& content : device->contents) days.emplace(dayKey(content.captured), content.captured);
+        }
+    }
+    if (days.empty()) return CrError_None;
+    auto list = new CrCaptureDate[days.size()];
+    size_t i = 0;
+    for (const auto& day : days) {
+        list[i] = captureDate(day.second);
+        list[i].hour = list[i].minute = list[i].sec = 0;
+        ++i;
+    }
+    *captureDateList = list;
+    *nums = static_cast<CrInt32u>(days.size());
+    return CrError_None;
+}
+
+CrError GetRemoteTransferContentsInfoList(CrDeviceHandle deviceHandle, CrSlotNumber slotNumber,
+                                          CrGetContentsInfoListType type, CrCaptureDate* captureDate,
+                                          CrInt32u maxNums, CrContentsInfo** contentsInfoList, CrInt32u* nums) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (!contentsInfoList || !nums) return CrError_Generic_InvalidParameter;
+    if (type != CrGetContentsInfoListType_All && !captureDate) return CrError_Generic_InvalidParameter;
+    *contentsInfoList = nullptr;
+    *nums = 0;
+    std::vector<CrContentsInfo> infos;
+    {
+        std::lock_guard<std::mutex> lock(device->mutex);
+        if (slotNumber != CrSlotNumber_Slot1) return CrError_None;
+        for (const auto& content : device->contents) {
+            if (maxNums > 0 && infos.size() >= maxNums) break;
+            if (captureDate && !matchesDate(*captureDate, content.captured, type)) continue;
+            CrContentsInfo info;
+            info.contentType = CrContentsInfo_ContentType_Dcf;
+            info.contentId = content.id;
+            info.dirNumber = 100;
+            info.fileNumber = content.id;
+            info.creationDatetimeUTC = CrCaptureDate(static_cast<CrInt64u>(content.captured));
+            info.modificationDatetimeUTC = info.creationDatetimeUTC;
+            info.creationDatetimeLocaltime = ::captureDate(content.captured);
+            info.modificationDatetimeLocaltime = info.creationDatetimeLocaltime;
+            info.filesNum = 1;
+            info.files = new CrContentsFile[1];
+            std::string filePath = "/DCIM/100MSDCF/" + content.fileName;
+            info.files[0].fileId = 1;
+            info.files[0].filePathLength = static_cast<CrInt32u>(filePath.size() + 1);
+            info.files[0].filePath = copyArray(reinterpret_cast<const CrInt8*>(filePath.c_str()), filePath.size() + 1);
+            info.files[0].fileFormat = CrContentsFile_FileFormat_Jpeg;
+            info.files[0].fileSize = content.jpeg.size();
+            infos.push_back(info);
+        }
+    }
+    if (infos.empty()) return CrError_None;
+    *contentsInfoList = copyArray(infos.data(), infos.size());
+    *nums = static_cast<CrInt32u>(infos.size());
+    return CrError_None;
+}
+
+CrError GetRemoteTransferContentsDataFile(CrDeviceHandle deviceHandle, CrSlotNumber slotNumber, CrInt32u contentsId,
+                                          CrInt32u fileId, CrInt32u divisionSize, CrChar* path, CrChar* fileName) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    SimDevice* self = device.get();
+    std::string dir = toString(path);
+    std::string name = toString(fileName);
+    {
+        std::lock_guard<std::mutex> lock(self->mutex);
+        if (slotNumber != CrSlotNumber_Slot1 || !self->findContent(contentsId)) {
+            return CrError_Generic_InvalidParameter;
+        }
+    }
+    self->post([self, contentsId, dir, name]() {
+        std::string saved;
+        {
+            std::lock_guard<std::mutex> lock(self->mutex);
+            const SimContent* content = self->findContent(contentsId);
+            if (content) saved = saveContent(dir, name.empty() ? content->fileName : name, content->jpeg);
+        }
+        self->callback->OnNotifyRemoteTransferResult(
+            saved.empty() ? CrNotify_RemoteTransfer_Result_NG : CrNotify_RemoteTransfer_Result_OK, 100,
+            const_cast<CrChar*>(saved.c_str()));
+    });
+    return CrError_None;
+}
+
+CrError GetRemoteTransferContentsCompressedDataFile(CrDeviceHandle deviceHandle, CrSlotNumber slotNumber,
+                                                    CrInt32u contentsId, CrInt32u fileId,
+                                                    CrGetContentsCompressedDataType type, CrChar* path,
+                                                    CrChar* fileName) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    if (type == CrGetContentsCompressedDataType_Invalid) return CrError_Generic_InvalidParameter;
+    SimDevice* self = device.get();
+    std::string dir = toString(path);
+    std::string name = toString(fileName);
+    {
+        std::lock_guard<std::mutex> lock(self->mutex);
+        if (slotNumber != CrSlotNumber_Slot1 || !self->findContent(contentsId)) {
+            return CrError_Generic_InvalidParameter;
+        }
+    }
+    self->post([self, contentsId, type, dir, name]() {
+        std::string saved;
+        {
+            std::lock_guard<std::mutex> lock(self->mutex);
+            const SimContent* content = self->findContent(contentsId);
+            if (content) {
+                bool thumb = type == CrGetContentsCompressedDataType_Thumbnail;
+                std::vector<uchar> data = thumb ? self->thumbnail(*content, kThumbnailWidth, kThumbnailHeight)
+                                                : self->thumbnail(*content, 1616, 1080 * 1616 / kStillWidth);
+                saved = saveContent(dir, name.empty() ? (thumb ? "TN_" : "SN_") + content->fileName : name, data);
+            }
+        }
+        self->callback->OnNotifyRemoteTransferResult(
+            saved.empty() ? CrNotify_RemoteTransfer_Result_NG : CrNotify_RemoteTransfer_Result_OK, 100,
+            const_cast<CrChar*>(saved.c_str()));
+    });
+    return CrError_None;
+}
+
+CrError ReleaseRemoteTransferCapturedDateList(CrDeviceHandle deviceHandle, CrCaptureDate* dateList) {
+    if (!dateList) return CrError_Generic_InvalidParameter;
+    delete[] dateList;
+    return CrError_None;
+}
+
+CrError ReleaseRemoteTransferContentsInfoList(CrDeviceHandle deviceHandle, CrContentsInfo* contentsInfoList) {
+    if (!contentsInfoList) return CrError_Generic_InvalidParameter;
+    delete[] contentsInfoList;
+    return CrError_None;
+}
+
+CrError DeleteRemoteTransferContentsFile(CrDeviceHandle deviceHandle, CrSlotNumber slotNumber, CrInt32u contentsId) {
+    auto device = findDevice(deviceHandle);
+    if (!device) return CrError_Generic_InvalidHandle;
+    {
+        std::lock_guard<std::mutex> lock(device->mutex);
+        auto& contents = device->contents;
+        auto it = std::find_if(contents.begin(), contents.end(),
+                               [contentsId](const SimContent& content) { return content.id == contentsId; });
+        if (slotNumber != CrSlotNumber_Slot1 || it == contents.end()) return CrError_Generic_InvalidParameter;
+        contents.erase(it);
+    }
+    SimDevice* self = device.get();
+    self->post([self, slotNumber]() {
+        self->callback->OnNotifyRemoteTransferContentsListChanged(CrNotify_RemoteTransfer_Changed_All, slotNumber, 0);
+    });
+    return CrError_None;
+}
+
+CrError GetRemoteTransferContentsData(CrDeviceHandle deviceHandle, CrSlotNumber slotNumber, CrInt32u contentsId,
+                                      CrInt32u fileId, CrInt32u divisionSize) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError ControlGetRemoteTransferContentsDataFile(CrDeviceHandle deviceHandle, CrGetContentsDataControlType type) {
+    return CrError_None;
+}
+
+CrError GetRemoteTransferContentsCompressedData(CrDeviceHandle deviceHandle, CrSlotNumber slotNumber,
+                                                CrInt32u contentsId, CrInt32u fileId,
+                                                CrGetContentsCompressedDataType type) {
+    return CrError_Generic_NotSupported;
+}
+
+/* ---------------- 未模拟的接口 ---------------- */
+
+CrError DownloadSettingFile(CrDeviceHandle deviceHandle, CrDownloadSettingFileType type, CrChar* filePath,
+                            CrChar* fileName, const char* password) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError UploadSettingFile(CrDeviceHandle deviceHandle, CrUploadSettingFileType type, CrChar* fileName,
+                          const char* password) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError RequestDisplayStringList(CrDeviceHandle deviceHandle, CrDisplayStringType type) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError GetDisplayStringTypes(CrDeviceHandle deviceHandle, CrDisplayStringType** types, CrInt32u* numOfTypes) {
+    if (types) *types = nullptr;
+    if (numOfTypes) *numOfTypes = 0;
+    return CrError_Generic_NotSupported;
+}
+
+CrError GetDisplayStringList(CrDeviceHandle deviceHandle, CrDisplayStringType type, CrDisplayStringListInfo** list,
+                             CrInt32u* numOfList) {
+    if (list) *list = nullptr;
+    if (numOfList) *numOfList = 0;
+    return CrError_Generic_NotSupported;
+}
+
+CrError ReleaseDisplayStringTypes(CrDeviceHandle deviceHandle, CrDisplayStringType* types) {
+    delete[] types;
+    return CrError_None;
+}
+
+CrError ReleaseDisplayStringList(CrDeviceHandle deviceHandle, CrDisplayStringListInfo* list) {
+    delete[] list;
+    return CrError_None;
+}
+
+CrError GetMediaProfile(CrDeviceHandle deviceHandle, CrMediaProfile slot, CrMediaProfileInfo** mediaProfile,
+                        CrInt32u* numOfProfile) {
+    if (mediaProfile) *mediaProfile = nullptr;
+    if (numOfProfile) *numOfProfile = 0;
+    return CrError_Generic_NotSupported;
+}
+
+CrError ReleaseMediaProfile(CrDeviceHandle deviceHandle, CrMediaProfileInfo* mediaProfile) {
+    delete[] mediaProfile;
+    return CrError_None;
+}
+
+CrError SetMonitoringDeliverySetting(CrDeviceHandle deviceHandle, CrMonitoringDeliverySetting* deliverySetting,
+                                     CrInt32u numOfSetting) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError ControlMonitoring(CrDeviceHandle deviceHandle, CrMonitoringOperation operationMode) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError RequestZoomAndFocusPreset(CrDeviceHandle deviceHandle) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError GetZoomAndFocusPreset(CrDeviceHandle deviceHandle, CrZoomAndFocusPresetInfo** list, CrInt32u* numOfList) {
+    if (list) *list = nullptr;
+    if (numOfList) *numOfList = 0;
+    return CrError_Generic_NotSupported;
+}
+
+CrError ReleaseZoomAndFocusPreset(CrDeviceHandle deviceHandle, CrZoomAndFocusPresetInfo* list) {
+    return CrError_None;
+}
+
+CrError SetMoviePlaybackSetting(CrDeviceHandle deviceHandle, CrMoviePlaybackSetting* setting, CrInt32u numOfSetting) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError GetMoviePlaybackSetting(CrDeviceHandle deviceHandle, CrMoviePlaybackSetting** setting,
+                                CrInt32u* numOfSetting) {
+    if (setting) *setting = nullptr;
+    if (numOfSetting) *numOfSetting = 0;
+    return CrError_Generic_NotSupported;
+}
+
+CrError ReleaseMoviePlaybackSetting(CrDeviceHandle deviceHandle, CrMoviePlaybackSetting* setting) {
+    delete[] setting;
+    return CrError_None;
+}
+
+CrError ControlMoviePlayback(CrDeviceHandle deviceHandle, CrMoviePlaybackControlType operationMode,
+                             CrInt32u seekPosition) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError RequestMoviePlaybackStatus(CrDeviceHandle deviceHandle) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError GetMoviePlaybackStatus(CrDeviceHandle deviceHandle, CrMoviePlaybackStatus* playbackStatus) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError PrecheckFirmwareUpdate(CrDeviceHandle deviceHandle, CrInt64u fwFileSize) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError UploadPartialFile(CrDeviceHandle deviceHandle, CrUploadPartialDataType type, CrChar* filePath) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError CancelFirmwareUpload(CrDeviceHandle deviceHandle) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError RequestFirmwareUpdaterInfo(CrDeviceHandle deviceHandle) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError StartFirmwareUpdate(CrDeviceHandle deviceHandle) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError ControlPTZF(CrDeviceHandle deviceHandle, CrPTZFControlType controlType, const CrPTZFSetting* ptzfSetting) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError PresetPTZFClear(CrDeviceHandle deviceHandle, CrInt16u presetNum) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError PresetPTZFSet(CrDeviceHandle deviceHandle, CrInt16u presetNum, CrPresetPTZFSettingType settingType,
+                      CrPresetPTZFThumbnail thumbnailSetting) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError SetTimeZoneSetting(CrDeviceHandle deviceHandle, const CrTimeZoneSetting& timezoneSetting) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError RequestTimeZoneSetting(CrDeviceHandle deviceHandle) {
+    return CrError_Generic_NotSupported;
+}
+
+CrError GetTimeZoneSetting(CrDeviceHandle deviceHandle, CrTimeZoneSetting& timezoneSetting) {
+    return CrError_Generic_NotSupported;
+}
+
+} // namespace SCRSDK
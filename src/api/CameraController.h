@@ -3,6 +3,7 @@
 #include <drogon/HttpController.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/HttpRequest.h>
+#include <drogon/HttpAppFramework.h>
 #include <json/json.h>
 #include "BaseController.h"
 #include "DocController.h"
@@ -11,6 +12,7 @@
 #include <map>
 #include <mutex>
 #include <vector>
+#include <algorithm>
 #include "SonyCamera.h"
 #include "NetworkUtils.h"
 
@@ -39,9 +41,46 @@ public:
                            "image/jpeg");
         ADD_METHOD_WITH_BODY_PARAMS(CameraController, liveEnable, "/api/camera/live/enable", Post,
                            "预览开关", "是否开启预览",
-                           "is_enable:bool:是否开启：true|false,is_local:bool:本地预览还是远程预览：true本地|false远程,rtmp_url:string:推流地址");    
+                           "is_enable:bool:是否开启：true|false,is_local:bool:本地预览还是远程预览：true本地|false远程,rtmp_url:string:推流地址,idle_grace_ms:int:无人观看后停止取帧的宽限时间，单位毫秒（可选，0~600000，默认5000）");    
         ADD_METHOD_WITH_AUTO_DOC(CameraController, liveStart, "/api/camera/live/start", Post,
-                           "开启相机预览", "开启相机预览，需要先打开预览开关");
+                           "开启相机预览", "开启相机预览，需要先打开预览开关（预览开关打开后有观看者时会自动开始取帧）");
+        ADD_METHOD_WITH_BODY_PARAMS(CameraController, liveRecord, "/api/camera/live/record", Post,
+                           "本地录像开关", "与预览/推流共用同一路取帧，录制到本地文件",
+                           "is_enable:bool:是否开启：true|false,path:string:录像文件路径（录像目录下的相对路径，mkv，直通时也可用avi）,"
+                           "codec:string:h264转码|copy直通（可选，默认h264；copy 不解码，直接封装相机JPEG，几乎不占CPU）");
+        ADD_METHOD_WITH_BODY_PARAMS(CameraController, liveMulti, "/api/camera/live/multi", Post,
+                           "多路推流开关", "一次H.264编码同时送往多个目标（RTMP、HLS、本地录像），某个目标失败只摘掉该目标，其他目标继续",
+                           "is_enable:bool:是否开启：true|false,outputs:array:目标列表（开启时必填），每项含 type（rtmp|hls|file）和 url（推流地址，或录像目录下的相对路径）,"
+                           "bitrate:int:码率kbps（可选，默认2000）,codec:string:h264|copy（可选，默认h264；copy 只能用于 file 目标）");
+        ADD_METHOD_WITH_FILE_RESPONSE(CameraController, liveMjpeg, "/api/camera/{id}/live.mjpg", Get,
+                           "局域网MJPEG预览", "multipart/x-mixed-replace 流，需要先以 is_local=true 打开预览开关，id 为相机序号；"
+                           "可选查询参数 width（64~3840，按16取整）、q（10~95，按5取整）、fps（1~60）降低分辨率/画质/帧率，同规格的观看者共享一次转码，"
+                           "同时最多4种规格，超出返回503",
+                           "multipart/x-mixed-replace");
+        ADD_METHOD_WITH_FILE_RESPONSE(CameraController, liveSnapshot, "/api/camera/{id}/snapshot.jpg", Get,
+                           "最新预览帧", "从内存返回最近一帧预览，不触发拍摄；ETag 为帧号，支持 If-None-Match（304）；"
+                           "可选查询参数 wait（毫秒，最大30000）在没有更新的帧时长轮询等待下一帧",
+                           "image/jpeg");
+        ADD_METHOD_WITH_BODY_PARAMS(CameraController, liveMulticast, "/api/camera/live/multicast", Post,
+                           "组播预览开关", "RTP/JPEG 组播输出，观看者数量不影响服务端开销；接收端通过 /api/camera/{id}/live.sdp 取SDP",
+                           "is_enable:bool:是否开启：true|false,group:string:组播地址（可选，默认239.255.0.1）,port:int:RTP端口（可选，偶数，默认5004）,"
+                           "ttl:int:组播TTL（可选，1~255，默认1）,interface:string:发送网卡IP（可选，默认有线网口）");
+        ADD_METHOD_WITH_FILE_RESPONSE(CameraController, liveSdp, "/api/camera/{id}/live.sdp", Get,
+                           "组播SDP", "组播预览的SDP描述，ffplay/VLC 可直接打开，需要先开启组播",
+                           "application/sdp");
+        ADD_METHOD_WITH_BODY_PARAMS(CameraController, liveHlsEnable, "/api/camera/live/hls", Post,
+                           "LL-HLS开关", "H.264 低延迟HLS，切片只保存在内存中，不写存储卡；播放地址 /api/camera/{id}/hls/stream.m3u8",
+                           "is_enable:bool:是否开启：true|false");
+        ADD_METHOD_WITH_FILE_RESPONSE(CameraController, liveHls, "/api/camera/{id}/hls/{file}", Get,
+                           "LL-HLS播放", "stream.m3u8 播放列表（支持 _HLS_msn/_HLS_part 阻塞刷新）、init{代}.mp4 初始化段（ffmpeg 每次重启换一代）、"
+                           "seg{序号}.m4s 切片、part{序号}.{序号}.m4s 部分切片（预加载提示的部分切片会等待生成后应答）",
+                           "application/vnd.apple.mpegurl");
+        ADD_METHOD_WITH_BODY_PARAMS(CameraController, liveShm, "/api/camera/live/shm", Post,
+                           "共享内存预览开关", "把预览JPEG写入 POSIX 共享内存环，供本机推理等进程零拷贝读取（读取端见 ShmFrameReader.h）",
+                           "is_enable:bool:是否开启：true|false,name:string:shm名称（可选，需以/sony_live_开头，默认/sony_live_{相机序号}）,"
+                           "slots:int:槽位数（可选，2~64，默认8）,slot_size:int:单帧最大字节数（可选，64KB~16MB，默认2MB）");
+        ADD_METHOD_WITH_AUTO_DOC(CameraController, liveStats, "/api/camera/live/stats", Get,
+                           "预览统计", "获取预览帧缓冲池、各路输出以及 ffmpeg 编码进程状态（进度、重启次数、最近错误、编码方式和CPU占用）等统计信息");
         ADD_METHOD_WITH_BODY_PARAMS(CameraController, zoom, "/api/camera/zoom/operation", Post,
                            "动态焦距控制", "通过动态缩放方式调整相机焦距",
                            "operation:string:缩放操作：wide(放大)|tele(缩小)|stop(停止)");
@@ -52,6 +91,9 @@ public:
 
     CameraController() {};
 
+    // 供 WebSocket 预览控制器共用同一个相机实例
+    SonyCamera& sony_camera() { return camera; }
+
     void scan(const HttpRequestPtr& req,
                     std::function<void(const HttpResponsePtr&)>&& callback)
     {
@@ -227,6 +269,14 @@ public:
                 return;
             }
         }
+        if (json->isMember("idle_grace_ms")) {
+            const Json::Value& grace = (*json)["idle_grace_ms"];
+            if (!grace.isInt() || grace.asInt() < 0 || grace.asInt() > 600000) {
+                sendErrorResponse(std::move(callback), 400, "idle_grace_ms 范围 0~600000", k400BadRequest);
+                return;
+            }
+            camera.set_live_idle_grace(grace.asInt());
+        }
         // 局域网
         bool success = camera.enable_live_view(isEnable, isLocal, rtmpUrl);    
         std::string msg(success ? "success" : "failure");
@@ -234,8 +284,17 @@ public:
         // std::string url = isLocal ? "http://"+ localIP + ":9091" : "rtsp://120.25.49.109:15544/live/stream_5";
         Json::Value data;
         if (isLocal) {
-            data["local_eth_url"] = "http://"+ eth0IP + ":9091";
-            data["local_wifi_url"] = "http://"+ wifiIP + ":9091";
+            std::string path = ":9090/api/camera/" + std::to_string(camera.camera_number()) + "/live.mjpg";
+            data["local_eth_url"] = "http://"+ eth0IP + path;
+            data["local_wifi_url"] = "http://"+ wifiIP + path;
+            std::string wsPath = ":9090/api/camera/live.ws?camera=" + std::to_string(camera.camera_number());
+            data["local_eth_ws_url"] = "ws://" + eth0IP + wsPath;
+            data["local_wifi_ws_url"] = "ws://" + wifiIP + wsPath;
+            if (camera.rtsp_port() > 0) {
+                std::string rtspPath = ":" + std::to_string(camera.rtsp_port()) + "/camera/" + std::to_string(camera.camera_number());
+                data["local_eth_rtsp_url"] = "rtsp://" + eth0IP + rtspPath;
+                data["local_wifi_rtsp_url"] = "rtsp://" + wifiIP + rtspPath;
+            }
         } else {
             data["remote_rtsp_url"] = "rtsp://120.25.49.109:15544/live/stream_5";
         }
@@ -254,6 +313,516 @@ public:
         }
     }
 
+    void liveRecord(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback) 
+    {
+        // 使用基类的验证方法
+        const Json::Value* json = validateJsonRequest(req);
+        if (!json) {
+            sendErrorResponse(std::move(callback), 400, "请求体格式错误，需要JSON格式", k400BadRequest);
+            return;
+        }
+        
+        // 验证必填字段
+        std::vector<std::string> missingFields = validateRequiredFields(json, {"is_enable"});
+        if (!missingFields.empty()) {
+            std::string message = "缺少必填字段: " + missingFields[0];
+            for (size_t i = 1; i < missingFields.size(); ++i) {
+                message += ", " + missingFields[i];
+            }
+            sendErrorResponse(std::move(callback), 400, message, k400BadRequest);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(cameraMutex_);
+        bool isEnable = (*json)["is_enable"].asBool();
+        std::string path = (*json).get("path", "").asString();
+        if (isEnable && path.size() == 0) {
+            sendErrorResponse(std::move(callback), -1, "录像路径未设置", k200OK);
+            return;
+        }
+        if (isEnable && !camera.resolve_record_path(path, path)) {
+            sendErrorResponse(std::move(callback), 400, "path 需为录像目录下的相对路径，不能含 .. 或 :", k400BadRequest);
+            return;
+        }
+        FFmpegStreamer::VideoCodec codec;
+        if (!parseVideoCodec((*json).get("codec", "h264").asString(), codec)) {
+            sendErrorResponse(std::move(callback), 400, "codec 只支持 h264 或 copy", k400BadRequest);
+            return;
+        }
+        bool ret = camera.enable_record(isEnable, path, codec);
+        if (ret) {
+            sendSuccessResponse(std::move(callback), "success", Json::nullValue, k200OK);
+        } else {
+            sendErrorResponse(std::move(callback), -1, "录像开启失败", k200OK);
+        }
+    }
+
+    void liveMulti(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback)
+    {
+        // 使用基类的验证方法
+        const Json::Value* json = validateJsonRequest(req);
+        if (!json) {
+            sendErrorResponse(std::move(callback), 400, "请求体格式错误，需要JSON格式", k400BadRequest);
+            return;
+        }
+
+        // 验证必填字段
+        std::vector<std::string> missingFields = validateRequiredFields(json, {"is_enable"});
+        if (!missingFields.empty()) {
+            std::string message = "缺少必填字段: " + missingFields[0];
+            for (size_t i = 1; i < missingFields.size(); ++i) {
+                message += ", " + missingFields[i];
+            }
+            sendErrorResponse(std::move(callback), 400, message, k400BadRequest);
+            return;
+        }
+
+        bool isEnable = (*json)["is_enable"].asBool();
+        int bitrate = (*json).get("bitrate", 2000).asInt();
+        FFmpegStreamer::VideoCodec codec;
+        if (!parseVideoCodec((*json).get("codec", "h264").asString(), codec)) {
+            sendErrorResponse(std::move(callback), 400, "codec 只支持 h264 或 copy", k400BadRequest);
+            return;
+        }
+        std::vector<FFmpegStreamer::Output> outputs;
+        if (isEnable) {
+            const Json::Value& list = (*json)["outputs"];
+            if (!list.isArray() || list.empty()) {
+                sendErrorResponse(std::move(callback), 400, "outputs 需为非空数组", k400BadRequest);
+                return;
+            }
+            for (const auto& item : list) {
+                FFmpegStreamer::Output output;
+                std::string type = item.get("type", "").asString();
+                output.target = item.get("url", "").asString();
+                if (type == "rtmp") {
+                    output.type = FFmpegStreamer::Output::Type::Rtmp;
+                } else if (type == "hls") {
+                    output.type = FFmpegStreamer::Output::Type::Hls;
+                } else if (type == "file") {
+                    output.type = FFmpegStreamer::Output::Type::File;
+                } else {
+                    sendErrorResponse(std::move(callback), 400, "不支持的输出类型: " + type, k400BadRequest);
+                    return;
+                }
+                // tee 用 | 分隔目标、[] 包裹选项
+                if (output.target.empty() || output.target.find_first_of("|[]") != std::string::npos) {
+                    sendErrorResponse(std::move(callback), 400, "url 为空或含有 | [ ] 字符", k400BadRequest);
+                    return;
+                }
+                // 文件和HLS目标只能写到录像目录下
+                if (output.type != FFmpegStreamer::Output::Type::Rtmp
+                    && !camera.resolve_record_path(output.target, output.target)) {
+                    sendErrorResponse(std::move(callback), 400, "url 需为录像目录下的相对路径，不能含 .. 或 :", k400BadRequest);
+                    return;
+                }
+                // flv 和 HLS 不能承载 MJPEG
+                if (codec == FFmpegStreamer::VideoCodec::Copy && output.type != FFmpegStreamer::Output::Type::File) {
+                    sendErrorResponse(std::move(callback), 400, "codec=copy 只支持 file 目标", k400BadRequest);
+                    return;
+                }
+                outputs.push_back(output);
+            }
+            if (bitrate < 100 || bitrate > 50000) {
+                sendErrorResponse(std::move(callback), 400, "bitrate 范围 100~50000", k400BadRequest);
+                return;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(cameraMutex_);
+        if (!camera.enable_multi_stream(isEnable, outputs, bitrate, codec)) {
+            sendErrorResponse(std::move(callback), -1, "多路推流开启失败", k200OK);
+            return;
+        }
+        sendSuccessResponse(std::move(callback), "success", Json::nullValue, k200OK);
+    }
+
+    void liveMjpeg(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback,
+                    const std::string& id)
+    {
+        {
+            std::lock_guard<std::mutex> lock(cameraMutex_);
+            if (id != std::to_string(camera.camera_number())) {
+                sendErrorResponse(std::move(callback), 404, "相机不存在", k404NotFound);
+                return;
+            }
+            if (!camera.mjpeg_enabled()) {
+                sendErrorResponse(std::move(callback), -1, "局域网预览未开启", k409Conflict);
+                return;
+            }
+        }
+        MjpegStreamHub::VariantKey variant;
+        std::string error;
+        if (!parseMjpegVariant(req, variant, error)) {
+            sendErrorResponse(std::move(callback), 400, error, k400BadRequest);
+            return;
+        }
+        // 每个规格占一路转码，活跃规格数有上限；流式响应一旦开始就只能断开，先在这里拒绝
+        if (!camera.mjpeg_variant_available(variant)) {
+            sendErrorResponse(std::move(callback), 503, "转码规格数已达上限，请使用已有的规格或原始画面", k503ServiceUnavailable);
+            return;
+        }
+        // 长连接流，关闭 drogon 的空闲踢出；帧由 MjpegStreamHub 推送
+        std::weak_ptr<trantor::TcpConnection> conn = req->getConnectionPtr();
+        auto resp = HttpResponse::newAsyncStreamResponse([this, variant, conn](ResponseStreamPtr stream) {
+            if (!camera.add_mjpeg_client(std::move(stream), conn, variant)) {
+                LOG_WARN("mjpeg client rejected, live view disabled");
+            }
+        }, true);
+        resp->setContentTypeString("multipart/x-mixed-replace; boundary=frame");
+        resp->addHeader("Cache-Control", "no-store, no-cache, must-revalidate, pre-check=0, post-check=0, max-age=0");
+        resp->addHeader("Pragma", "no-cache");
+        resp->addHeader("Access-Control-Allow-Origin", "*");
+        callback(resp);
+    }
+
+    void liveSnapshot(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback,
+                    const std::string& id)
+    {
+        {
+            std::lock_guard<std::mutex> lock(cameraMutex_);
+            if (id != std::to_string(camera.camera_number())) {
+                sendErrorResponse(std::move(callback), 404, "相机不存在", k404NotFound);
+                return;
+            }
+        }
+        int waitMs = 0;
+        const std::string& waitStr = req->getParameter("wait");
+        if (!waitStr.empty()) {
+            try {
+                waitMs = std::stoi(waitStr);
+            } catch (const std::exception& e) {
+                sendErrorResponse(std::move(callback), 400, "wait 格式错误", k400BadRequest);
+                return;
+            }
+            waitMs = std::max(0, std::min(waitMs, 30000));
+        }
+
+        // If-None-Match: "帧号"
+        bool hasKnown = false;
+        uint32_t knownFrameNo = 0;
+        std::string etag = req->getHeader("if-none-match");
+        etag.erase(std::remove(etag.begin(), etag.end(), '"'), etag.end());
+        if (!etag.empty()) {
+            try {
+                knownFrameNo = static_cast<uint32_t>(std::stoul(etag));
+                hasKnown = true;
+            } catch (const std::exception& e) {
+                // 不是本接口发出的 ETag，视为没有
+            }
+        }
+
+        SnapshotStore& store = camera.snapshots();
+        if (waitMs == 0) {
+            FramePtr frame = store.latest();
+            if (!frame) {
+                sendErrorResponse(std::move(callback), 404, "暂无预览帧", k404NotFound);
+            } else if (hasKnown && frame->frameNo == knownFrameNo) {
+                callback(snapshotNotModified(knownFrameNo));
+            } else {
+                callback(snapshotResponse(frame));
+            }
+            return;
+        }
+
+        // 长轮询：新帧由快照sink线程应答，超时由事件循环应答，二者只有一个会成功
+        auto reply = std::make_shared<std::function<void(const HttpResponsePtr&)>>(std::move(callback));
+        SnapshotStore::WaiterId waiter = store.wait(hasKnown, knownFrameNo, [reply](const FramePtr& frame) {
+            (*reply)(snapshotResponse(frame));
+        });
+        if (waiter == 0) {
+            return;
+        }
+        drogon::app().getLoop()->runAfter(waitMs / 1000.0, [this, reply, waiter, hasKnown, knownFrameNo]() {
+            if (!camera.snapshots().cancel(waiter)) {
+                return;
+            }
+            if (hasKnown) {
+                (*reply)(snapshotNotModified(knownFrameNo));
+            } else {
+                sendErrorResponse(std::move(*reply), 404, "暂无预览帧", k404NotFound);
+            }
+        });
+    }
+
+    void liveMulticast(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback)
+    {
+        // 使用基类的验证方法
+        const Json::Value* json = validateJsonRequest(req);
+        if (!json) {
+            sendErrorResponse(std::move(callback), 400, "请求体格式错误，需要JSON格式", k400BadRequest);
+            return;
+        }
+
+        // 验证必填字段
+        std::vector<std::string> missingFields = validateRequiredFields(json, {"is_enable"});
+        if (!missingFields.empty()) {
+            std::string message = "缺少必填字段: " + missingFields[0];
+            for (size_t i = 1; i < missingFields.size(); ++i) {
+                message += ", " + missingFields[i];
+            }
+            sendErrorResponse(std::move(callback), 400, message, k400BadRequest);
+            return;
+        }
+
+        bool isEnable = (*json)["is_enable"].asBool();
+        RtpMulticastSender::Config config;
+        config.group = (*json).get("group", config.group).asString();
+        config.port = (*json).get("port", config.port).asInt();
+        config.ttl = (*json).get("ttl", config.ttl).asInt();
+        config.interface = (*json).get("interface", "").asString();
+        if (isEnable) {
+            in_addr group{};
+            if (inet_pton(AF_INET, config.group.c_str(), &group) != 1 || !IN_MULTICAST(ntohl(group.s_addr))) {
+                sendErrorResponse(std::move(callback), 400, "group 不是IPv4组播地址", k400BadRequest);
+                return;
+            }
+            // RTP 用偶数端口，RTCP 占用下一个
+            if (config.port < 1024 || config.port > 65534 || config.port % 2 != 0) {
+                sendErrorResponse(std::move(callback), 400, "port 需为 1024~65534 之间的偶数", k400BadRequest);
+                return;
+            }
+            if (config.ttl < 1 || config.ttl > 255) {
+                sendErrorResponse(std::move(callback), 400, "ttl 范围 1~255", k400BadRequest);
+                return;
+            }
+            if (config.interface.empty()) {
+                config.interface = std::get<0>(getEthAndWifiIP());
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(cameraMutex_);
+        if (!camera.enable_multicast(isEnable, config)) {
+            sendErrorResponse(std::move(callback), -1, "组播开启失败", k200OK);
+            return;
+        }
+        Json::Value data;
+        if (isEnable) {
+            data["sdp_url"] = "/api/camera/" + std::to_string(camera.camera_number()) + "/live.sdp";
+            data["rtp_url"] = "rtp://" + config.group + ":" + std::to_string(config.port);
+        }
+        sendSuccessResponse(std::move(callback), "success", data, k200OK);
+    }
+
+    void liveShm(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback)
+    {
+        // 使用基类的验证方法
+        const Json::Value* json = validateJsonRequest(req);
+        if (!json) {
+            sendErrorResponse(std::move(callback), 400, "请求体格式错误，需要JSON格式", k400BadRequest);
+            return;
+        }
+
+        // 验证必填字段
+        std::vector<std::string> missingFields = validateRequiredFields(json, {"is_enable"});
+        if (!missingFields.empty()) {
+            std::string message = "缺少必填字段: " + missingFields[0];
+            for (size_t i = 1; i < missingFields.size(); ++i) {
+                message += ", " + missingFields[i];
+            }
+            sendErrorResponse(std::move(callback), 400, message, k400BadRequest);
+            return;
+        }
+
+        bool isEnable = (*json)["is_enable"].asBool();
+        ShmFrameWriter::Config config;
+        config.name = (*json).get("name", "").asString();
+        int slots = (*json).get("slots", config.slotCount).asInt();
+        int slotSize = (*json).get("slot_size", config.slotSize).asInt();
+        if (isEnable) {
+            // 开启时会删除同名的遗留对象，名称只能在本服务的前缀下
+            if (!config.name.empty() && !ShmFrameWriter::isValidName(config.name)) {
+                sendErrorResponse(std::move(callback), 400, "name 需以 /sony_live_ 开头，只含字母、数字和 _-.", k400BadRequest);
+                return;
+            }
+            if (slots < 2 || slots > 64) {
+                sendErrorResponse(std::move(callback), 400, "slots 范围 2~64", k400BadRequest);
+                return;
+            }
+            if (slotSize < 64 * 1024 || slotSize > 16 * 1024 * 1024) {
+                sendErrorResponse(std::move(callback), 400, "slot_size 范围 64KB~16MB", k400BadRequest);
+                return;
+            }
+            config.slotCount = static_cast<uint32_t>(slots);
+            config.slotSize = static_cast<uint32_t>(slotSize);
+        }
+
+        std::lock_guard<std::mutex> lock(cameraMutex_);
+        if (!camera.enable_shm(isEnable, config)) {
+            sendErrorResponse(std::move(callback), -1, "共享内存开启失败", k200OK);
+            return;
+        }
+        Json::Value data;
+        if (isEnable) {
+            data["name"] = camera.shm_name();
+        }
+        sendSuccessResponse(std::move(callback), "success", data, k200OK);
+    }
+
+    void liveSdp(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback,
+                    const std::string& id)
+    {
+        std::lock_guard<std::mutex> lock(cameraMutex_);
+        if (id != std::to_string(camera.camera_number())) {
+            sendErrorResponse(std::move(callback), 404, "相机不存在", k404NotFound);
+            return;
+        }
+        std::string sdp = camera.multicast_sdp(req->localAddr().toIp());
+        if (sdp.empty()) {
+            sendErrorResponse(std::move(callback), -1, "组播未开启", k409Conflict);
+            return;
+        }
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setContentTypeString("application/sdp");
+        resp->setBody(sdp);
+        resp->addHeader("Cache-Control", "no-cache");
+        resp->addHeader("Access-Control-Allow-Origin", "*");
+        callback(resp);
+    }
+
+    void liveHlsEnable(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback)
+    {
+        // 使用基类的验证方法
+        const Json::Value* json = validateJsonRequest(req);
+        if (!json) {
+            sendErrorResponse(std::move(callback), 400, "请求体格式错误，需要JSON格式", k400BadRequest);
+            return;
+        }
+
+        // 验证必填字段
+        std::vector<std::string> missingFields = validateRequiredFields(json, {"is_enable"});
+        if (!missingFields.empty()) {
+            std::string message = "缺少必填字段: " + missingFields[0];
+            for (size_t i = 1; i < missingFields.size(); ++i) {
+                message += ", " + missingFields[i];
+            }
+            sendErrorResponse(std::move(callback), 400, message, k400BadRequest);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(cameraMutex_);
+        bool isEnable = (*json)["is_enable"].asBool();
+        if (!camera.enable_hls(isEnable)) {
+            sendErrorResponse(std::move(callback), -1, "HLS开启失败", k200OK);
+            return;
+        }
+        Json::Value data;
+        if (isEnable) {
+            data["playlist_url"] = "/api/camera/" + std::to_string(camera.camera_number()) + "/hls/stream.m3u8";
+        }
+        sendSuccessResponse(std::move(callback), "success", data, k200OK);
+    }
+
+    void liveHls(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback,
+                    const std::string& id,
+                    const std::string& file)
+    {
+        {
+            std::lock_guard<std::mutex> lock(cameraMutex_);
+            if (id != std::to_string(camera.camera_number())) {
+                sendErrorResponse(std::move(callback), 404, "相机不存在", k404NotFound);
+                return;
+            }
+        }
+        HlsSegmenter& hls = camera.hls();
+        if (!hls.isEnabled()) {
+            sendErrorResponse(std::move(callback), -1, "HLS未开启", k409Conflict);
+            return;
+        }
+        if (!hls.isRunning()) {
+            sendErrorResponse(std::move(callback), 503, "HLS编码器重启中", k503ServiceUnavailable);
+            return;
+        }
+
+        if (file == "stream.m3u8") {
+            const std::string& msnStr = req->getParameter("_HLS_msn");
+            const std::string& partStr = req->getParameter("_HLS_part");
+            if (msnStr.empty()) {
+                if (!partStr.empty()) {
+                    sendErrorResponse(std::move(callback), 400, "_HLS_part 需要同时指定 _HLS_msn", k400BadRequest);
+                    return;
+                }
+                callback(hlsResponse(hls.playlist(), "application/vnd.apple.mpegurl", "no-cache"));
+                return;
+            }
+            uint64_t msn = 0;
+            int part = -1;
+            try {
+                msn = std::stoull(msnStr);
+                if (!partStr.empty()) part = std::stoi(partStr);
+            } catch (const std::exception& e) {
+                sendErrorResponse(std::move(callback), 400, "_HLS_msn/_HLS_part 格式错误", k400BadRequest);
+                return;
+            }
+            // 阻塞刷新的URL每次不同，应答可以被缓存
+            hlsWait(msn, part, [this]() {
+                return hlsResponse(camera.hls().playlist(), "application/vnd.apple.mpegurl", "public, max-age=6");
+            }, std::move(callback));
+            return;
+        }
+
+        unsigned long long msn = 0;
+        size_t part = 0;
+        int consumed = 0;
+        unsigned int generation = 0;
+        if (sscanf(file.c_str(), "init%u.mp4%n", &generation, &consumed) == 1 && consumed == (int)file.size()) {
+            HlsSegmenter::Blob init = hls.init(generation);
+            if (!init) {
+                sendErrorResponse(std::move(callback), 404, "初始化段不存在", k404NotFound);
+                return;
+            }
+            // 每个 ffmpeg 进程一个URI，内容不会变
+            callback(hlsResponse(*init, "video/mp4", "public, max-age=60"));
+            return;
+        }
+        consumed = 0;
+        if (sscanf(file.c_str(), "seg%llu.m4s%n", &msn, &consumed) == 1 && consumed == (int)file.size()) {
+            HlsSegmenter::Blob segment = hls.segment(msn);
+            if (!segment) {
+                sendErrorResponse(std::move(callback), 404, "切片不存在", k404NotFound);
+                return;
+            }
+            callback(hlsResponse(*segment, "video/mp4", "public, max-age=60"));
+            return;
+        }
+        consumed = 0;
+        if (sscanf(file.c_str(), "part%llu.%zu.m4s%n", &msn, &part, &consumed) == 2 && consumed == (int)file.size()) {
+            HlsSegmenter::Blob data = hls.part(msn, part);
+            if (data) {
+                callback(hlsResponse(*data, "video/mp4", "public, max-age=60"));
+                return;
+            }
+            // 预加载提示：等部分切片生成后应答
+            hlsWait(msn, static_cast<int>(part), [this, msn, part]() {
+                HlsSegmenter::Blob ready = camera.hls().part(msn, part);
+                if (!ready) {
+                    // 切片提前结束，提示的部分切片不会再生成
+                    return hlsResponse("", "text/plain", "no-cache", k404NotFound);
+                }
+                return hlsResponse(*ready, "video/mp4", "public, max-age=60");
+            }, std::move(callback));
+            return;
+        }
+        sendErrorResponse(std::move(callback), 404, "文件不存在", k404NotFound);
+    }
+
+    void liveStats(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback) 
+    {
+        std::lock_guard<std::mutex> lock(cameraMutex_);
+        Json::Value data = camera.live_view_stats();
+        sendSuccessResponse(std::move(callback), "success", data, k200OK);
+    }
+
     void zoom(const HttpRequestPtr& req,
                 std::function<void(const HttpResponsePtr&)>&& callback) 
     {
@@ -337,6 +906,117 @@ public:
     }
 
 private:
+    static HttpResponsePtr snapshotResponse(const FramePtr& frame)
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setContentTypeString("image/jpeg");
+        resp->setBody(std::string(frame->data(), frame->size));
+        resp->addHeader("ETag", "\"" + std::to_string(frame->frameNo) + "\"");
+        resp->addHeader("Cache-Control", "no-cache");
+        resp->addHeader("Access-Control-Allow-Origin", "*");
+        resp->addHeader("Access-Control-Expose-Headers", "ETag");
+        return resp;
+    }
+
+    static HttpResponsePtr snapshotNotModified(uint32_t frameNo)
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setStatusCode(k304NotModified);
+        resp->addHeader("ETag", "\"" + std::to_string(frameNo) + "\"");
+        resp->addHeader("Cache-Control", "no-cache");
+        resp->addHeader("Access-Control-Allow-Origin", "*");
+        return resp;
+    }
+
+    static HttpResponsePtr hlsResponse(const std::string& body, const std::string& contentType,
+                                       const std::string& cacheControl, HttpStatusCode code = k200OK)
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setStatusCode(code);
+        resp->setContentTypeString(contentType);
+        resp->setBody(body);
+        resp->addHeader("Cache-Control", cacheControl);
+        resp->addHeader("Access-Control-Allow-Origin", "*");
+        return resp;
+    }
+
+    /**
+     * LL-HLS 阻塞请求：切片/部分切片就绪后由 respond 生成应答（在切片读线程中调用），
+     * 超过 3 个目标时长仍未就绪应答 503，超前太多应答 400
+     */
+    void hlsWait(uint64_t msn, int part, std::function<HttpResponsePtr()> respond,
+                 std::function<void(const HttpResponsePtr&)>&& callback)
+    {
+        auto reply = std::make_shared<std::function<void(const HttpResponsePtr&)>>(std::move(callback));
+        bool invalid = false;
+        HlsSegmenter::WaiterId waiter = camera.hls().wait(msn, part, [this, reply, respond](bool ok) {
+            if (ok) {
+                (*reply)(respond());
+            } else {
+                sendErrorResponse(std::move(*reply), 503, "HLS已停止", k503ServiceUnavailable);
+            }
+        }, invalid);
+        if (invalid) {
+            sendErrorResponse(std::move(*reply), 400, "_HLS_msn 超出范围", k400BadRequest);
+            return;
+        }
+        if (waiter == 0) {
+            return;
+        }
+        drogon::app().getLoop()->runAfter(HlsBlockTimeoutSec, [this, reply, waiter]() {
+            if (!camera.hls().cancel(waiter)) {
+                return;
+            }
+            sendErrorResponse(std::move(*reply), 503, "等待超时", k503ServiceUnavailable);
+        });
+    }
+
+    // 解析录像/多路推流的 codec 字段：h264 转码，copy 直通
+    static bool parseVideoCodec(const std::string& name, FFmpegStreamer::VideoCodec& codec)
+    {
+        if (name == "h264") {
+            codec = FFmpegStreamer::VideoCodec::H264;
+        } else if (name == "copy") {
+            codec = FFmpegStreamer::VideoCodec::Copy;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * 解析MJPEG输出规格 ?width=640&q=70&fps=10，缺省项为0表示沿用原始帧
+     * 取值按步长取整，避免相近参数各自占用一路转码
+     */
+    static bool parseMjpegVariant(const HttpRequestPtr& req, MjpegStreamHub::VariantKey& variant, std::string& error)
+    {
+        struct Param { const char* name; int minValue; int maxValue; int step; int* value; };
+        Param params[] = {
+            {"width", 64, 3840, 16, &variant.width},
+            {"q", 10, 95, 5, &variant.quality},
+            {"fps", 1, 60, 1, &variant.fps},
+        };
+        for (const Param& param : params) {
+            const std::string& text = req->getParameter(param.name);
+            if (text.empty()) continue;
+            int value = 0;
+            try {
+                value = std::stoi(text);
+            } catch (const std::exception& e) {
+                error = std::string(param.name) + " 格式错误";
+                return false;
+            }
+            if (value < param.minValue || value > param.maxValue) {
+                error = std::string(param.name) + " 取值范围 " + std::to_string(param.minValue) + "~" + std::to_string(param.maxValue);
+                return false;
+            }
+            *param.value = value / param.step * param.step;
+        }
+        return true;
+    }
+
     std::mutex cameraMutex_;
+    // 3 个目标时长（EXT-X-TARGETDURATION:2）
+    static constexpr double HlsBlockTimeoutSec = 6.0;
     SonyCamera camera;
 };
\ No newline at end of file
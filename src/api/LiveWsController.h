@@ -0,0 +1,79 @@
+#pragma once
+
+#include <drogon/WebSocketController.h>
+#include <json/json.h>
+#include <string>
+#include <memory>
+#include "SonyCamera.h"
+#include "Logger.h"
+
+using namespace drogon;
+
+/**
+ * WebSocket 预览控制器
+ * 连接 ws://host:9090/api/camera/live.ws?camera=<相机序号>&window=<额度，默认1>
+ * 服务端推送二进制帧（格式见 WsLiveHub），客户端发送文本消息：
+ *   {"ack": 帧号}     确认该帧及之前发出的帧，每帧归还一个额度
+ *   {"window": n}     调整额度窗口（1~8）
+ * 需要先以 is_local=true 打开预览开关
+ */
+class LiveWsController : public drogon::WebSocketController<LiveWsController, false>
+{
+public:
+    WS_PATH_LIST_BEGIN
+        WS_PATH_ADD("/api/camera/live.ws", Get);
+    WS_PATH_LIST_END
+
+    explicit LiveWsController(SonyCamera& camera) : camera(camera) {}
+
+    void handleNewConnection(const HttpRequestPtr& req, const WebSocketConnectionPtr& conn) override
+    {
+        if (req->getParameter("camera") != std::to_string(camera.camera_number())) {
+            conn->shutdown(CloseCode::kViolation, "相机不存在");
+            return;
+        }
+        int window = 1;
+        const std::string& windowStr = req->getParameter("window");
+        if (!windowStr.empty()) {
+            try {
+                window = std::stoi(windowStr);
+            } catch (const std::exception& e) {
+                conn->shutdown(CloseCode::kViolation, "window 格式错误");
+                return;
+            }
+        }
+        if (!camera.ws_hub().add(conn, window)) {
+            conn->shutdown(CloseCode::kViolation, "局域网预览未开启");
+        }
+    }
+
+    void handleNewMessage(const WebSocketConnectionPtr& conn, std::string&& message,
+                          const WebSocketMessageType& type) override
+    {
+        if (type != WebSocketMessageType::Text) {
+            return;
+        }
+        Json::Value json;
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        std::string errors;
+        if (!reader->parse(message.data(), message.data() + message.size(), &json, &errors) || !json.isObject()) {
+            LOG_EVERY_MS(LogLevel::Debug, 5000, "ws live: bad message " << message);
+            return;
+        }
+        if (json.isMember("window")) {
+            camera.ws_hub().setWindow(conn, json["window"].asInt());
+        }
+        if (json["ack"].isUInt()) {
+            camera.ws_hub().ack(conn, json["ack"].asUInt());
+        }
+    }
+
+    void handleConnectionClosed(const WebSocketConnectionPtr& conn) override
+    {
+        camera.ws_hub().remove(conn);
+    }
+
+private:
+    SonyCamera& camera;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+#include <drogon/HttpResponse.h>
+#include <drogon/HttpRequest.h>
+#include <json/json.h>
+#include "BaseController.h"
+#include "DocController.h"
+#include "AutoDocMacro.h"
+#include <string>
+#include "Logger.h"
+
+using namespace drogon;
+
+/**
+ * 系统控制器
+ * 运行时调整日志级别等系统级设置
+ */
+class SystemController : public HttpController<SystemController>, public BaseController
+{
+public:
+    // 禁用自动创建，允许手动注册
+    static constexpr bool isAutoCreation = false;
+    METHOD_LIST_BEGIN
+        ADD_METHOD_WITH_AUTO_DOC(SystemController, getLogLevel, "/api/system/log/level", Get,
+                           "获取日志级别", "获取当前日志级别");
+        ADD_METHOD_WITH_BODY_PARAMS(SystemController, setLogLevel, "/api/system/log/level", Post,
+                           "设置日志级别", "运行时调整日志级别，立即生效",
+                           "level:string:日志级别：trace|debug|info|warn|error|off");
+    METHOD_LIST_END
+
+    SystemController() {};
+
+    void getLogLevel(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback)
+    {
+        Json::Value data;
+        data["level"] = Logger::levelName(Logger::instance().getLevel());
+        data["dropped"] = Json::UInt64(Logger::instance().droppedCount());
+        sendSuccessResponse(std::move(callback), "success", data, k200OK);
+    }
+
+    void setLogLevel(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback)
+    {
+        // 使用基类的验证方法
+        const Json::Value* json = validateJsonRequest(req);
+        if (!json) {
+            sendErrorResponse(std::move(callback), 400, "请求体格式错误，需要JSON格式", k400BadRequest);
+            return;
+        }
+
+        std::vector<std::string> missingFields = validateRequiredFields(json, {"level"});
+        if (!missingFields.empty()) {
+            sendErrorResponse(std::move(callback), 400, "缺少必填字段: " + missingFields[0], k400BadRequest);
+            return;
+        }
+
+        LogLevel level;
+        if (!(*json)["level"].isString() || !Logger::parseLevel((*json)["level"].asString(), level)) {
+            sendErrorResponse(std::move(callback), 400, "level 取值应为 trace|debug|info|warn|error|off", k400BadRequest);
+            return;
+        }
+        Logger::instance().setLevel(level);
+
+        Json::Value data;
+        data["level"] = Logger::levelName(level);
+        sendSuccessResponse(std::move(callback), "success", data, k200OK);
+    }
+};
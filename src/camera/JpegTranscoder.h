@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <memory>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include "FramePool.h"
+
+/**
+ * 预览JPEG缩放/重编码
+ * 目标宽度远小于源图时先用 libjpeg 的 DCT 缩放（IMREAD_REDUCED_*）解码出 1/2、1/4、1/8 图，
+ * 再用 INTER_AREA 缩到目标宽度，比全尺寸解码再缩小省一大半CPU。
+ * 一个实例对应一个输出规格，只在一个线程中使用。
+ */
+class JpegTranscoder {
+public:
+    // width 为0保持原宽，quality 为0使用默认画质
+    JpegTranscoder(int width, int quality) : width(width), quality(quality > 0 ? quality : DefaultQuality) {}
+
+    /**
+     * @return 新帧，帧号和时间戳沿用源帧；解码失败返回空
+     */
+    FramePtr transcode(const FramePtr& src) {
+        cv::Mat encoded(1, static_cast<int>(src->size), CV_8UC1, const_cast<char*>(src->data()));
+        int factor = reduceFactor();
+        cv::Mat image = cv::imdecode(encoded, reducedFlag(factor));
+        if (image.empty()) return FramePtr();
+        sourceWidth = image.cols * factor;
+
+        if (width > 0 && width < image.cols) {
+            int height = static_cast<int>(static_cast<int64_t>(image.rows) * width / image.cols);
+            cv::resize(image, scaled, cv::Size(width, height > 0 ? height : 1), 0, 0, cv::INTER_AREA);
+        } else {
+            scaled = image;
+        }
+
+        output.clear();
+        if (!cv::imencode(".jpg", scaled, output, {cv::IMWRITE_JPEG_QUALITY, quality})) return FramePtr();
+
+        FramePtr frame = std::make_shared<LiveFrame>();
+        frame->buffer.reset(new uint8_t[output.size()]);
+        memcpy(frame->raw(), output.data(), output.size());
+        frame->capacity = static_cast<uint32_t>(output.size());
+        frame->size = static_cast<uint32_t>(output.size());
+        frame->frameNo = src->frameNo;
+        frame->fetchStart = src->fetchStart;
+        frame->timestamp = src->timestamp;
+        return frame;
+    }
+
+private:
+    static constexpr int DefaultQuality = 80;
+
+    // 根据上一帧的源宽度选择最大的 DCT 缩小倍数，保证解码结果不窄于目标宽度
+    int reduceFactor() const {
+        if (width <= 0 || sourceWidth <= 0) return 1;
+        for (int factor = 8; factor > 1; factor /= 2) {
+            if (sourceWidth / factor >= width) return factor;
+        }
+        return 1;
+    }
+
+    static int reducedFlag(int factor) {
+        switch (factor) {
+        case 8: return cv::IMREAD_REDUCED_COLOR_8;
+        case 4: return cv::IMREAD_REDUCED_COLOR_4;
+        case 2: return cv::IMREAD_REDUCED_COLOR_2;
+        default: return cv::IMREAD_COLOR;
+        }
+    }
+
+    int width;
+    int quality;
+    int sourceWidth = 0;
+    cv::Mat scaled;
+    std::vector<uchar> output;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * 预览取帧节奏控制
+ * 根据 GetFrameNo() 的增量学习相机真实的帧间隔，在下一帧预计到达前休眠，
+ * 遇到 CrWarning_Frame_NotUpdated 时指数退避，避免空转轮询USB。
+ */
+class LivePacer {
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::chrono::microseconds Micros;
+
+    explicit LivePacer(Micros initialInterval = Micros(33333))
+        : interval(initialInterval), initialInterval(initialInterval) {}
+
+    void reset() {
+        interval = initialInterval;
+        hasFrame = false;
+        notUpdatedStreak = 0;
+        errorStreak = 0;
+    }
+
+    // 取到新帧
+    void onFrame(uint32_t frameNo, Clock::time_point now) {
+        // 按模 2^32 取有符号差值，帧号回绕后仍能学习帧间隔，后退的帧号不参与
+        int32_t delta = static_cast<int32_t>(frameNo - lastFrameNo);
+        if (hasFrame && delta > 0) {
+            auto elapsed = std::chrono::duration_cast<Micros>(now - lastFrameTime);
+            Micros sample(elapsed.count() / delta);
+            sample = std::max(minInterval, std::min(maxInterval, sample));
+            // 指数滑动平均，alpha = 1/8
+            interval = Micros(interval.count() + (sample.count() - interval.count()) / 8);
+        }
+        hasFrame = true;
+        lastFrameNo = frameNo;
+        lastFrameTime = now;
+        notUpdatedStreak = 0;
+        errorStreak = 0;
+        nextFetch = now + interval - interval / 8;
+    }
+
+    // 相机帧未更新
+    void onNotUpdated(Clock::time_point now) {
+        errorStreak = 0;
+        notUpdatedStreak = std::min(notUpdatedStreak + 1, 6);
+        Micros backoff(std::max<int64_t>(1000, interval.count() / 16) << (notUpdatedStreak - 1));
+        nextFetch = now + std::min(backoff, interval);
+    }
+
+    // 取帧失败（断连、内存不足等）
+    void onError(Clock::time_point now) {
+        notUpdatedStreak = 0;
+        errorStreak = std::min(errorStreak + 1, 5);
+        nextFetch = now + std::chrono::milliseconds(20 << errorStreak);
+    }
+
+    Clock::time_point nextFetchTime() const { return nextFetch; }
+    Micros frameInterval() const { return interval; }
+
+private:
+    const Micros minInterval{5000};
+    const Micros maxInterval{500000};
+    Micros interval;
+    Micros initialInterval;
+    bool hasFrame = false;
+    uint32_t lastFrameNo = 0;
+    Clock::time_point lastFrameTime;
+    Clock::time_point nextFetch;
+    int notUpdatedStreak = 0;
+    int errorStreak = 0;
+};
@@ -0,0 +1,193 @@
+#include "LiveViewPipeline.h"
+#include <chrono>
+#include "Logger.h"
+
+LiveViewPipeline::~LiveViewPipeline()
+{
+    stop();
+}
+
+bool LiveViewPipeline::start(std::shared_ptr<cli::CameraDevice> camera)
+{
+    if (running || camera == nullptr) {
+        return false;
+    }
+    this->camera = camera;
+    bindMetrics();
+    running = true;
+    captureThread = std::thread(&LiveViewPipeline::captureLoop, this);
+    return true;
+}
+
+void LiveViewPipeline::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(pacingMutex);
+        running = false;
+    }
+    pacingCv.notify_all();
+    if (captureThread.joinable()) captureThread.join();
+    camera = nullptr;
+}
+
+LiveViewPipeline::Stats LiveViewPipeline::stats() const
+{
+    Stats ret;
+    ret.fetched = fetched;
+    ret.notUpdated = notUpdated;
+    ret.failed = failed;
+    ret.frameIntervalUs = frameIntervalUs;
+    ret.duplicates = duplicates;
+    ret.gaps = gaps;
+    ret.effectiveFps = effectiveFps;
+    {
+        std::lock_guard<std::mutex> lock(pacingMutex);
+        ret.consumers = consumers;
+    }
+    ret.polling = liveEnabled;
+    return ret;
+}
+
+void LiveViewPipeline::acquireConsumer()
+{
+    {
+        std::lock_guard<std::mutex> lock(pacingMutex);
+        consumers++;
+    }
+    pacingCv.notify_all();
+}
+
+void LiveViewPipeline::releaseConsumer()
+{
+    std::lock_guard<std::mutex> lock(pacingMutex);
+    if (consumers > 0 && --consumers == 0) {
+        idleSince = LivePacer::Clock::now();
+    }
+}
+
+bool LiveViewPipeline::waitForConsumers()
+{
+    std::unique_lock<std::mutex> lock(pacingMutex);
+    if (consumers > 0) {
+        return true;
+    }
+    // 最后一个消费者离开后，宽限期内继续取帧，便于客户端快速重连
+    auto deadline = idleSince + idleGrace.load();
+    if (liveEnabled && LivePacer::Clock::now() < deadline) {
+        return true;
+    }
+    if (liveEnabled) {
+        lock.unlock();
+        camera->set_live_view_enable(false);
+        liveEnabled = false;
+        LOG_INFO("live view idle, polling paused");
+        lock.lock();
+    }
+    pacingCv.wait(lock, [this]() { return !running || consumers > 0; });
+    return false;
+}
+
+void LiveViewPipeline::captureLoop()
+{
+    fpsWindowFrames = 0;
+    fpsWindowStart = LivePacer::Clock::now();
+    while (running) {
+        if (!waitForConsumers()) {
+            continue;
+        }
+        if (!liveEnabled) {
+            // 有消费者时才打开预览，不再每帧翻转 EnableLiveView
+            camera->set_live_view_enable(true);
+            liveEnabled = true;
+            pacer.reset();
+            hasLastFrameNo = false;
+            backwardFrames = 0;
+        }
+
+        FramePtr frame;
+        SCRSDK::CrError err = camera->fetch_live_view_frame(frame);
+        auto now = LivePacer::Clock::now();
+        if (CR_SUCCEEDED(err) && !acceptFrameNo(frame->frameNo)) {
+            // 重复帧不转发给sink，按帧未更新处理节奏
+            duplicates++;
+            pacer.onNotUpdated(now);
+        } else if (CR_SUCCEEDED(err)) {
+            pacer.onFrame(frame->frameNo, now);
+            fetched++;
+            fetchLatency->observe(frame->timestamp - frame->fetchStart);
+            framesTotal->add();
+            bytesTotal->add(frame->size);
+            updateFps(now);
+            frameBus.publish(frame);
+        } else if (err == SCRSDK::CrWarning_Frame_NotUpdated) {
+            notUpdated++;
+            notUpdatedTotal->add();
+            pacer.onNotUpdated(now);
+        } else {
+            failed++;
+            failedTotal->add();
+            pacer.onError(now);
+        }
+        frameIntervalUs = pacer.frameInterval().count();
+
+        std::unique_lock<std::mutex> lock(pacingMutex);
+        pacingCv.wait_until(lock, pacer.nextFetchTime(), [this]() { return !running; });
+    }
+    if (liveEnabled) {
+        camera->set_live_view_enable(false);
+        liveEnabled = false;
+    }
+    LOG_INFO("live view capture exited");
+}
+
+void LiveViewPipeline::bindMetrics()
+{
+    Metrics& metrics = Metrics::instance();
+    Metrics::Labels labels = {{"camera", std::to_string(camera->get_number())}};
+    frameBus.bindCamera(camera->get_number());
+    fetchLatency = &metrics.histogram("live_fetch_seconds",
+        "GetLiveViewImage call duration", labels);
+    framesTotal = &metrics.counter("live_frames_total",
+        "Live view frames fetched from the camera and published", labels);
+    bytesTotal = &metrics.counter("live_bytes_total",
+        "JPEG bytes fetched from the camera and published", labels);
+    notUpdatedTotal = &metrics.counter("live_not_updated_total",
+        "GetLiveViewImage calls answered with Frame_NotUpdated", labels);
+    failedTotal = &metrics.counter("live_fetch_failed_total",
+        "GetLiveViewImage calls that failed", labels);
+}
+
+bool LiveViewPipeline::acceptFrameNo(uint32_t frameNo)
+{
+    if (hasLastFrameNo) {
+        // 按模 2^32 取差值，帧号回绕后仍然连续
+        uint32_t delta = frameNo - lastFrameNo;
+        if (delta == 0) {
+            return false;
+        }
+        if (delta > UINT32_MAX / 2) {
+            // 帧号后退视为重复或乱序；连续多帧后退说明相机重新开始计数，从新帧号继续
+            if (++backwardFrames < RestartBackwardFrames) {
+                return false;
+            }
+        } else if (delta > 1) {
+            // 帧号跳变说明相机侧丢帧
+            gaps += delta - 1;
+        }
+    }
+    backwardFrames = 0;
+    hasLastFrameNo = true;
+    lastFrameNo = frameNo;
+    return true;
+}
+
+void LiveViewPipeline::updateFps(LivePacer::Clock::time_point now)
+{
+    fpsWindowFrames++;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - fpsWindowStart).count();
+    if (elapsed >= 1000) {
+        effectiveFps = fpsWindowFrames * 1000.0 / elapsed;
+        fpsWindowFrames = 0;
+        fpsWindowStart = now;
+    }
+}
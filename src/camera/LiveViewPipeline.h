@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "CameraDevice.h"
+#include "FramePool.h"
+#include "FrameBus.h"
+#include "LivePacer.h"
+#include "Metrics.h"
+
+/**
+ * 预览流水线
+ * 采集线程只负责 GetLiveViewImage，取到的帧发布到 FrameBus，
+ * 由各sink在自己的线程中消费，sink 变慢时只丢弃该sink的帧而不是拖慢采集。
+ */
+class LiveViewPipeline {
+public:
+    struct Stats {
+        uint64_t fetched = 0;       // 从相机取到的帧数
+        uint64_t notUpdated = 0;    // 相机帧未更新次数
+        uint64_t failed = 0;        // 取帧失败次数
+        int64_t frameIntervalUs = 0;    // 学习到的相机帧间隔
+        uint64_t duplicates = 0;    // 帧号重复、未转发的帧数
+        uint64_t gaps = 0;          // 帧号跳变推算出的相机侧丢帧数
+        double effectiveFps = 0;    // 实际转发帧率
+        uint32_t consumers = 0;     // 当前活跃的消费者数
+        bool polling = false;       // 是否正在从相机取帧
+    };
+
+    LiveViewPipeline() = default;
+    ~LiveViewPipeline();
+
+    bool start(std::shared_ptr<cli::CameraDevice> camera);
+    void stop();
+    bool isRunning() const { return running; }
+    Stats stats() const;
+    FrameBus& bus() { return frameBus; }
+
+    /**
+     * 消费者引用计数
+     * 第一个消费者到来时自动打开相机预览并开始取帧，
+     * 最后一个消费者离开并超过宽限期后关闭预览、停止轮询
+     */
+    void acquireConsumer();
+    void releaseConsumer();
+    void setIdleGrace(std::chrono::milliseconds grace) { idleGrace = grace; }
+
+private:
+    void captureLoop();
+    bool waitForConsumers();
+    bool acceptFrameNo(uint32_t frameNo);
+    void updateFps(LivePacer::Clock::time_point now);
+    void bindMetrics();
+
+    std::shared_ptr<cli::CameraDevice> camera;
+    FrameBus frameBus;
+    std::atomic<bool> running{false};
+    std::thread captureThread;
+    LivePacer pacer;
+    mutable std::mutex pacingMutex;
+    std::condition_variable pacingCv;
+    uint32_t consumers = 0;
+    LivePacer::Clock::time_point idleSince;
+    std::atomic<std::chrono::milliseconds> idleGrace{std::chrono::milliseconds(5000)};
+    std::atomic<bool> liveEnabled{false};
+
+    std::atomic<uint64_t> fetched{0};
+    std::atomic<uint64_t> notUpdated{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<int64_t> frameIntervalUs{0};
+    std::atomic<uint64_t> duplicates{0};
+    std::atomic<uint64_t> gaps{0};
+    std::atomic<double> effectiveFps{0};
+
+    // Prometheus 指标，按相机编号打标签，start() 时绑定
+    MetricHistogram* fetchLatency = nullptr;
+    MetricCounter* framesTotal = nullptr;
+    MetricCounter* bytesTotal = nullptr;
+    MetricCounter* notUpdatedTotal = nullptr;
+    MetricCounter* failedTotal = nullptr;
+
+    // 以下仅由采集线程访问
+    bool hasLastFrameNo = false;
+    uint32_t lastFrameNo = 0;
+    uint32_t backwardFrames = 0;                    // 连续帧号后退的次数
+    static constexpr uint32_t RestartBackwardFrames = 3;
+    uint32_t fpsWindowFrames = 0;
+    LivePacer::Clock::time_point fpsWindowStart;
+};
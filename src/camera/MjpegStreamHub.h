@@ -0,0 +1,400 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <drogon/HttpResponse.h>
+#include <trantor/net/TcpConnection.h>
+#include <trantor/net/EventLoop.h>
+#include "FramePool.h"
+#include "FrameBus.h"
+#include "MjpegFrame.h"
+#include "JpegTranscoder.h"
+#include "Logger.h"
+#include "Metrics.h"
+
+// 输出规格，全0表示相机原始帧
+struct MjpegVariantKey {
+    int width = 0;
+    int quality = 0;
+    int fps = 0;
+
+    bool transcode() const { return width > 0 || quality > 0; }
+    bool operator<(const MjpegVariantKey& other) const {
+        if (width != other.width) return width < other.width;
+        if (quality != other.quality) return quality < other.quality;
+        return fps < other.fps;
+    }
+    // 日志和统计中显示的规格名
+    std::string name() const {
+        if (!transcode() && fps == 0) return "mjpeg";
+        char buf[64];
+        snprintf(buf, sizeof(buf), "mjpeg-w%d-q%d-fps%d", width, quality, fps);
+        return buf;
+    }
+};
+
+/**
+ * 通过 drogon 分发的MJPEG预览
+ * 每个观看者是一个 drogon 异步流式响应（/api/camera/{id}/live.mjpg），
+ * 与REST接口共用端口、IO线程池、HTTP解析和连接数限制。
+ * 每帧只生成一个 multipart 部分，同规格的观看者共享，在连接所在的IO线程里经 ResponseStream::send 发出，不会阻塞取帧；
+ * 每个观看者最多有 MaxOutstandingFrames 帧尚未写到socket，按连接的已发送字节数判断，不接管连接的回调，
+ * 慢速观看者跳帧而不是在 drogon 写缓冲里越积越多，长时间没有进展的连接被断开。
+ *
+ * 观看者按输出规格（宽度、画质、帧率）分组，每种规格是总线上的一个sink：
+ * 每个源帧只解码/缩放/编码一次，同规格的观看者共享结果；
+ * 帧率上限交给总线令牌桶，编码跟不上时总线丢弃旧帧。
+ * 某规格没有观看者后取消订阅，不再计算。
+ * 规格由客户端的查询参数决定，同时存在的非原始规格最多 MaxVariants 个，超出时拒绝新规格。
+ */
+class MjpegStreamHub {
+public:
+    typedef MjpegVariantKey VariantKey;
+
+    struct VariantStats {
+        std::string name;
+        size_t clients = 0;
+        uint64_t frames = 0;        // 已推送的帧数
+        uint64_t failed = 0;        // 转码失败次数
+        uint64_t skipped = 0;       // 观看者未写完上一帧而跳过的帧数
+    };
+
+    // 观看者数量变化回调，在锁外调用
+    void setClientCountCallback(std::function<void (size_t)> cb) {
+        onClientCountChanged = cb;
+    }
+
+    size_t clientCount() {
+        return totalClients.load();
+    }
+
+    // 挂到总线上，原始帧sink立即订阅，其他规格在有观看者时订阅
+    void attach(FrameBus& frameBus) {
+        std::lock_guard<std::mutex> lock(mutex);
+        bus = &frameBus;
+        variantFor(VariantKey());
+    }
+
+    bool isAttached() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return bus != nullptr;
+    }
+
+    // 取消所有订阅并关闭所有观看者的流
+    void detach() {
+        FrameBus* frameBus = nullptr;
+        std::map<VariantKey, std::shared_ptr<Variant>> removed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            frameBus = bus;
+            bus = nullptr;
+            removed.swap(variants);
+        }
+        size_t closed = 0;
+        for (auto& item : removed) {
+            if (frameBus) frameBus->unsubscribe(item.second->subscription);
+            std::lock_guard<std::mutex> lock(item.second->mutex);
+            for (auto& client : item.second->clients) client->stream->close();
+            closed += item.second->clients.size();
+            item.second->clients.clear();
+        }
+        totalClients = 0;
+        clientsGauge.set(0);
+        if (closed > 0 && onClientCountChanged) onClientCountChanged(0);
+    }
+
+    // 能否接受该规格的观看者：已有该规格，或活跃的非原始规格未达上限
+    bool hasCapacity(const VariantKey& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return canServe(key);
+    }
+
+    /**
+     * 新观看者，由流式响应的回调交给hub
+     * @param conn 请求所在的连接，用于在它的IO线程里发送和读取已发送字节数
+     * @return false 表示未挂到总线（预览未开启）、规格数已达上限或连接已断开
+     */
+    bool addClient(drogon::ResponseStreamPtr stream, const std::weak_ptr<trantor::TcpConnection>& conn,
+                   const VariantKey& key = VariantKey()) {
+        trantor::TcpConnectionPtr connection = conn.lock();
+        if (!connection || !connection->connected()) return false;
+        auto client = std::make_shared<Client>();
+        client->stream = std::move(stream);
+        client->conn = conn;
+        client->progressAt = std::chrono::steady_clock::now().time_since_epoch().count();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (bus == nullptr || !canServe(key)) return false;
+            std::shared_ptr<Variant> variant = variantFor(key);
+            std::lock_guard<std::mutex> variantLock(variant->mutex);
+            variant->clients.push_back(client);
+        }
+        size_t count = ++totalClients;
+        LOG_DEBUG("mjpeg client connected (" << key.name() << "), total " << count);
+        clientsGauge.set(count);
+        if (onClientCountChanged) onClientCountChanged(count);
+        return true;
+    }
+
+    std::vector<VariantStats> stats() {
+        std::vector<VariantStats> ret;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& item : variants) {
+            VariantStats s;
+            s.name = item.first.name();
+            s.frames = item.second->frames;
+            s.failed = item.second->failed;
+            s.skipped = item.second->skipped;
+            std::lock_guard<std::mutex> variantLock(item.second->mutex);
+            s.clients = item.second->clients.size();
+            ret.push_back(s);
+        }
+        return ret;
+    }
+
+    ~MjpegStreamHub() { detach(); }
+
+private:
+    // 同时存在的非原始规格上限，每个规格占一个总线线程和一路转码
+    static constexpr size_t MaxVariants = 4;
+    // 每个观看者最多有这么多帧投递到连接而尚未写到socket
+    static constexpr uint32_t MaxOutstandingFrames = 2;
+    // 这么久没有写完任何一帧，且一直没有额度，视为卡死并断开
+    static constexpr auto StallTimeout = std::chrono::seconds(10);
+
+    // 已交给流而尚未写到socket的帧
+    struct Pending {
+        uint64_t end;                                   // 帧末尾在本流中的偏移
+        std::chrono::steady_clock::time_point captured; // 取帧时刻，写完时记录到线延迟
+    };
+
+    struct Client {
+
+        std::shared_ptr<drogon::ResponseStream> stream;     // 保持响应，close() 时发送结束分块
+        std::weak_ptr<trantor::TcpConnection> conn;
+        std::atomic<uint32_t> outstanding{0};   // 已投递而尚未写完的帧数
+        std::atomic<int64_t> progressAt{0};     // 最近一次写完一帧的 steady_clock 时刻
+        std::atomic<bool> closed{false};        // 流已关闭，下一帧时移除
+        uint64_t skipped = 0;                   // 只在sink线程访问
+
+        // 以下只在连接的IO线程访问
+        bool started = false;
+        uint64_t sentBase = 0;                  // 第一帧交给流之前连接已发送的字节数
+        uint64_t queuedBytes = 0;               // 已交给流的字节数，含分块长度行
+        std::deque<Pending> pending;            // 尚未写到socket的帧
+    };
+
+    // 在连接的IO线程中调用：交给流，已直接写出时立即结算
+    static void send(const std::shared_ptr<Client>& client, const trantor::TcpConnectionPtr& conn,
+                     const MjpegFramePtr& payload, SinkMetrics& metrics) {
+        if (!client->started) {
+            client->started = true;
+            client->sentBase = conn->bytesSent();
+        }
+        const std::string& part = payload->part();
+        if (!client->stream->send(part)) {
+            client->closed = true;
+            client->outstanding--;
+            return;
+        }
+        // ResponseStream 按 chunked 编码：十六进制长度行 + 数据 + \r\n
+        char sizeLine[32];
+        int sizeLength = snprintf(sizeLine, sizeof(sizeLine), "%zx\r\n", part.size());
+        client->queuedBytes += sizeLength + part.size() + 2;
+        client->pending.push_back(Pending{client->queuedBytes, payload->frame()->timestamp});
+        metrics.addBytes(part.size());
+        drain(*client, *conn, metrics);
+    }
+
+    // 在连接的IO线程中调用：按连接已发送的字节数结算写完的帧（流的响应头可能还未发出，误差不超过响应头长度）
+    static void drain(Client& client, trantor::TcpConnection& conn, SinkMetrics& metrics) {
+        uint64_t written = conn.bytesSent() - client.sentBase;
+        while (!client.pending.empty() && client.pending.front().end <= written) {
+            metrics.observeWire(client.pending.front().captured);
+            client.pending.pop_front();
+            client.outstanding--;
+            client.progressAt = std::chrono::steady_clock::now().time_since_epoch().count();
+        }
+    }
+
+    struct Variant {
+        VariantKey key;
+        FrameBus::SubscriptionId subscription = 0;
+        std::unique_ptr<JpegTranscoder> transcoder;     // 只在该规格的sink线程中使用
+        std::mutex mutex;                               // 保护 clients
+        std::vector<std::shared_ptr<Client>> clients;
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> failed{0};
+        std::atomic<uint64_t> skipped{0};
+    };
+
+    // 需持有 mutex
+    std::shared_ptr<Variant> variantFor(const VariantKey& key) {
+        auto it = variants.find(key);
+        if (it != variants.end()) return it->second;
+        auto variant = std::make_shared<Variant>();
+        variant->key = key;
+        if (key.transcode()) variant->transcoder.reset(new JpegTranscoder(key.width, key.quality));
+        // 局域网预览只关心最新帧，队列保持很浅；转码规格只排一帧，编码慢时跳帧
+        FrameBus::SinkOptions options(key.transcode() ? 1 : 2, FrameBus::DropPolicy::DropOldest, key.fps);
+        options.metrics = sinkMetrics.get();
+        // 总线sink名也是指标标签，所有非原始规格共用一个，避免客户端参数产生无限多的指标序列
+        variant->subscription = bus->subscribe(isSource(key) ? "mjpeg" : "mjpeg-variant",
+                                               [this, variant](const FramePtr& frame) {
+            deliver(*variant, frame);
+        }, options);
+        variants[key] = variant;
+        LOG_INFO("mjpeg variant " << key.name() << " started");
+        return variant;
+    }
+
+    static bool isSource(const VariantKey& key) { return !key.transcode() && key.fps == 0; }
+
+    // 需持有 mutex；没有观看者、等待回收的规格不计数
+    bool canServe(const VariantKey& key) {
+        if (isSource(key) || variants.count(key) > 0) return true;
+        size_t active = 0;
+        for (auto& item : variants) {
+            if (isSource(item.first)) continue;
+            std::lock_guard<std::mutex> variantLock(item.second->mutex);
+            if (!item.second->clients.empty()) active++;
+        }
+        return active < MaxVariants;
+    }
+
+    /**
+     * 摘下没有观看者的规格（原始帧除外）并取消订阅
+     * 取消订阅会等待sink线程退出，不能持有锁，也不能在被取消的sink自己的线程中调用
+     */
+    void reapIdle() {
+        idlePending = false;
+        std::vector<FrameBus::SubscriptionId> idle;
+        FrameBus* frameBus = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            frameBus = bus;
+            idle = collectIdle();
+        }
+        if (frameBus == nullptr) return;
+        for (auto id : idle) frameBus->unsubscribe(id);
+    }
+
+    // 需持有 mutex
+    std::vector<FrameBus::SubscriptionId> collectIdle() {
+        std::vector<FrameBus::SubscriptionId> idle;
+        for (auto it = variants.begin(); it != variants.end();) {
+            bool empty;
+            {
+                std::lock_guard<std::mutex> variantLock(it->second->mutex);
+                empty = it->second->clients.empty();
+            }
+            if (empty && !isSource(it->first)) {
+                LOG_INFO("mjpeg variant " << it->first.name() << " stopped");
+                idle.push_back(it->second->subscription);
+                it = variants.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return idle;
+    }
+
+    // 在该规格的sink线程中调用
+    void deliver(Variant& variant, const FramePtr& source) {
+        if (!source || source->empty()) return;
+        // 原始帧sink顺带回收其他规格，其他规格不能在自己的线程里取消自己
+        if (idlePending && isSource(variant.key)) reapIdle();
+        {
+            std::lock_guard<std::mutex> lock(variant.mutex);
+            if (variant.clients.empty()) return;
+        }
+
+        FramePtr frame = source;
+        if (variant.transcoder) {
+            auto start = std::chrono::steady_clock::now();
+            frame = variant.transcoder->transcode(source);
+            transcodeLatency.observeSince(start);
+            if (!frame) {
+                variant.failed++;
+                LOG_EVERY_MS(LogLevel::Warn, 5000, "mjpeg variant " << variant.key.name() << " transcode failed");
+                return;
+            }
+        }
+
+        // 所有观看者共享同一个 multipart 部分，在各自连接的IO线程里发送
+        MjpegFramePtr payload = MjpegFrame::wrap(frame);
+        int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+        int64_t stallTicks = std::chrono::duration_cast<std::chrono::steady_clock::duration>(StallTimeout).count();
+
+        size_t removed = 0;
+        {
+            std::lock_guard<std::mutex> lock(variant.mutex);
+            for (auto it = variant.clients.begin(); it != variant.clients.end();) {
+                std::shared_ptr<Client> client = *it;
+                trantor::TcpConnectionPtr conn = client->conn.lock();
+                if (!conn || !conn->connected() || client->closed) {
+                    it = variant.clients.erase(it);
+                    ++removed;
+                    continue;
+                }
+                if (client->outstanding.load() >= MaxOutstandingFrames) {
+                    if (now - client->progressAt.load() > stallTicks) {
+                        LOG_INFO("mjpeg client stalled (" << variant.key.name() << "), skipped "
+                            << client->skipped << " frames, disconnect");
+                        stalledTotal.add();
+                        conn->forceClose();
+                        it = variant.clients.erase(it);
+                        ++removed;
+                        continue;
+                    }
+                    client->skipped++;
+                    variant.skipped++;
+                    skippedTotal.add();
+                    // 没有新帧投递时也要结算写出进度
+                    std::shared_ptr<SinkMetrics> metrics = sinkMetrics;
+                    conn->getLoop()->runInLoop([conn, client, metrics]() { drain(*client, *conn, *metrics); });
+                    ++it;
+                    continue;
+                }
+                client->outstanding++;
+                std::shared_ptr<SinkMetrics> metrics = sinkMetrics;
+                conn->getLoop()->runInLoop([conn, client, payload, metrics]() { send(client, conn, payload, *metrics); });
+                ++it;
+            }
+        }
+        variant.frames++;
+        if (removed > 0) {
+            if (!isSource(variant.key)) idlePending = true;
+            size_t after = totalClients.fetch_sub(removed) - removed;
+            LOG_DEBUG("mjpeg client disconnected (" << variant.key.name() << "), total " << after);
+            clientsGauge.set(after);
+            if (onClientCountChanged) onClientCountChanged(after);
+        }
+    }
+
+    FrameBus* bus = nullptr;
+    std::mutex mutex;                                   // 保护 bus 和 variants
+    std::map<VariantKey, std::shared_ptr<Variant>> variants;
+    std::atomic<size_t> totalClients{0};
+    std::atomic<bool> idlePending{false};               // 有规格失去了最后一个观看者
+    std::function<void (size_t)> onClientCountChanged;
+    MetricHistogram& transcodeLatency = Metrics::instance().histogram("mjpeg_transcode_seconds",
+        "Decode, scale and re-encode time per variant frame");
+    // IO线程的任务可能晚于hub析构执行，共享持有
+    std::shared_ptr<SinkMetrics> sinkMetrics = std::make_shared<SinkMetrics>("mjpeg");
+    MetricGauge& clientsGauge = Metrics::instance().gauge("mjpeg_clients",
+        "Connected MJPEG preview clients");
+    MetricCounter& skippedTotal = Metrics::instance().counter("mjpeg_client_frames_skipped_total",
+        "Frames skipped for an MJPEG client that had not finished writing earlier frames");
+    MetricCounter& stalledTotal = Metrics::instance().counter("mjpeg_client_stalled_total",
+        "MJPEG clients disconnected for making no send progress");
+};
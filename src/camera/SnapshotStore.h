@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include "FramePool.h"
+
+/**
+ * 最新预览帧
+ * 作为总线sink保存每台相机最近一帧，快照接口直接从内存返回，不调用SDK。
+ * 支持长轮询：等待帧号不同于调用方已有帧的下一帧。
+ */
+class SnapshotStore {
+public:
+    typedef std::function<void (const FramePtr&)> Waiter;
+    typedef uint64_t WaiterId;
+
+    // 等待者数量在 0 和非0 之间变化时调用，在锁内调用以保证顺序，回调里不能再调用本对象
+    void setWaitingCallback(std::function<void (bool)> cb) {
+        onWaitingChanged = cb;
+    }
+
+    // 总线sink线程调用：保存最新帧并唤醒所有等待者
+    void update(const FramePtr& frame) {
+        if (!frame || frame->empty()) return;
+        std::map<WaiterId, Waiter> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            latestFrame = frame;
+            ready.swap(waiters);
+            if (!ready.empty() && onWaitingChanged) onWaitingChanged(false);
+        }
+        for (auto& item : ready) {
+            item.second(frame);
+        }
+    }
+
+    FramePtr latest() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return latestFrame;
+    }
+
+    /**
+     * 等待新帧
+     * 已有帧号不同于 knownFrameNo 的帧时（或 hasKnown 为 false 且已有帧）立即在当前线程调用 waiter 并返回0，
+     * 否则登记等待，返回等待ID，waiter 会在下一帧到来时由sink线程调用
+     */
+    WaiterId wait(bool hasKnown, uint32_t knownFrameNo, Waiter waiter) {
+        FramePtr frame;
+        WaiterId id = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (latestFrame && (!hasKnown || latestFrame->frameNo != knownFrameNo)) {
+                frame = latestFrame;
+            } else {
+                id = ++lastId;
+                if (waiters.empty() && onWaitingChanged) onWaitingChanged(true);
+                waiters[id] = waiter;
+            }
+        }
+        if (frame) {
+            waiter(frame);
+            return 0;
+        }
+        return id;
+    }
+
+    /**
+     * 取消等待（超时）
+     * @return true 表示等待仍未完成且已取消，调用方负责应答；false 表示 waiter 已被调用
+     */
+    bool cancel(WaiterId id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (waiters.erase(id) == 0) return false;
+        if (waiters.empty() && onWaitingChanged) onWaitingChanged(false);
+        return true;
+    }
+
+    size_t waiterCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return waiters.size();
+    }
+
+private:
+    std::mutex mutex;
+    FramePtr latestFrame;
+    std::map<WaiterId, Waiter> waiters;
+    WaiterId lastId = 0;
+    std::function<void (bool)> onWaitingChanged;
+};
@@ -1,15 +1,17 @@
-#include "SonyCamera.h"
+﻿#include "SonyCamera.h"
+#include <algorithm>
+#include "Logger.h"
 
 int SonyCamera::initialize()
 {
-    cli::tout << "Initialize Remote SDK...\n";
+    LOG_INFO("Initialize Remote SDK...");
     auto init_success = SDK::Init();
     if (!init_success) {
-        cli::tout << "Failed to initialize Remote SDK. Terminating.\n";
+        LOG_ERROR("Failed to initialize Remote SDK. Terminating.");
         release();
         return -1;
     }
-    cli::tout << "Remote SDK successfully initialized.\n\n";
+    LOG_INFO("Remote SDK successfully initialized.");
     isInitialized = true;
     return 0;
 }
@@ -20,33 +22,72 @@ int SonyCamera::release() {
     CameraDeviceList::const_iterator it = cameraList.begin();
     for (std::int32_t j = 0; it != cameraList.end(); ++j, ++it) {
         if ((*it)->is_connected()) {
-            cli::tout << "Initiate disconnect sequence.\n";
+            LOG_INFO("Initiate disconnect sequence.");
             auto disconnect_status = (*it)->disconnect();
             if (!disconnect_status) {
                 // try again
                 disconnect_status = (*it)->disconnect();
             }
             if (!disconnect_status)
-                cli::tout << "Disconnect failed to initiate.\n";
+                LOG_ERROR("Disconnect failed to initiate.");
             else
-                cli::tout << "Disconnect successfully initiated!\n\n";
+                LOG_INFO("Disconnect successfully initiated!");
         }
         (*it)->release();
     }
     SDK::Release();
     isInitialized = false;
-    std::cout << "release camera" << std::endl;
+    LOG_INFO("release camera");
     return 0;
 }
 
 SonyCamera::SonyCamera()
 {
     // initialize();
+    // 快照sink常驻：只保存帧指针，开销可以忽略；长轮询等待期间算一个消费者，保证有新帧
+    livePipeline.bus().subscribe("snapshot", [this](const FramePtr& frame) {
+        snapshotStore.update(frame);
+    }, FrameBus::SinkOptions(1, FrameBus::DropPolicy::DropOldest, 0, true));
+    snapshotStore.setWaitingCallback([this](bool waiting) {
+        if (waiting) {
+            livePipeline.acquireConsumer();
+        } else {
+            livePipeline.releaseConsumer();
+        }
+    });
 }
 
 SonyCamera::~SonyCamera() {
     // Release the camera
     liveType = LiveType::NONE;
+    // hub 的sink引用了总线，要在 livePipeline 析构前摘下
+    mjpegHub.detach();
+    wsHub.detach();
+    if (rtspSubscription != 0) {
+        livePipeline.bus().unsubscribe(rtspSubscription);
+        rtspSubscription = 0;
+    }
+    rtspServer.stop();
+    if (multicastSubscription != 0) {
+        livePipeline.bus().unsubscribe(multicastSubscription);
+        multicastSubscription = 0;
+    }
+    multicastSender.stop();
+    if (hlsSubscription != 0) {
+        livePipeline.bus().unsubscribe(hlsSubscription);
+        hlsSubscription = 0;
+    }
+    hlsSegmenter.stop();
+    if (shmSubscription != 0) {
+        livePipeline.bus().unsubscribe(shmSubscription);
+        shmSubscription = 0;
+    }
+    shmWriter.stop();
+    if (multiSubscription != 0) {
+        livePipeline.bus().unsubscribe(multiSubscription);
+        multiSubscription = 0;
+    }
+    multiStreamer.stop();
 }
 
 std::string SonyCamera::version() {
@@ -54,9 +95,8 @@ std::string SonyCamera::version() {
     int major = (version & 0xFF000000) >> 24;
     int minor = (version & 0x00FF0000) >> 16;
     int patch = (version & 0x0000FF00) >> 8;
-    cli::tout << "Remote SDK version: ";
     std::string versionStr = std::to_string(major) + "." + std::to_string(minor) + "." + std::to_string(patch);
-    cli::tout << major << "." << minor << "." << std::setfill(TEXT('0')) << std::setw(2) << patch << "\n";
+    LOG_INFO("Remote SDK version: " << major << "." << minor << "." << std::setfill(TEXT('0')) << std::setw(2) << patch);
     json j;
     j["version"] = versionStr;
     return j.dump();
@@ -68,15 +108,15 @@ Json::Value SonyCamera::scan() {
     }
     Json::Value ret(Json::arrayValue);
     // json ret = json::array();
-    cli::tout << "Enumerate connected camera devices...\n";
+    LOG_INFO("Enumerate connected camera devices...");
     auto enum_status = SDK::EnumCameraObjects(&camera_list);
     if (CR_FAILED(enum_status) || camera_list == nullptr) {
-        cli::tout << "No cameras detected. Connect a camera and retry.\n";
+        LOG_ERROR("No cameras detected. Connect a camera and retry.");
         release();
         return ret;
     }
     auto ncams = camera_list->GetCount();
-    cli::tout << "Camera enumeration successful. " << ncams << " detected.\n\n";
+    LOG_INFO("Camera enumeration successful. " << ncams << " detected.");
     Json::Value dev;
     for (CrInt32u i = 0; i < ncams; ++i) {
         auto camera_info = camera_list->GetCameraObjectInfo(i);
@@ -90,7 +130,7 @@ Json::Value SonyCamera::scan() {
             id.append((TCHAR*)camera_info->GetMACAddressChar(), (size_t)camera_info->GetMACAddressCharSize());
         }
         else id = ((TCHAR*)camera_info->GetId());
-        cli::tout << '[' << i + 1 << "] " << model.data() << " (" << id.data() << ")\n";
+        LOG_INFO('[' << i + 1 << "] " << model.data() << " (" << id.data() << ")");
         dev["index"] = i + 1;
         dev["name"] = model.data();
         dev["id"] = id.data();
@@ -108,16 +148,16 @@ bool SonyCamera::connect(int index) {
     std::int32_t cameraNumUniq = 1;
     std::int32_t selectCamera = 1;
 
-    cli::tout << "Connect to selected camera...\n";
+    LOG_INFO("Connect to selected camera...");
     auto* camera_info = camera_list->GetCameraObjectInfo(index - 1);
 
-    cli::tout << "Create camera SDK camera callback object.\n";
+    LOG_INFO("Create camera SDK camera callback object.");
     camera = CameraDevicePtr(new cli::CameraDevice(cameraNumUniq, camera_info));
     cameraList.push_back(camera); // add 1st
     camera_list->Release();
 
     if (camera->is_connected()) {
-        cli::tout << "Please disconnect\n";
+        LOG_WARN("Please disconnect");
         return false;
     } else {
         camera->connect(SDK::CrSdkControlMode_Remote, SDK::CrReconnecting_ON);
@@ -157,16 +197,16 @@ bool SonyCamera::connect_with_usb(CameraModel model, std::string& deviceId) {
     err = SDK::CreateCameraObjectInfoUSBConnection(&pCam, usbModel, (unsigned char*)serialNum);
     bool ret = false;
     if (err == 0) {
-        cli::tout << "[" << cameraNumUniq << "] " << pCam->GetModel() << "(" << (TCHAR*)pCam->GetId() << ")\n";
+        LOG_INFO("[" << cameraNumUniq << "] " << pCam->GetModel() << "(" << (TCHAR*)pCam->GetId() << ")");
         camera = CameraDevicePtr(new cli::CameraDevice(cameraNumUniq, pCam));
         cameraList.push_back(camera);
         // camera_list->Release();
         if (camera->is_connected()) {
-            cli::tout << "Please disconnect\n";
+            LOG_WARN("Please disconnect");
         } else {
-            cli::tout << "connect...\n";
+            LOG_INFO("connect...");
             ret = camera->connect(SDK::CrSdkControlMode_Remote, SDK::CrReconnecting_ON);
-            cli::tout << "connect result: " << ret << std::endl;
+            LOG_INFO("connect result: " << ret);
         }
         cameraNumUniq++;
     }
@@ -175,11 +215,11 @@ bool SonyCamera::connect_with_usb(CameraModel model, std::string& deviceId) {
 
 bool SonyCamera::af_shutter(std::function<void (std::string)>* cb) {
     if (camera == nullptr) {
-        cli::tout << "camera not create\n";
+        LOG_WARN("camera not create");
         return false;
     }
     // Shutter Half and Full Release in AF mode
-    cli::tout << "Shutter Half and Full Release in AF mode\n";
+    LOG_INFO("Shutter Half and Full Release in AF mode");
     camera->setCompeletedCallback(cb);
     camera->af_shutter();
     return true;
@@ -187,7 +227,7 @@ bool SonyCamera::af_shutter(std::function<void (std::string)>* cb) {
 
 bool SonyCamera::capture() {
     if (camera == nullptr) {
-        cli::tout << "camera not create\n";
+        LOG_WARN("camera not create");
         return false;
     }
     camera->s1_shooting();
@@ -196,15 +236,69 @@ bool SonyCamera::capture() {
 
 std::string SonyCamera::get_save_path() {
     if (camera == nullptr) {
-        cli::tout << "camera not create\n";
+        LOG_WARN("camera not create");
         return "";
     }
     return camera->get_save_info();
 }
 
+std::string SonyCamera::record_dir() {
+    const char* dir = std::getenv("CAMERA_RECORD_DIR");
+    if (dir != nullptr && dir[0] != '\0') {
+        return dir;
+    }
+    return (fs::current_path() / "recordings").string();
+}
+
+bool SonyCamera::resolve_record_path(const std::string& relative, std::string& resolved) {
+    // ffmpeg 会把 xxx: 前缀当作协议（file:、pipe:、tcp: 等），一律拒绝
+    if (relative.empty() || relative[0] == '/' || relative.find(':') != std::string::npos) {
+        return false;
+    }
+    fs::path path(relative);
+    for (const auto& part : path) {
+        if (part == "..") {
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::create_directories(record_dir(), ec);
+    fs::path root = fs::canonical(record_dir(), ec);
+    if (ec) {
+        LOG_WARN("record dir " << record_dir() << " unavailable: " << ec.message());
+        return false;
+    }
+    fs::path target = root / path;
+    if (!target.has_filename()) {
+        return false;
+    }
+    fs::create_directories(target.parent_path(), ec);
+    if (ec) {
+        LOG_WARN("create " << target.parent_path().string() << " failed: " << ec.message());
+        return false;
+    }
+    // 目录中的符号链接可能指向录像目录之外
+    fs::path parent = fs::canonical(target.parent_path(), ec);
+    if (ec) {
+        return false;
+    }
+    auto mismatch = std::mismatch(root.begin(), root.end(), parent.begin(), parent.end());
+    if (mismatch.first != root.end()) {
+        LOG_WARN("record path " << relative << " escapes " << root.string());
+        return false;
+    }
+    resolved = (parent / target.filename()).string();
+    // ffmpeg -y 会覆盖链接指向的文件
+    if (fs::is_symlink(resolved, ec)) {
+        LOG_WARN("record path " << relative << " is a symlink");
+        return false;
+    }
+    return true;
+}
+
 void SonyCamera::power_off() {
     if (camera == nullptr) {
-        cli::tout << "camera not create\n";
+        LOG_WARN("camera not create");
         return;
     }
     camera->power_off();
@@ -215,7 +309,7 @@ void SonyCamera::power_on() {
     // 1. 系统层面控制USB插拔或者断电都没有效果
     // 2. 只能使用USB可控继电器的方式物理控制USB断电重连
     if (camera == nullptr) {
-        cli::tout << "camera not create\n";
+        LOG_WARN("camera not create");
         return;
     }
     camera->power_on();
@@ -234,45 +328,376 @@ void SonyCamera::power_on() {
 
 bool SonyCamera::live_view() {
     if (camera == nullptr) {
-        cli::tout << "camera not create\n";
+        LOG_WARN("camera not create");
         return false;
     }
     if (liveType == LiveType::NONE) {
-        cli::tout << "live type not set\n";
+        LOG_WARN("live type not set");
         return false;
     }
     
-    std::cout << "live view: " << liveType << std::endl;
-    liveThread = std::thread([&]() {
-        while (isLiveRunning) {
-            camera->change_live_view_enable();     
-            bool isLocal = liveType == LiveType::LOCAL;
-            camera->get_live_view_only(isLocal);        
-        }
-        std::cout << "live view exited" << std::endl;
-    });
-    return true;
+    LOG_DEBUG("live view: " << liveType);
+    ensure_live_pipeline();
+    return livePipeline.isRunning();
 }
 
 bool SonyCamera::enable_live_view(bool enable, bool isLocal, std::string& rtmpUrl) {
     if (camera == nullptr) {
-        cli::tout << "camera not create\n";
+        LOG_WARN("camera not create");
         return false;
     }
-    isLiveRunning = enable;
-    if (!enable) {
-        if (liveThread.joinable()) { liveThread.join(); }
-        liveType = LiveType::NONE;
+    FrameBus& bus = livePipeline.bus();
+    bool ret = true;
+    if (enable) {
+        LOG_INFO("启动推流");
+        if (isLocal && !mjpegHub.isAttached()) {
+            // 有客户端连接时才从相机取帧
+            mjpegHub.setClientCountCallback([this](size_t count) {
+                bool active = count > 0;
+                if (active != mjpegActive.exchange(active)) {
+                    if (active) {
+                        livePipeline.acquireConsumer();
+                    } else {
+                        livePipeline.releaseConsumer();
+                    }
+                }
+            });
+            mjpegHub.attach(bus);
+            wsHub.setClientCountCallback([this](size_t count) {
+                bool active = count > 0;
+                if (active != wsActive.exchange(active)) {
+                    if (active) {
+                        livePipeline.acquireConsumer();
+                    } else {
+                        livePipeline.releaseConsumer();
+                    }
+                }
+            });
+            wsHub.attach(bus);
+        }
+        if (isLocal && !rtspServer.isRunning()) {
+            rtspServer.setClientCountCallback([this](size_t count) {
+                bool active = count > 0;
+                if (active != rtspActive.exchange(active)) {
+                    if (active) {
+                        livePipeline.acquireConsumer();
+                    } else {
+                        livePipeline.releaseConsumer();
+                    }
+                }
+            });
+            if (rtspServer.start(RtspServer::DefaultPort)) {
+                // 打包只解析JPEG头，队列保持很浅
+                rtspSubscription = bus.subscribe("rtsp", [this](const FramePtr& frame) {
+                    rtspServer.pushFrame(frame);
+                }, FrameBus::SinkOptions(2, FrameBus::DropPolicy::DropOldest, 0, false, &rtspServer.metrics()));
+            }
+        } else if (!isLocal && rtmpSubscription == 0) {
+            ret = rtmpStreamer.startRtmpStream(rtmpUrl, 25, 2000);
+            if (ret) {
+                // ffmpeg 按 -framerate 25 读取，超过的帧限速丢弃；pushFrame 只入队，排队在推流器的写队列中
+                rtmpSubscription = bus.subscribe("rtmp", [this](const FramePtr& frame) {
+                    rtmpStreamer.pushFrame(frame);
+                }, FrameBus::SinkOptions(2, FrameBus::DropPolicy::DropOldest, 25, false, &rtmpStreamer.metrics()));
+                livePipeline.acquireConsumer();
+            }
+        }
+        if (ret) {
+            liveType = isLocal ? LiveType::LOCAL : LiveType::REMOTE;
+            ensure_live_pipeline();
+        }
     } else {
-        liveType = isLocal ? LiveType::LOCAL : LiveType::REMOTE;
+        LOG_INFO("停止推流");
+        if (isLocal) {
+            mjpegHub.detach();
+            wsHub.detach();
+            if (rtspSubscription != 0) {
+                bus.unsubscribe(rtspSubscription);
+                rtspSubscription = 0;
+            }
+            rtspServer.stop();
+        } else if (rtmpSubscription != 0) {
+            bus.unsubscribe(rtmpSubscription);
+            rtmpSubscription = 0;
+            rtmpStreamer.stop();
+            livePipeline.releaseConsumer();
+        }
+        stop_live_if_idle();
+    }
+    return ret;
+}
+
+bool SonyCamera::enable_sink(bool enable, const std::string& name, FrameBus::SubscriptionId& subscription,
+                             const std::function<bool ()>& start, const std::function<void ()>& stop,
+                             const FrameBus::Handler& push, const FrameBus::SinkOptions& options) {
+    if (camera == nullptr) {
+        LOG_WARN("camera not create");
+        return false;
+    }
+    FrameBus& bus = livePipeline.bus();
+    if (enable) {
+        if (subscription != 0) {
+            return true;
+        }
+        if (!start()) {
+            return false;
+        }
+        subscription = bus.subscribe(name, push, options);
+        livePipeline.acquireConsumer();
+        if (liveType == LiveType::NONE) {
+            liveType = LiveType::LOCAL;
+        }
+        ensure_live_pipeline();
+    } else if (subscription != 0) {
+        bus.unsubscribe(subscription);
+        subscription = 0;
+        stop();
+        livePipeline.releaseConsumer();
+        stop_live_if_idle();
+    }
+    return true;
+}
+
+bool SonyCamera::enable_record(bool enable, const std::string& path, FFmpegStreamer::VideoCodec codec) {
+    return enable_sink(enable, "record", recordSubscription,
+        [&]() { return recorder.startRecord(path, 25, codec); },
+        [this]() { recorder.stop(); },
+        [this](const FramePtr& frame) { recorder.pushFrame(frame); },
+        FrameBus::SinkOptions(2, FrameBus::DropPolicy::DropOldest, 25, false, &recorder.metrics()));
+}
+
+bool SonyCamera::enable_multi_stream(bool enable, const std::vector<FFmpegStreamer::Output>& outputs, int bitrate,
+                                     FFmpegStreamer::VideoCodec codec) {
+    return enable_sink(enable, "multi", multiSubscription,
+        [&]() { return multiStreamer.startMulti(outputs, 25, bitrate, codec); },
+        [this]() { multiStreamer.stop(); },
+        [this](const FramePtr& frame) { multiStreamer.pushFrame(frame); },
+        FrameBus::SinkOptions(2, FrameBus::DropPolicy::DropOldest, 25, false, &multiStreamer.metrics()));
+}
+
+bool SonyCamera::enable_multicast(bool enable, const RtpMulticastSender::Config& config) {
+    // 组播不知道有没有人在看，开启期间一直取帧
+    return enable_sink(enable, "multicast", multicastSubscription,
+        [&]() { return multicastSender.start(config); },
+        [this]() { multicastSender.stop(); },
+        [this](const FramePtr& frame) { multicastSender.pushFrame(frame); },
+        FrameBus::SinkOptions(2, FrameBus::DropPolicy::DropOldest, 0, false, &multicastSender.metrics()));
+}
+
+bool SonyCamera::enable_hls(bool enable) {
+    HlsSegmenter::Config config;
+    // 关键帧按采集时间戳强制插入，切片时长与实际帧率无关；超过 framerate 的帧限速丢弃，限制编码负载
+    return enable_sink(enable, "hls", hlsSubscription,
+        [&]() { return hlsSegmenter.start(config); },
+        [this]() { hlsSegmenter.stop(); },
+        [this](const FramePtr& frame) { hlsSegmenter.pushFrame(frame); },
+        FrameBus::SinkOptions(8, FrameBus::DropPolicy::DropOldest, config.framerate, false, &hlsSegmenter.metrics()));
+}
+
+bool SonyCamera::enable_shm(bool enable, const ShmFrameWriter::Config& config) {
+    // 读取端只读映射，写入端不知道有没有人在读，开启期间一直取帧
+    return enable_sink(enable, "shm", shmSubscription,
+        [&]() { return shmWriter.start(config, static_cast<uint32_t>(camera_number())); },
+        [this]() { shmWriter.stop(); },
+        [this](const FramePtr& frame) { shmWriter.pushFrame(frame); },
+        FrameBus::SinkOptions(2, FrameBus::DropPolicy::DropOldest, 0, false, &shmWriter.metrics()));
+}
+
+std::string SonyCamera::shm_name() {
+    return shmSubscription != 0 ? shmWriter.stats().name : std::string();
+}
+
+std::string SonyCamera::multicast_sdp(const std::string& origin) {
+    if (multicastSubscription == 0) {
+        return std::string();
+    }
+    return multicastSender.sdp(origin);
+}
+
+void SonyCamera::set_live_idle_grace(int milliseconds) {
+    livePipeline.setIdleGrace(std::chrono::milliseconds(milliseconds));
+}
+
+void SonyCamera::ensure_live_pipeline() {
+    // 流水线常驻，是否真正取帧由消费者引用计数决定
+    if (!livePipeline.isRunning()) {
+        livePipeline.start(camera);
     }
-    return camera->enable_live_view(enable, isLocal, rtmpUrl);
+}
+
+void SonyCamera::stop_live_if_idle() {
+    // 除常驻的快照sink外所有sink都已关闭时停止取帧
+    if (livePipeline.bus().subscriberCount() == 0) {
+        livePipeline.stop();
+        liveType = LiveType::NONE;
+    }
+}
+
+int SonyCamera::camera_number() {
+    return camera == nullptr ? -1 : camera->get_number();
+}
+
+bool SonyCamera::mjpeg_enabled() {
+    return camera != nullptr && mjpegHub.isAttached();
+}
+
+bool SonyCamera::add_mjpeg_client(drogon::ResponseStreamPtr stream, const std::weak_ptr<trantor::TcpConnection>& conn,
+                                  const MjpegStreamHub::VariantKey& variant) {
+    return mjpegHub.addClient(std::move(stream), conn, variant);
+}
+
+Json::Value SonyCamera::live_view_stats() {
+    Json::Value ret;
+    if (camera == nullptr) {
+        return ret;
+    }
+    ret["camera"] = camera->get_number();
+    FramePool::Stats pool = camera->get_live_view_pool_stats();
+    ret["pool"]["hits"] = (Json::UInt64)pool.hits;
+    ret["pool"]["misses"] = (Json::UInt64)pool.misses;
+    ret["pool"]["in_use"] = pool.inUse;
+    ret["pool"]["high_water"] = pool.highWater;
+    ret["pool"]["pooled"] = pool.pooled;
+    ret["pool"]["buffer_size"] = pool.bufferSize;
+    LiveViewInfoCache::Stats info = camera->get_live_view_info_stats();
+    ret["info"]["buffer_size"] = info.bufferSize;
+    ret["info"]["buffer_refreshes"] = (Json::UInt64)info.bufferRefreshes;
+    ret["info"]["frame_info_refreshes"] = (Json::UInt64)info.frameInfoRefreshes;
+    ret["info"]["focus_frames"] = (Json::UInt64)info.focusFrames;
+    ret["info"]["face_frames"] = (Json::UInt64)info.faceFrames;
+    ret["info"]["tracking_frames"] = (Json::UInt64)info.trackingFrames;
+    LiveViewPipeline::Stats pipeline = livePipeline.stats();
+    ret["pipeline"]["fetched"] = (Json::UInt64)pipeline.fetched;
+    ret["pipeline"]["not_updated"] = (Json::UInt64)pipeline.notUpdated;
+    ret["pipeline"]["failed"] = (Json::UInt64)pipeline.failed;
+    ret["pipeline"]["frame_interval_us"] = (Json::Int64)pipeline.frameIntervalUs;
+    ret["pipeline"]["duplicates"] = (Json::UInt64)pipeline.duplicates;
+    ret["pipeline"]["gaps"] = (Json::UInt64)pipeline.gaps;
+    ret["pipeline"]["effective_fps"] = pipeline.effectiveFps;
+    ret["pipeline"]["consumers"] = pipeline.consumers;
+    ret["pipeline"]["polling"] = pipeline.polling;
+    ret["sinks"] = Json::Value(Json::arrayValue);
+    for (const auto& sink : livePipeline.bus().stats()) {
+        Json::Value item;
+        item["name"] = sink.name;
+        item["received"] = (Json::UInt64)sink.received;
+        item["delivered"] = (Json::UInt64)sink.delivered;
+        item["dropped"] = (Json::UInt64)sink.dropped;
+        item["throttled"] = (Json::UInt64)sink.throttled;
+        item["queued"] = sink.queued;
+        ret["sinks"].append(item);
+    }
+    ret["encoders"] = Json::Value(Json::arrayValue);
+    for (auto* streamer : {&rtmpStreamer, &recorder, &multiStreamer}) {
+        if (!streamer->isRunning()) continue;
+        FFmpegStreamer::Stats encoder = streamer->stats();
+        Json::Value item;
+        item["name"] = streamer->sinkName();
+        item["queued"] = encoder.queued;
+        item["queue_depth"] = encoder.queueDepth;
+        item["written"] = (Json::UInt64)encoder.written;
+        item["dropped"] = (Json::UInt64)encoder.dropped;
+        item["aborted"] = (Json::UInt64)encoder.aborted;
+        item["pipe_size"] = encoder.pipeSize;
+        item["state"] = FFmpegStreamer::stateName(encoder.state);
+        item["pid"] = encoder.pid;
+        item["restarts"] = encoder.restarts;
+        item["last_exit"] = encoder.lastExit;
+        item["last_error"] = encoder.lastError;
+        item["uptime"] = encoder.uptime;
+        item["codec"] = FFmpegStreamer::codecName(encoder.codec);
+        item["cpu_percent"] = encoder.cpu;
+        item["cpu_seconds"] = encoder.cpuSeconds;
+        item["fps"] = encoder.progress.fps;
+        item["bitrate_kbps"] = encoder.progress.bitrateKbps;
+        item["speed"] = encoder.progress.speed;
+        item["encoded_frames"] = (Json::UInt64)encoder.progress.frame;
+        item["encoder_dropped"] = (Json::UInt64)encoder.progress.dropFrames;
+        item["encoder_duplicated"] = (Json::UInt64)encoder.progress.dupFrames;
+        for (size_t i = 0; i < encoder.outputs.size(); ++i) {
+            static const char* types[] = {"rtmp", "hls", "file"};
+            Json::Value output;
+            output["type"] = types[static_cast<int>(encoder.outputs[i].type)];
+            output["target"] = encoder.outputs[i].target;
+            output["failed"] = encoder.outputFailed[i] ? true : false;
+            item["outputs"].append(output);
+        }
+        ret["encoders"].append(item);
+    }
+    WsLiveHub::Stats ws = wsHub.stats();
+    ret["ws"]["sessions"] = (Json::UInt64)ws.sessions;
+    ret["ws"]["sent"] = (Json::UInt64)ws.sent;
+    ret["ws"]["skipped"] = (Json::UInt64)ws.skipped;
+    ret["rtsp"] = Json::Value(Json::arrayValue);
+    for (const auto& session : rtspServer.stats()) {
+        Json::Value item;
+        item["id"] = session.id;
+        item["transport"] = session.transport;
+        item["client"] = session.client;
+        item["playing"] = session.playing;
+        item["frames"] = (Json::UInt64)session.frames;
+        item["packets"] = (Json::UInt64)session.packets;
+        item["bytes"] = (Json::UInt64)session.bytes;
+        item["skipped"] = (Json::UInt64)session.skipped;
+        item["dropped"] = (Json::UInt64)session.dropped;
+        item["fraction_lost"] = session.fractionLost;
+        item["cumulative_lost"] = session.cumulativeLost;
+        item["jitter"] = session.jitter;
+        item["age_ms"] = (Json::Int64)session.ageMs;
+        ret["rtsp"].append(item);
+    }
+    if (multicastSubscription != 0) {
+        RtpMulticastSender::Config config = multicastSender.currentConfig();
+        RtpMulticastSender::Stats multicast = multicastSender.stats();
+        ret["multicast"]["group"] = config.group;
+        ret["multicast"]["port"] = config.port;
+        ret["multicast"]["ttl"] = config.ttl;
+        ret["multicast"]["frames"] = (Json::UInt64)multicast.frames;
+        ret["multicast"]["packets"] = (Json::UInt64)multicast.packets;
+        ret["multicast"]["bytes"] = (Json::UInt64)multicast.bytes;
+        ret["multicast"]["dropped"] = (Json::UInt64)multicast.dropped;
+        ret["multicast"]["unsupported"] = (Json::UInt64)multicast.unsupported;
+    }
+    if (hlsSubscription != 0) {
+        HlsSegmenter::Stats hls = hlsSegmenter.stats();
+        ret["hls"]["running"] = hls.running;
+        ret["hls"]["first_msn"] = (Json::UInt64)hls.firstMsn;
+        ret["hls"]["last_msn"] = (Json::UInt64)hls.lastMsn;
+        ret["hls"]["segments"] = (Json::UInt64)hls.segments;
+        ret["hls"]["parts"] = (Json::UInt64)hls.parts;
+        ret["hls"]["bytes"] = (Json::UInt64)hls.bytes;
+        ret["hls"]["memory"] = (Json::UInt64)hls.memory;
+        ret["hls"]["waiters"] = (Json::UInt64)hls.waiters;
+        ret["hls"]["restarts"] = hls.restarts;
+        ret["hls"]["dropped"] = (Json::UInt64)hls.dropped;
+        ret["hls"]["last_error"] = hls.lastError;
+    }
+    if (shmSubscription != 0) {
+        ShmFrameWriter::Stats shm = shmWriter.stats();
+        ret["shm"]["name"] = shm.name;
+        ret["shm"]["slots"] = shm.slotCount;
+        ret["shm"]["slot_size"] = shm.slotSize;
+        ret["shm"]["frames"] = (Json::UInt64)shm.frames;
+        ret["shm"]["bytes"] = (Json::UInt64)shm.bytes;
+        ret["shm"]["oversize"] = (Json::UInt64)shm.oversize;
+    }
+    ret["mjpeg_variants"] = Json::Value(Json::arrayValue);
+    for (const auto& variant : mjpegHub.stats()) {
+        Json::Value item;
+        item["name"] = variant.name;
+        item["clients"] = (Json::UInt64)variant.clients;
+        item["frames"] = (Json::UInt64)variant.frames;
+        item["failed"] = (Json::UInt64)variant.failed;
+        item["skipped"] = (Json::UInt64)variant.skipped;
+        ret["mjpeg_variants"].append(item);
+    }
+    return ret;
 }
 
 bool SonyCamera::zoom(ZoomOperation operation) 
 {
     if (camera == nullptr) {
-        cli::tout << "camera not create\n";
+        LOG_WARN("camera not create");
         return false;
     }
     int speed = 0;
@@ -297,7 +722,7 @@ bool SonyCamera::zoom(ZoomOperation operation)
 bool SonyCamera::zoom_fix(int scale)
 {
     if (camera == nullptr) {
-        cli::tout << "camera not create\n";
+        LOG_WARN("camera not create");
         return false;
     }
     // CrDeviceProperty_DigitalZoomScale
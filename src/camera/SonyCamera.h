@@ -21,6 +21,15 @@ namespace fs = std::filesystem;
 #include <thread>
 #include "CRSDK/CameraRemote_SDK.h"
 #include "CameraDevice.h"
+#include "LiveViewPipeline.h"
+#include "MjpegStreamHub.h"
+#include "SnapshotStore.h"
+#include "WsLiveHub.h"
+#include "RtspServer.h"
+#include "RtpMulticastSender.h"
+#include "HlsSegmenter.h"
+#include "ShmFrameWriter.h"
+#include "FFmpegStreamer.h"
 #include "Text.h"
 #include <json/json.h>
 #include "json.hpp"
@@ -30,8 +39,6 @@ namespace SDK = SCRSDK;
 typedef std::shared_ptr<cli::CameraDevice> CameraDevicePtr;
 typedef std::vector<CameraDevicePtr> CameraDeviceList;
 
-static std::atomic<bool> isLiveRunning{false};
-
 enum LiveType {
     NONE, REMOTE, LOCAL
 };
@@ -50,8 +57,36 @@ class SonyCamera {
         CameraDeviceList cameraList;
         CameraDevicePtr camera;
         bool isInitialized = false;
+        // 预览sink，需在 livePipeline 之前声明，保证总线线程先于sink析构
+        MjpegStreamHub mjpegHub;
+        WsLiveHub wsHub;
+        RtspServer rtspServer;
+        RtpMulticastSender multicastSender;
+        HlsSegmenter hlsSegmenter;
+        ShmFrameWriter shmWriter;
+        FFmpegStreamer rtmpStreamer{"rtmp"};
+        FFmpegStreamer recorder{"record"};
+        FFmpegStreamer multiStreamer{"multi"};
+        // 最新帧，供快照接口读取，需在 livePipeline 之前声明
+        SnapshotStore snapshotStore;
+        FrameBus::SubscriptionId rtmpSubscription = 0;
+        FrameBus::SubscriptionId recordSubscription = 0;
+        FrameBus::SubscriptionId rtspSubscription = 0;
+        FrameBus::SubscriptionId multicastSubscription = 0;
+        FrameBus::SubscriptionId hlsSubscription = 0;
+        FrameBus::SubscriptionId shmSubscription = 0;
+        FrameBus::SubscriptionId multiSubscription = 0;
+        std::atomic<bool> mjpegActive{false};
+        std::atomic<bool> wsActive{false};
+        std::atomic<bool> rtspActive{false};
+        void ensure_live_pipeline();
+        void stop_live_if_idle();
+        // 开启时启动输出、订阅总线并持有取帧；关闭时按相反顺序撤销。已开启/已关闭时直接返回 true
+        bool enable_sink(bool enable, const std::string& name, FrameBus::SubscriptionId& subscription,
+                         const std::function<bool ()>& start, const std::function<void ()>& stop,
+                         const FrameBus::Handler& push, const FrameBus::SinkOptions& options);
     public:
-        std::thread liveThread;
+        LiveViewPipeline livePipeline;
         SDK::ICrEnumCameraObjectInfo* camera_list = nullptr;
         LiveType liveType = LiveType::NONE;
 
@@ -64,10 +99,45 @@ class SonyCamera {
         bool af_shutter(std::function<void (std::string)>* cb);
         bool capture();
         std::string get_save_path();
+        // 录像和多路推流的文件/HLS目标所在目录，默认为当前目录下的 recordings，可用环境变量 CAMERA_RECORD_DIR 指定
+        std::string record_dir();
+        // 把客户端给出的相对路径解析到录像目录下，绝对路径、含 .. 或 : 时返回 false
+        bool resolve_record_path(const std::string& relative, std::string& resolved);
         void power_off();
         void power_on();
         bool live_view();
         bool enable_live_view(bool enable, bool isLocal, std::string& rtmpUrl);
+        // codec 为 Copy 时不转码，直接把预览JPEG封装进 mkv/avi
+        bool enable_record(bool enable, const std::string& path,
+                           FFmpegStreamer::VideoCodec codec = FFmpegStreamer::VideoCodec::H264);
+        // 一次编码同时推送/录制到多个目标，单个目标失败不影响其他目标
+        bool enable_multi_stream(bool enable, const std::vector<FFmpegStreamer::Output>& outputs, int bitrate,
+                                 FFmpegStreamer::VideoCodec codec = FFmpegStreamer::VideoCodec::H264);
+        bool enable_multicast(bool enable, const RtpMulticastSender::Config& config);
+        // 组播接收端用的SDP，未开启返回空
+        std::string multicast_sdp(const std::string& origin);
+        bool enable_hls(bool enable);
+        // 内存中的 LL-HLS 切片，drogon IO 线程直接读取，不加相机锁
+        HlsSegmenter& hls() { return hlsSegmenter; }
+        bool enable_shm(bool enable, const ShmFrameWriter::Config& config);
+        // 共享内存帧环的 shm_open 名称，未开启返回空
+        std::string shm_name();
+        void set_live_idle_grace(int milliseconds);
+        Json::Value live_view_stats();
+        // 当前连接相机的序号，未连接返回 -1
+        int camera_number();
+        // 局域网预览是否已开启
+        bool mjpeg_enabled();
+        // 最新预览帧，快照接口使用，不调用SDK
+        SnapshotStore& snapshots() { return snapshotStore; }
+        WsLiveHub& ws_hub() { return wsHub; }
+        // 内置RTSP服务端口，未开启返回0
+        int rtsp_port() { return rtspServer.isRunning() ? rtspServer.port() : 0; }
+        // MJPEG转码规格数是否允许该规格的新观看者
+        bool mjpeg_variant_available(const MjpegStreamHub::VariantKey& variant) { return mjpegHub.hasCapacity(variant); }
+        // 接收一个MJPEG观看者，在 drogon IO 线程调用，不加相机锁
+        bool add_mjpeg_client(drogon::ResponseStreamPtr stream, const std::weak_ptr<trantor::TcpConnection>& conn,
+                              const MjpegStreamHub::VariantKey& variant = MjpegStreamHub::VariantKey());
 
         bool zoom(ZoomOperation operation);
         bool zoom_fix(int scale);
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <drogon/WebSocketConnection.h>
+#include "FramePool.h"
+#include "FrameBus.h"
+#include "Logger.h"
+#include "Metrics.h"
+
+/**
+ * WebSocket 二进制预览通道
+ * 每帧一条二进制消息：16字节头（大端）+ JPEG
+ *   uint32 帧号 | int64 采集时刻（Unix 微秒） | uint32 JPEG长度
+ * 流控由客户端驱动：每个连接有一个额度窗口，发一帧消耗一个额度，
+ * 客户端回 {"ack": 帧号} 确认该帧及之前发出的帧并归还额度；没有额度时只保留最新一帧，
+ * 弱网下不会在socket缓冲区里堆积，端到端延迟有上界。
+ */
+class WsLiveHub {
+public:
+    static constexpr size_t HeaderSize = 16;
+    static constexpr int MaxWindow = 8;
+
+    struct Stats {
+        size_t sessions = 0;
+        uint64_t sent = 0;
+        uint64_t skipped = 0;       // 没有额度时被新帧替换的帧数
+    };
+
+    // 连接数量变化回调，在锁外调用
+    void setClientCountCallback(std::function<void (size_t)> cb) {
+        onClientCountChanged = cb;
+    }
+
+    // 挂到总线上，预览开启时调用
+    void attach(FrameBus& frameBus) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (bus != nullptr) return;
+        bus = &frameBus;
+        // 分发只做投递，不会阻塞；队列保持很浅
+        subscription = bus->subscribe("ws", [this](const FramePtr& frame) {
+            onFrame(frame);
+        }, FrameBus::SinkOptions(2, FrameBus::DropPolicy::DropOldest, 0, false, &sinkMetrics));
+    }
+
+    bool isAttached() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return bus != nullptr;
+    }
+
+    // 取消订阅并关闭所有连接
+    void detach() {
+        FrameBus* frameBus = nullptr;
+        FrameBus::SubscriptionId id = 0;
+        std::vector<std::shared_ptr<Session>> closing;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            frameBus = bus;
+            id = subscription;
+            bus = nullptr;
+            subscription = 0;
+            closing.swap(sessions);
+        }
+        if (frameBus) frameBus->unsubscribe(id);
+        for (auto& session : closing) {
+            session->conn->shutdown(drogon::CloseCode::kEndpointGone, "live view disabled");
+        }
+        if (!closing.empty()) notifyCount(0);
+    }
+
+    /**
+     * 新连接
+     * @param window 初始额度，1 表示逐帧确认
+     * @return false 表示预览未开启
+     */
+    bool add(const drogon::WebSocketConnectionPtr& conn, int window) {
+        auto session = std::make_shared<Session>();
+        session->conn = conn;
+        session->window = clampWindow(window);
+        session->credits = session->window;
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (bus == nullptr) return false;
+            sessions.push_back(session);
+            count = sessions.size();
+        }
+        conn->setContext(session);
+        notifyCount(count);
+        return true;
+    }
+
+    void remove(const drogon::WebSocketConnectionPtr& conn) {
+        auto session = conn->getContext<Session>();
+        if (!session) return;
+        size_t count = 0;
+        bool removed = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto it = sessions.begin(); it != sessions.end(); ++it) {
+                if (*it == session) {
+                    sessions.erase(it);
+                    removed = true;
+                    break;
+                }
+            }
+            count = sessions.size();
+        }
+        conn->clearContext();
+        if (removed) notifyCount(count);
+    }
+
+    /**
+     * 客户端确认到 frameNo 为止的帧，每确认一帧归还一个额度；有积压的最新帧立即发出
+     * 只有与已发出帧相同或更新的帧号才算数，重复、过期的确认被忽略
+     */
+    void ack(const drogon::WebSocketConnectionPtr& conn, uint32_t frameNo) {
+        auto session = conn->getContext<Session>();
+        if (!session) return;
+        std::lock_guard<std::mutex> lock(session->mutex);
+        std::chrono::steady_clock::time_point sentAt;
+        int acked = 0;
+        // 按模 2^32 比较帧号，帧号回绕后仍然有序
+        while (!session->inflight.empty() &&
+               static_cast<int32_t>(frameNo - session->inflight.front().frameNo) >= 0) {
+            sentAt = session->inflight.front().sentAt;
+            session->inflight.pop_front();
+            acked++;
+        }
+        if (acked == 0) return;
+        // 从发出被确认的那一帧到收到确认的往返时间
+        ackLatency.observeSince(sentAt);
+        session->credits = std::min(session->credits + acked, session->window);
+        if (session->pending) {
+            FramePtr frame = std::move(session->pending);
+            session->pending.reset();
+            sendLocked(*session, frame, encode(frame));
+        }
+    }
+
+    // 调整额度窗口
+    void setWindow(const drogon::WebSocketConnectionPtr& conn, int window) {
+        auto session = conn->getContext<Session>();
+        if (!session) return;
+        std::lock_guard<std::mutex> lock(session->mutex);
+        window = clampWindow(window);
+        session->credits += window - session->window;
+        session->window = window;
+    }
+
+
+    Stats stats() {
+        Stats s;
+        std::lock_guard<std::mutex> lock(mutex);
+        s.sessions = sessions.size();
+        s.sent = sentFrames;
+        s.skipped = skippedFrames;
+        return s;
+    }
+
+    // 16字节帧头 + JPEG
+    static std::string encode(const FramePtr& frame) {
+        std::string data(HeaderSize + frame->size, '\0');
+        uint8_t* p = reinterpret_cast<uint8_t*>(&data[0]);
+        int64_t captureUs = toUnixMicros(frame->timestamp);
+        putBE(p, frame->frameNo, 4);
+        putBE(p + 4, static_cast<uint64_t>(captureUs), 8);
+        putBE(p + 12, frame->size, 4);
+        memcpy(p + HeaderSize, frame->data(), frame->size);
+        return data;
+    }
+
+    ~WsLiveHub() { detach(); }
+
+private:
+    struct Inflight {
+        uint32_t frameNo;
+        std::chrono::steady_clock::time_point sentAt;
+    };
+
+    struct Session {
+        drogon::WebSocketConnectionPtr conn;
+        std::mutex mutex;
+        int window = 1;
+        int credits = 1;
+        FramePtr pending;       // 没有额度时等待发送的最新帧
+        std::deque<Inflight> inflight;  // 已发出未确认的帧，按发送顺序
+    };
+
+    static int clampWindow(int window) {
+        return window < 1 ? 1 : (window > MaxWindow ? MaxWindow : window);
+    }
+
+    static void putBE(uint8_t* p, uint64_t value, int bytes) {
+        for (int i = bytes - 1; i >= 0; --i) {
+            p[i] = static_cast<uint8_t>(value & 0xFF);
+            value >>= 8;
+        }
+    }
+
+    // 帧时间戳是 steady_clock，换算为墙钟供浏览器计算端到端延迟
+    static int64_t toUnixMicros(std::chrono::steady_clock::time_point t) {
+        auto age = std::chrono::steady_clock::now() - t;
+        auto wall = std::chrono::system_clock::now() - age;
+        return std::chrono::duration_cast<std::chrono::microseconds>(wall.time_since_epoch()).count();
+    }
+
+    // 需持有 session.mutex
+    void sendLocked(Session& session, const FramePtr& frame, const std::string& data) {
+        session.conn->send(data, drogon::WebSocketMessageType::Binary);
+        session.credits--;
+        session.inflight.push_back(Inflight{frame->frameNo, std::chrono::steady_clock::now()});
+        // 窗口调小后客户端可能不再确认旧帧，只保留窗口上限内的记录
+        if (session.inflight.size() > static_cast<size_t>(MaxWindow)) session.inflight.pop_front();
+        sentFrames++;
+        sinkMetrics.addBytes(data.size());
+        sinkMetrics.observeWire(frame->timestamp);
+    }
+
+    // 总线sink线程调用
+    void onFrame(const FramePtr& frame) {
+        if (!frame || frame->empty()) return;
+        std::vector<std::shared_ptr<Session>> current;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = sessions;
+        }
+        // 消息体只编码一次，所有有额度的连接共用
+        std::string data;
+        for (auto& session : current) {
+            if (!session->conn->connected()) continue;
+            std::lock_guard<std::mutex> lock(session->mutex);
+            if (session->credits > 0) {
+                if (data.empty()) data = encode(frame);
+                sendLocked(*session, frame, data);
+            } else {
+                if (session->pending) {
+                    skippedFrames++;
+                    skippedTotal.add();
+                }
+                session->pending = frame;
+            }
+        }
+    }
+
+    void notifyCount(size_t count) {
+        clientsGauge.set(count);
+        if (onClientCountChanged) onClientCountChanged(count);
+    }
+
+    FrameBus* bus = nullptr;
+    FrameBus::SubscriptionId subscription = 0;
+    std::mutex mutex;                                   // 保护 bus 和 sessions
+    std::vector<std::shared_ptr<Session>> sessions;
+    std::atomic<uint64_t> sentFrames{0};
+    std::atomic<uint64_t> skippedFrames{0};
+    std::function<void (size_t)> onClientCountChanged;
+    MetricHistogram& ackLatency = Metrics::instance().histogram("ws_ack_seconds",
+        "Time from sending a WebSocket frame to the client acking it");
+    SinkMetrics sinkMetrics{"ws"};
+    MetricCounter& skippedTotal = Metrics::instance().counter("ws_frames_skipped_total",
+        "Frames replaced while a WebSocket client had no credit");
+    MetricGauge& clientsGauge = Metrics::instance().gauge("ws_clients",
+        "Connected WebSocket preview clients");
+};
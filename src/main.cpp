@@ -14,6 +14,10 @@
 #include "DocController.h"
 #include "UserController.h"
 #include "CameraController.h"
+#include "SystemController.h"
+#include "LiveWsController.h"
+#include "Logger.h"
+#include "Metrics.h"
 #include "json.hpp"
 
 using namespace std;
@@ -52,9 +56,12 @@ int main()
     cli::tout.imbue(std::locale());
     
     // drogon::app().registerController(std::make_shared<UserController>());
-    drogon::app().registerController(std::make_shared<CameraController>());
+    auto cameraController = std::make_shared<CameraController>();
+    drogon::app().registerController(cameraController);
+    drogon::app().registerController(std::make_shared<LiveWsController>(cameraController->sony_camera()));
     // 注册文档控制器
     drogon::app().registerController(std::make_shared<DocController>());
+    drogon::app().registerController(std::make_shared<SystemController>());
     drogon::app()
         .registerHandler("/version", [](const drogon::HttpRequestPtr&,
                                     std::function<void(const drogon::HttpResponsePtr&)>&& cb) {
@@ -63,6 +70,14 @@ int main()
             resp->setBody(version.c_str());
             cb(resp);
         })
+        .registerHandler("/metrics", [](const drogon::HttpRequestPtr&,
+                                    std::function<void(const drogon::HttpResponsePtr&)>&& cb) {
+            // Prometheus 抓取入口
+            auto resp = drogon::HttpResponse::newHttpResponse();
+            resp->setContentTypeString("text/plain; version=0.0.4; charset=utf-8");
+            resp->setBody(Metrics::instance().render());
+            cb(resp);
+        })
         .registerHandler("/capture", [](const drogon::HttpRequestPtr& req,
                     std::function<void(const drogon::HttpResponsePtr&)>&& cb) {
             auto resp = drogon::HttpResponse::newHttpResponse();
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <sstream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+#include "FrameRing.h"
+
+enum class LogLevel : int {
+    Trace = 0,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+/**
+ * 异步分级日志
+ * 业务线程只把日志写入无锁队列，由后台线程统一输出到stdout，
+ * 队列满时丢弃最旧的日志，不会阻塞采集等热路径。
+ *
+ * 使用方式：
+ *   LOG_INFO("connect result: " << ret);
+ *   LOG_EVERY_MS(LogLevel::Warn, 5000, "GetLiveView FAILED");   // 每个调用点5秒最多输出一次
+ */
+class Logger {
+public:
+    struct Record {
+        LogLevel level = LogLevel::Info;
+        std::chrono::system_clock::time_point time;
+        const char* file = nullptr;
+        int line = 0;
+        std::string message;
+    };
+
+    static Logger& instance() {
+        // 有意不析构：全局对象析构时仍可能打日志
+        static Logger* logger = new Logger();
+        return *logger;
+    }
+
+    bool enabled(LogLevel level) const {
+        return level >= this->level.load(std::memory_order_relaxed);
+    }
+
+    void setLevel(LogLevel level) { this->level = level; }
+    LogLevel getLevel() const { return level; }
+    uint64_t droppedCount() const { return dropped; }
+
+    void write(LogLevel level, const char* file, int line, std::string message) {
+        Record record;
+        record.level = level;
+        record.time = std::chrono::system_clock::now();
+        record.file = file;
+        record.line = line;
+        record.message = std::move(message);
+        dropped += queue.push(std::move(record));
+        if (sleeping.load()) {
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+            }
+            wakeCv.notify_one();
+        }
+    }
+
+    // 等待队列中的日志全部输出
+    void flush() {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        drain();
+    }
+
+    static const char* levelName(LogLevel level) {
+        switch (level) {
+        case LogLevel::Trace: return "trace";
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info: return "info";
+        case LogLevel::Warn: return "warn";
+        case LogLevel::Error: return "error";
+        default: return "off";
+        }
+    }
+
+    static bool parseLevel(const std::string& name, LogLevel& level) {
+        std::string lower = name;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        for (int i = (int)LogLevel::Trace; i <= (int)LogLevel::Off; ++i) {
+            if (lower == levelName((LogLevel)i)) {
+                level = (LogLevel)i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    Logger() : queue(4096) {
+        worker = std::thread(&Logger::drainLoop, this);
+        worker.detach();
+        std::atexit([]() { Logger::instance().flush(); });
+    }
+
+    void drainLoop() {
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                drain();
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            sleeping = true;
+            if (queue.size() == 0) {
+                wakeCv.wait_for(lock, std::chrono::milliseconds(50));
+            }
+            sleeping = false;
+        }
+    }
+
+    void drain() {
+        Record record;
+        bool wrote = false;
+        while (queue.pop(record)) {
+            print(record);
+            wrote = true;
+        }
+        uint64_t lost = dropped.exchange(0);
+        if (lost > 0) {
+            std::fprintf(stdout, "[logger] %llu log records dropped\n", (unsigned long long)lost);
+            wrote = true;
+        }
+        if (wrote) std::fflush(stdout);
+    }
+
+    static void print(const Record& record) {
+        static const char tags[] = {'T', 'D', 'I', 'W', 'E', 'O'};
+        std::time_t t = std::chrono::system_clock::to_time_t(record.time);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(record.time.time_since_epoch()).count() % 1000;
+        std::tm tm;
+        localtime_r(&t, &tm);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+        if (record.file) {
+            const char* name = record.file;
+            for (const char* p = record.file; *p; ++p) {
+                if (*p == '/') name = p + 1;
+            }
+            std::fprintf(stdout, "%s.%03d %c [%s:%d] %s\n", stamp, (int)ms, tags[(int)record.level],
+                         name, record.line, record.message.c_str());
+        } else {
+            std::fprintf(stdout, "%s.%03d %c %s\n", stamp, (int)ms, tags[(int)record.level], record.message.c_str());
+        }
+    }
+
+    FrameRing<Record> queue;
+    std::atomic<LogLevel> level{LogLevel::Info};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> sleeping{false};
+    std::thread worker;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    std::mutex outputMutex;
+};
+
+/**
+ * 调用点级别的限频
+ * 每个 LOG_EVERY_MS 调用点有一个独立实例，记录被抑制的条数
+ */
+class LogRateLimiter {
+public:
+    explicit LogRateLimiter(int64_t intervalMs) : intervalMs(intervalMs) {}
+
+    bool allow(uint64_t& suppressed) {
+        int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t due = next.load(std::memory_order_relaxed);
+        if (now < due || !next.compare_exchange_strong(due, now + intervalMs)) {
+            skipped++;
+            return false;
+        }
+        suppressed = skipped.exchange(0);
+        return true;
+    }
+
+private:
+    int64_t intervalMs;
+    std::atomic<int64_t> next{0};
+    std::atomic<uint64_t> skipped{0};
+};
+
+#define LOG_AT(level, expr) \
+    do { \
+        if (Logger::instance().enabled(level)) { \
+            std::ostringstream _logStream; \
+            _logStream << expr; \
+            Logger::instance().write(level, __FILE__, __LINE__, _logStream.str()); \
+        } \
+    } while (0)
+
+#define LOG_TRACE(expr) LOG_AT(LogLevel::Trace, expr)
+#define LOG_DEBUG(expr) LOG_AT(LogLevel::Debug, expr)
+#define LOG_INFO(expr) LOG_AT(LogLevel::Info, expr)
+#define LOG_WARN(expr) LOG_AT(LogLevel::Warn, expr)
+#define LOG_ERROR(expr) LOG_AT(LogLevel::Error, expr)
+
+#define LOG_EVERY_MS(level, intervalMs, expr) \
+    do { \
+        if (Logger::instance().enabled(level)) { \
+            static LogRateLimiter _logLimiter(intervalMs); \
+            uint64_t _logSuppressed = 0; \
+            if (_logLimiter.allow(_logSuppressed)) { \
+                std::ostringstream _logStream; \
+                _logStream << expr; \
+                if (_logSuppressed > 0) _logStream << " (suppressed " << _logSuppressed << ")"; \
+                Logger::instance().write(level, __FILE__, __LINE__, _logStream.str()); \
+            } \
+        } \
+    } while (0)
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <locale>
+#include <utility>
+
+/**
+ * 计数器，只增不减
+ */
+class MetricCounter {
+public:
+    void add(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+/**
+ * 仪表，可增可减
+ */
+class MetricGauge {
+public:
+    void set(int64_t v) { value.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value{0};
+};
+
+/**
+ * 延迟直方图
+ * 桶边界固定（秒），observe 只做原子加，可在采集线程和sink线程直接调用
+ */
+class MetricHistogram {
+public:
+    typedef std::chrono::steady_clock::duration Duration;
+
+    explicit MetricHistogram(const std::vector<double>& bounds)
+        : bounds(bounds), buckets(new std::atomic<uint64_t>[bounds.size() + 1]) {
+        for (size_t i = 0; i <= bounds.size(); ++i) buckets[i] = 0;
+    }
+
+    void observe(Duration d) {
+        int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+        if (us < 0) us = 0;
+        double seconds = us / 1e6;
+        size_t i = 0;
+        while (i < bounds.size() && seconds > bounds[i]) ++i;
+        buckets[i].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sumUs.fetch_add(static_cast<uint64_t>(us), std::memory_order_relaxed);
+    }
+
+    void observeSince(std::chrono::steady_clock::time_point start) {
+        if (start.time_since_epoch().count() == 0) return;
+        observe(std::chrono::steady_clock::now() - start);
+    }
+
+    const std::vector<double>& bucketBounds() const { return bounds; }
+    uint64_t bucketCount(size_t i) const { return buckets[i].load(std::memory_order_relaxed); }
+    uint64_t totalCount() const { return count.load(std::memory_order_relaxed); }
+    double sumSeconds() const { return sumUs.load(std::memory_order_relaxed) / 1e6; }
+
+private:
+    std::vector<double> bounds;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sumUs{0};
+};
+
+/**
+ * 指标注册表，按 Prometheus 文本格式导出
+ * 同名同标签的指标只创建一次，返回的引用在进程生命周期内有效，
+ * 热路径应缓存引用而不是每次查找。
+ *
+ * 使用方式：
+ *   static MetricHistogram& h = Metrics::instance().histogram("live_fetch_seconds", "...", {{"camera", "1"}});
+ *   h.observe(end - start);
+ */
+class Metrics {
+public:
+    typedef std::vector<std::pair<std::string, std::string>> Labels;
+
+    static Metrics& instance() {
+        // 有意不析构：sink线程退出时仍可能更新指标
+        static Metrics* metrics = new Metrics();
+        return *metrics;
+    }
+
+    // 预览链路延迟的默认桶：0.5ms ~ 2.5s
+    static const std::vector<double>& latencyBuckets() {
+        static const std::vector<double> bounds = {
+            0.0005, 0.001, 0.0025, 0.005, 0.01, 0.02, 0.035, 0.05, 0.075, 0.1, 0.15, 0.25, 0.5, 1, 2.5
+        };
+        return bounds;
+    }
+
+    MetricCounter& counter(const std::string& name, const std::string& help, const Labels& labels = Labels()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Family& family = getFamily(name, help, "counter");
+        auto& metric = family.counters[formatLabels(labels)];
+        if (!metric) metric.reset(new MetricCounter());
+        return *metric;
+    }
+
+    MetricGauge& gauge(const std::string& name, const std::string& help, const Labels& labels = Labels()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Family& family = getFamily(name, help, "gauge");
+        auto& metric = family.gauges[formatLabels(labels)];
+        if (!metric) metric.reset(new MetricGauge());
+        return *metric;
+    }
+
+    MetricHistogram& histogram(const std::string& name, const std::string& help, const Labels& labels = Labels(),
+                               const std::vector<double>& bounds = latencyBuckets()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Family& family = getFamily(name, help, "histogram");
+        auto& metric = family.histograms[formatLabels(labels)];
+        if (!metric) metric.reset(new MetricHistogram(bounds));
+        return *metric;
+    }
+
+    // 导出 Prometheus 文本格式（text/plain; version=0.0.4）
+    std::string render() const {
+        std::ostringstream out;
+        // main() 把全局 locale 设为系统本地，数字可能带千分位，导出时固定用 C locale
+        out.imbue(std::locale::classic());
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& item : families) {
+            const std::string& name = item.first;
+            const Family& family = item.second;
+            out << "# HELP " << name << " " << family.help << "\n";
+            out << "# TYPE " << name << " " << family.type << "\n";
+            for (const auto& m : family.counters) {
+                out << name << braces(m.first) << " " << m.second->get() << "\n";
+            }
+            for (const auto& m : family.gauges) {
+                out << name << braces(m.first) << " " << m.second->get() << "\n";
+            }
+            for (const auto& m : family.histograms) {
+                const MetricHistogram& h = *m.second;
+                const std::string& labels = m.first;
+                std::string sep = labels.empty() ? "" : ",";
+                uint64_t cumulative = 0;
+                for (size_t i = 0; i < h.bucketBounds().size(); ++i) {
+                    cumulative += h.bucketCount(i);
+                    out << name << "_bucket{" << labels << sep << "le=\"" << h.bucketBounds()[i] << "\"} "
+                        << cumulative << "\n";
+                }
+                cumulative += h.bucketCount(h.bucketBounds().size());
+                out << name << "_bucket{" << labels << sep << "le=\"+Inf\"} " << cumulative << "\n";
+                out << name << "_sum" << braces(labels) << " " << h.sumSeconds() << "\n";
+                out << name << "_count" << braces(labels) << " " << h.totalCount() << "\n";
+            }
+        }
+        return out.str();
+    }
+
+private:
+    struct Family {
+        std::string help;
+        std::string type;
+        std::map<std::string, std::unique_ptr<MetricCounter>> counters;
+        std::map<std::string, std::unique_ptr<MetricGauge>> gauges;
+        std::map<std::string, std::unique_ptr<MetricHistogram>> histograms;
+    };
+
+    Metrics() = default;
+
+    Family& getFamily(const std::string& name, const std::string& help, const char* type) {
+        Family& family = families[name];
+        if (family.type.empty()) {
+            family.help = help;
+            family.type = type;
+        }
+        return family;
+    }
+
+    static std::string formatLabels(const Labels& labels) {
+        std::string ret;
+        for (const auto& label : labels) {
+            if (!ret.empty()) ret += ",";
+            ret += label.first + "=\"";
+            for (char c : label.second) {
+                if (c == '"' || c == '\\') ret += '\\';
+                if (c == '\n') {
+                    ret += "\\n";
+                    continue;
+                }
+                ret += c;
+            }
+            ret += "\"";
+        }
+        return ret;
+    }
+
+    static std::string braces(const std::string& labels) {
+        return labels.empty() ? "" : "{" + labels + "}";
+    }
+
+    mutable std::mutex mutex;
+    std::map<std::string, Family> families;
+};
+
+/**
+ * 预览sink的输出指标：live_capture_to_wire_seconds 和 live_sink_bytes_total，按 {camera, sink} 打标签
+ * sink 对象在相机连接前就已构造，取帧开始前由 bind() 绑定到该相机的序列，未绑定时不记录。
+ */
+class SinkMetrics {
+public:
+    explicit SinkMetrics(const std::string& sink) : sink(sink) {}
+
+    void bind(int camera) {
+        Metrics::Labels labels = {{"camera", std::to_string(camera)}, {"sink", sink}};
+        wire.store(&Metrics::instance().histogram("live_capture_to_wire_seconds",
+            "Time from GetLiveViewImage return to the frame being written out", labels), std::memory_order_release);
+        bytes.store(&Metrics::instance().counter("live_sink_bytes_total",
+            "Bytes written out by a sink", labels), std::memory_order_release);
+    }
+
+    void observeWire(std::chrono::steady_clock::time_point captured) {
+        MetricHistogram* h = wire.load(std::memory_order_acquire);
+        if (h) h->observeSince(captured);
+    }
+
+    void addBytes(uint64_t n) {
+        MetricCounter* c = bytes.load(std::memory_order_acquire);
+        if (c) c->add(n);
+    }
+
+private:
+    std::string sink;
+    std::atomic<MetricHistogram*> wire{nullptr};
+    std::atomic<MetricCounter*> bytes{nullptr};
+};
@@ -0,0 +1,228 @@
+/**
+ * 局域网MJPEG预览观看者数量扩展基准
+ * 对运行中的服务依次打开 N 个 /api/camera/{id}/live.mjpg 长连接（N 取参数列表中的每个值），
+ * 单线程 epoll 非阻塞读取，按 multipart 分隔符统计每个连接收到的帧数和字节数，
+ * 输出每一档的总帧率、单连接帧率的最小/平均/最大值和总带宽。
+ * 可另开若干个只连接不读取的慢客户端（接收缓冲区很小），观察它们是否拖慢正常观看者。
+ * 服务需要已经以 is_local=true 打开预览（模拟后端即可），本程序不链接服务端代码。
+ *
+ * 用法：mjpeg_client_scaling_bench <host> [端口=9090] [相机序号=1] [每档秒数=10] [观看者数列表=1,2,4,8,16,32,64] [慢客户端数=0] [查询参数]
+ * 例：mjpeg_client_scaling_bench 127.0.0.1 9090 1 10 1,8,64 2 "fps=15"
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// MjpegFrame 每帧的分隔符和帧头，每个 chunk 以它开头
+const std::string PartMarker = "--frame\r\nContent-Type: image/jpeg\r\n";
+
+struct Client {
+    int fd = -1;
+    bool slow = false;
+    bool headerDone = false;
+    bool failed = false;
+    std::string header;             // 响应头，读到空行为止
+    std::string tail;               // 上次读取末尾不足一个分隔符的部分，分隔符可能跨两次读取
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+};
+
+int connectTo(const addrinfo* addr) {
+    int fd = socket(addr->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, addr->ai_addr, addr->ai_addrlen) < 0) {
+        close(fd);
+        return -1;
+    }
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return fd;
+}
+
+// 统计一段数据里的帧分隔符
+void countParts(Client& client, const char* data, size_t size) {
+    client.tail.append(data, size);
+    size_t pos = 0;
+    while ((pos = client.tail.find(PartMarker, pos)) != std::string::npos) {
+        client.frames++;
+        pos += PartMarker.size();
+    }
+    size_t keep = std::min(client.tail.size(), PartMarker.size() - 1);
+    client.tail.erase(0, client.tail.size() - keep);
+}
+
+void handleRead(Client& client, char* buffer, size_t capacity) {
+    while (true) {
+        ssize_t n = recv(client.fd, buffer, capacity, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n <= 0) {
+            client.failed = true;
+            return;
+        }
+        client.bytes += n;
+        if (client.headerDone) {
+            countParts(client, buffer, n);
+            continue;
+        }
+        client.header.append(buffer, n);
+        size_t end = client.header.find("\r\n\r\n");
+        if (end == std::string::npos) continue;
+        if (client.header.compare(0, 12, "HTTP/1.1 200") != 0) {
+            fprintf(stderr, "unexpected response: %s\n", client.header.substr(0, client.header.find("\r\n")).c_str());
+            client.failed = true;
+            return;
+        }
+        client.headerDone = true;
+        std::string body = client.header.substr(end + 4);
+        client.header.clear();
+        countParts(client, body.data(), body.size());
+    }
+}
+
+struct RoundResult {
+    int clients = 0;
+    int failed = 0;
+    double seconds = 0;
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+    double minFps = 0;
+    double maxFps = 0;
+};
+
+RoundResult runRound(const addrinfo* addr, const std::string& request, int count, int slowCount, double seconds) {
+    RoundResult result;
+    result.clients = count;
+    std::vector<Client> clients(count + slowCount);
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    for (size_t i = 0; i < clients.size(); ++i) {
+        Client& client = clients[i];
+        client.slow = static_cast<int>(i) >= count;
+        if (client.slow) {
+            // 慢客户端：接收窗口尽量小且从不读取，服务端的发送缓冲区很快被填满
+            client.fd = socket(addr->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            int rcvbuf = 4096;
+            setsockopt(client.fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+            if (connect(client.fd, addr->ai_addr, addr->ai_addrlen) < 0) {
+                close(client.fd);
+                client.fd = -1;
+            }
+        } else {
+            client.fd = connectTo(addr);
+        }
+        if (client.fd < 0 || send(client.fd, request.data(), request.size(), MSG_NOSIGNAL)
+                                 != static_cast<ssize_t>(request.size())) {
+            client.failed = true;
+            continue;
+        }
+        if (client.slow) continue;
+        fcntl(client.fd, F_SETFL, fcntl(client.fd, F_GETFL) | O_NONBLOCK);
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.u32 = static_cast<uint32_t>(i);
+        epoll_ctl(epfd, EPOLL_CTL_ADD, client.fd, &ev);
+    }
+
+    std::vector<char> buffer(256 * 1024);
+    std::vector<epoll_event> events(256);
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(static_cast<int64_t>(seconds * 1000));
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) break;
+        int timeout = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()) + 1;
+        int n = epoll_wait(epfd, events.data(), static_cast<int>(events.size()), timeout);
+        for (int i = 0; i < n; ++i) {
+            Client& client = clients[events[i].data.u32];
+            handleRead(client, buffer.data(), buffer.size());
+            if (client.failed) epoll_ctl(epfd, EPOLL_CTL_DEL, client.fd, nullptr);
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bool first = true;
+    for (Client& client : clients) {
+        if (!client.slow) {
+            if (client.failed) result.failed++;
+            double fps = client.frames / result.seconds;
+            result.frames += client.frames;
+            result.bytes += client.bytes;
+            result.minFps = first ? fps : std::min(result.minFps, fps);
+            result.maxFps = first ? fps : std::max(result.maxFps, fps);
+            first = false;
+        }
+        if (client.fd >= 0) close(client.fd);
+    }
+    close(epfd);
+    return result;
+}
+
+std::vector<int> parseCounts(const std::string& list) {
+    std::vector<int> counts;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        int count = atoi(item.c_str());
+        if (count > 0) counts.push_back(count);
+    }
+    return counts;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <host> [port=9090] [camera=1] [seconds=10] [clients=1,2,4,8,16,32,64] [slow=0] [query]\n",
+                argv[0]);
+        return 2;
+    }
+    std::string host = argv[1];
+    std::string port = argc > 2 ? argv[2] : "9090";
+    std::string camera = argc > 3 ? argv[3] : "1";
+    double seconds = argc > 4 ? atof(argv[4]) : 10;
+    std::vector<int> counts = parseCounts(argc > 5 ? argv[5] : "1,2,4,8,16,32,64");
+    int slowCount = argc > 6 ? atoi(argv[6]) : 0;
+    std::string query = argc > 7 ? argv[7] : "";
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addr = nullptr;
+    int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &addr);
+    if (rc != 0) {
+        fprintf(stderr, "resolve %s:%s failed: %s\n", host.c_str(), port.c_str(), gai_strerror(rc));
+        return 1;
+    }
+    std::string path = "/api/camera/" + camera + "/live.mjpg" + (query.empty() ? "" : "?" + query);
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + host + ":" + port + "\r\nAccept: */*\r\n\r\n";
+
+    printf("%s:%s%s, %.0fs per round, %d slow clients\n", host.c_str(), port.c_str(), path.c_str(), seconds, slowCount);
+    printf("%8s %8s %10s %10s %10s %10s %10s\n", "clients", "failed", "total fps", "min fps", "avg fps", "max fps", "MB/s");
+    int status = 0;
+    for (int count : counts) {
+        RoundResult r = runRound(addr, request, count, slowCount, seconds);
+        printf("%8d %8d %10.1f %10.1f %10.1f %10.1f %10.2f\n", r.clients, r.failed, r.frames / r.seconds, r.minFps,
+               r.frames / r.seconds / r.clients, r.maxFps, r.bytes / r.seconds / 1e6);
+        fflush(stdout);
+        if (r.failed > 0) status = 1;
+    }
+    freeaddrinfo(addr);
+    return status;
+}
@@ -0,0 +1,196 @@
+/**
+ * MJPEG/Matroska 时间戳漂移测试（以 USE_CRSDK_SIMULATOR 编译）
+ * 从模拟相机按真实节奏取带抖动的预览帧，交给录像用的 FFmpegStreamer（startRecord + pushFrame）转码为 H.264/MKV，
+ * 再用 ffprobe 读出它写出的文件中每帧 PTS，与该帧采集时刻（相对第一帧）比较：帧数必须一致，每帧误差不超过上限。
+ * image2pipe -framerate 按固定帧率重打时间戳，相机帧率稍有偏差就越跑越偏，这个测试防止回到那种情况。
+ *
+ * 用法：mkv_pts_drift_test [分钟数=1] [误差上限ms=40]
+ * 抖动由 CRSIM_JITTER_US 控制，未设置时取 20000；PATH 中没有 ffmpeg/ffprobe 时返回 77（ctest 记为跳过）
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+#include <condition_variable>
+#include <unistd.h>
+#include "CRSDK/CameraRemote_SDK.h"
+#include "CRSDK/IDeviceCallback.h"
+#include "FramePool.h"
+#include "FFmpegStreamer.h"
+
+namespace SDK = SCRSDK;
+
+namespace {
+
+const int SkipCode = 77;
+
+class ConnectCallback : public SDK::IDeviceCallback {
+public:
+    void OnConnected(SDK::DeviceConnectionVersioin version) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        connected = true;
+        cv.notify_all();
+    }
+
+    bool wait(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, timeout, [this]() { return connected; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool connected = false;
+};
+
+bool hasTool(const char* name) {
+    std::string cmd = std::string(name) + " -version >/dev/null 2>&1";
+    return system(cmd.c_str()) == 0;
+}
+
+// ffprobe 读出视频流每个包的 PTS（毫秒），按显示顺序排列
+std::vector<double> probePts(const std::string& path) {
+    std::vector<double> pts;
+    std::string cmd = "ffprobe -v error -select_streams v:0 -show_entries packet=pts_time -of csv=p=0 '" + path + "'";
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (!pipe) return pts;
+    char line[128];
+    while (fgets(line, sizeof(line), pipe)) {
+        char* end = nullptr;
+        double seconds = strtod(line, &end);
+        if (end != line) pts.push_back(seconds * 1000);
+    }
+    pclose(pipe);
+    std::sort(pts.begin(), pts.end());
+    return pts;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double minutes = argc > 1 ? atof(argv[1]) : 1;
+    double toleranceMs = argc > 2 ? atof(argv[2]) : 40;
+    if (!hasTool("ffmpeg") || !hasTool("ffprobe")) {
+        printf("SKIP: ffmpeg/ffprobe not found in PATH\n");
+        return SkipCode;
+    }
+    setenv("CRSIM_JITTER_US", "20000", 0);
+
+    if (!SDK::Init()) {
+        fprintf(stderr, "FAIL: CRSDK init\n");
+        return 1;
+    }
+    SDK::ICrEnumCameraObjectInfo* cameras = nullptr;
+    if (CR_FAILED(SDK::EnumCameraObjects(&cameras)) || !cameras || cameras->GetCount() == 0) {
+        fprintf(stderr, "FAIL: no simulated camera\n");
+        return 1;
+    }
+    ConnectCallback callback;
+    SDK::CrDeviceHandle handle = 0;
+    auto info = const_cast<SDK::ICrCameraObjectInfo*>(cameras->GetCameraObjectInfo(0));
+    if (CR_FAILED(SDK::Connect(info, &callback, &handle)) || !callback.wait(std::chrono::seconds(5))) {
+        fprintf(stderr, "FAIL: connect\n");
+        return 1;
+    }
+    cameras->Release();
+    SDK::SetDeviceSetting(handle, SDK::Setting_Key_EnableLiveView, 1);
+    SDK::CrImageInfo imageInfo;
+    if (CR_FAILED(SDK::GetLiveViewImageInfo(handle, &imageInfo)) || imageInfo.GetBufferSize() == 0) {
+        fprintf(stderr, "FAIL: live view info\n");
+        return 1;
+    }
+
+    char path[] = "/tmp/mkv_pts_drift_XXXXXX.mkv";
+    int fd = mkstemps(path, 4);
+    if (fd < 0) {
+        perror("mkstemps");
+        return 1;
+    }
+    close(fd);
+    // 队列足够深，写线程不会因为排队丢帧，丢帧会让采集时刻和输出对不上
+    FFmpegStreamer recorder("record", 256);
+    if (!recorder.startRecord(path, 30, FFmpegStreamer::VideoCodec::H264)) {
+        fprintf(stderr, "FAIL: startRecord\n");
+        unlink(path);
+        return 1;
+    }
+
+    FramePool pool;
+    std::vector<int64_t> capturedMs;
+    std::chrono::steady_clock::time_point first;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(static_cast<int64_t>(minutes * 60000));
+    uint32_t lastFrameNo = 0;
+    while (std::chrono::steady_clock::now() < deadline) {
+        FramePtr frame = pool.acquire(imageInfo.GetBufferSize());
+        SDK::CrImageDataBlock block;
+        block.SetSize(frame->capacity);
+        block.SetData(frame->raw());
+        SDK::CrError err = SDK::GetLiveViewImage(handle, &block);
+        frame->timestamp = std::chrono::steady_clock::now();
+        if (CR_FAILED(err) || block.GetImageSize() == 0 || block.GetFrameNo() == lastFrameNo) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+        lastFrameNo = block.GetFrameNo();
+        frame->offset = static_cast<uint32_t>(block.GetImageData() - frame->raw());
+        frame->size = block.GetImageSize();
+        frame->frameNo = lastFrameNo;
+
+        recorder.pushFrame(frame);
+        if (capturedMs.empty()) first = frame->timestamp;
+        capturedMs.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(frame->timestamp - first).count());
+    }
+    SDK::Disconnect(handle);
+    SDK::ReleaseDevice(handle);
+    SDK::Release();
+
+    // stop() 不等待排队的帧，先等写线程清空队列
+    auto drainDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (recorder.stats().queued > 0 && std::chrono::steady_clock::now() < drainDeadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    recorder.stop();
+    FFmpegStreamer::Stats stats = recorder.stats();
+    if (stats.restarts > 0 || stats.dropped > 0 || stats.aborted > 0 || stats.written != capturedMs.size()) {
+        fprintf(stderr, "FAIL: pushed %zu frames, written %llu, dropped %llu, aborted %llu, restarts %u (%s)\n",
+                capturedMs.size(), static_cast<unsigned long long>(stats.written),
+                static_cast<unsigned long long>(stats.dropped), static_cast<unsigned long long>(stats.aborted),
+                stats.restarts, stats.lastError.c_str());
+        unlink(path);
+        return 1;
+    }
+
+    std::vector<double> outputMs = probePts(path);
+    unlink(path);
+    if (outputMs.size() != capturedMs.size()) {
+        fprintf(stderr, "FAIL: wrote %zu frames, ffmpeg produced %zu\n", capturedMs.size(), outputMs.size());
+        return 1;
+    }
+    // 输出从第一帧的 PTS 起算，对比相对时间
+    double maxError = 0;
+    size_t worst = 0;
+    for (size_t i = 0; i < outputMs.size(); ++i) {
+        double error = std::fabs((outputMs[i] - outputMs[0]) - capturedMs[i]);
+        if (error > maxError) {
+            maxError = error;
+            worst = i;
+        }
+    }
+    double seconds = capturedMs.empty() ? 0 : capturedMs.back() / 1000.0;
+    printf("%zu frames over %.1fs (%.2f fps), max pts error %.1fms at frame %zu, end drift %.1fms\n",
+           capturedMs.size(), seconds, seconds > 0 ? (capturedMs.size() - 1) / seconds : 0, maxError, worst,
+           capturedMs.empty() ? 0 : (outputMs.back() - outputMs[0]) - capturedMs.back());
+    if (capturedMs.size() < 2 || maxError > toleranceMs) {
+        fprintf(stderr, "FAIL: pts error %.1fms exceeds %.1fms\n", maxError, toleranceMs);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
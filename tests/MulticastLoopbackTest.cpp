@@ -0,0 +1,313 @@
+/**
+ * 组播预览本机回环测试（以 USE_CRSDK_SIMULATOR 编译）
+ * RtpMulticastSender 发送模拟相机的预览帧，同一进程内的接收端加入组播组，靠 IP_MULTICAST_LOOP 收到本机发出的包，
+ * 逐包检查 RTP 头和 RTP/JPEG 分片偏移，统计收到的包数、字节数和完整帧数，与发送端 stats() 对比：
+ * 发送端没有丢包时两边的包数、完整帧数必须相等，序号不能有空洞。
+ * 本机没有组播路由（加入组播组失败）时跳过。
+ *
+ * 用法：multicast_loopback_test [秒数=5] [组播地址=239.255.77.1] [端口=15004] [发送网卡地址=按路由表]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include "CRSDK/CameraRemote_SDK.h"
+#include "CRSDK/IDeviceCallback.h"
+#include "FramePool.h"
+#include "RtpMulticastSender.h"
+
+namespace SDK = SCRSDK;
+
+namespace {
+
+const int SkipCode = 77;
+
+class ConnectCallback : public SDK::IDeviceCallback {
+public:
+    void OnConnected(SDK::DeviceConnectionVersioin version) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        connected = true;
+        cv.notify_all();
+    }
+
+    bool wait(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, timeout, [this]() { return connected; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool connected = false;
+};
+
+uint32_t getBE(const uint8_t* p, int bytes) {
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; ++i) value = (value << 8) | p[i];
+    return value;
+}
+
+/**
+ * 组播接收端
+ * 按序号和分片偏移判断帧是否完整：一帧从偏移0开始、偏移连续、以 marker 包结束才算完整帧
+ */
+class Receiver {
+public:
+    struct Stats {
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        uint64_t frames = 0;        // 完整帧
+        uint64_t partial = 0;       // 分片不连续的帧
+        uint64_t seqGaps = 0;       // 序号空洞（丢失的包数）
+        uint64_t malformed = 0;     // RTP 头不合法或 SSRC 不一致
+    };
+
+    // 返回 false 表示本机无法加入组播组
+    bool open(const std::string& group, int port, const std::string& interface) {
+        fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return false;
+        int on = 1;
+        int rcvbuf = 8 * 1024 * 1024;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, group.c_str(), &addr.sin_addr);
+        if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            fprintf(stderr, "receiver bind failed: %s\n", strerror(errno));
+            return false;
+        }
+        ip_mreq mreq{};
+        inet_pton(AF_INET, group.c_str(), &mreq.imr_multiaddr);
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (!interface.empty()) inet_pton(AF_INET, interface.c_str(), &mreq.imr_interface);
+        if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            fprintf(stderr, "IP_ADD_MEMBERSHIP failed: %s\n", strerror(errno));
+            return false;
+        }
+        thread = std::thread(&Receiver::run, this);
+        return true;
+    }
+
+    // 等到 quietMs 内没有新包后停止
+    Stats finish(int quietMs) {
+        uint64_t last = ~0ull;
+        while (last != packetCount.load()) {
+            last = packetCount.load();
+            std::this_thread::sleep_for(std::chrono::milliseconds(quietMs));
+        }
+        running = false;
+        if (thread.joinable()) thread.join();
+        return stats;
+    }
+
+    ~Receiver() {
+        running = false;
+        if (thread.joinable()) thread.join();
+        if (fd >= 0) close(fd);
+    }
+
+private:
+    void run() {
+        uint8_t buffer[65536];
+        pollfd pfd{fd, POLLIN, 0};
+        while (running) {
+            if (poll(&pfd, 1, 50) <= 0) continue;
+            ssize_t n;
+            while ((n = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+                handle(buffer, static_cast<size_t>(n));
+            }
+        }
+    }
+
+    void handle(const uint8_t* p, size_t size) {
+        stats.packets++;
+        stats.bytes += size;
+        packetCount++;
+        if (size < RtpJpegFrame::RtpHeaderSize + 8 || (p[0] & 0xC0) != 0x80
+            || (p[1] & 0x7F) != RtpJpegFrame::PayloadType) {
+            stats.malformed++;
+            return;
+        }
+        uint16_t seq = static_cast<uint16_t>(getBE(p + 2, 2));
+        uint32_t timestamp = getBE(p + 4, 4);
+        uint32_t packetSsrc = getBE(p + 8, 4);
+        if (!started) {
+            started = true;
+            ssrc = packetSsrc;
+        } else {
+            if (packetSsrc != ssrc) {
+                stats.malformed++;
+                return;
+            }
+            uint16_t gap = static_cast<uint16_t>(seq - expectedSeq);
+            if (gap != 0) {
+                stats.seqGaps += gap;
+                inFrame = false;
+            }
+        }
+        expectedSeq = static_cast<uint16_t>(seq + 1);
+
+        const uint8_t* jpeg = p + RtpJpegFrame::RtpHeaderSize;
+        uint32_t fragmentOffset = getBE(jpeg + 1, 3);
+        size_t headerSize = 8 + ((jpeg[4] & 0x40) ? 4 : 0);
+        if (fragmentOffset == 0) {
+            if (inFrame) stats.partial++;
+            if (size < RtpJpegFrame::RtpHeaderSize + headerSize + 4) {
+                stats.malformed++;
+                inFrame = false;
+                return;
+            }
+            headerSize += 4 + getBE(jpeg + headerSize + 2, 2);
+            inFrame = true;
+            frameTimestamp = timestamp;
+            frameBytes = 0;
+        } else if (!inFrame || fragmentOffset != frameBytes || timestamp != frameTimestamp) {
+            if (inFrame) stats.partial++;
+            inFrame = false;
+            return;
+        }
+        if (RtpJpegFrame::RtpHeaderSize + headerSize > size) {
+            stats.malformed++;
+            inFrame = false;
+            return;
+        }
+        frameBytes += static_cast<uint32_t>(size - RtpJpegFrame::RtpHeaderSize - headerSize);
+        if (p[1] & 0x80) {
+            stats.frames++;
+            inFrame = false;
+        }
+    }
+
+    int fd = -1;
+    std::thread thread;
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> packetCount{0};
+    Stats stats;                    // 只在接收线程写，finish() join 之后读
+    bool started = false;
+    uint32_t ssrc = 0;
+    uint16_t expectedSeq = 0;
+    bool inFrame = false;
+    uint32_t frameTimestamp = 0;
+    uint32_t frameBytes = 0;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 5;
+    RtpMulticastSender::Config config;
+    config.group = argc > 2 ? argv[2] : "239.255.77.1";
+    config.port = argc > 3 ? atoi(argv[3]) : 15004;
+    config.interface = argc > 4 ? argv[4] : "";
+    config.loopback = true;
+
+    Receiver receiver;
+    if (!receiver.open(config.group, config.port, config.interface)) {
+        printf("SKIP: cannot join %s on this host\n", config.group.c_str());
+        return SkipCode;
+    }
+    RtpMulticastSender sender;
+    if (!sender.start(config)) {
+        printf("SKIP: cannot send to %s:%d on this host\n", config.group.c_str(), config.port);
+        return SkipCode;
+    }
+
+    if (!SDK::Init()) {
+        fprintf(stderr, "FAIL: CRSDK init\n");
+        return 1;
+    }
+    SDK::ICrEnumCameraObjectInfo* cameras = nullptr;
+    if (CR_FAILED(SDK::EnumCameraObjects(&cameras)) || !cameras || cameras->GetCount() == 0) {
+        fprintf(stderr, "FAIL: no simulated camera\n");
+        return 1;
+    }
+    ConnectCallback callback;
+    SDK::CrDeviceHandle handle = 0;
+    auto info = const_cast<SDK::ICrCameraObjectInfo*>(cameras->GetCameraObjectInfo(0));
+    if (CR_FAILED(SDK::Connect(info, &callback, &handle)) || !callback.wait(std::chrono::seconds(5))) {
+        fprintf(stderr, "FAIL: connect\n");
+        return 1;
+    }
+    cameras->Release();
+    SDK::SetDeviceSetting(handle, SDK::Setting_Key_EnableLiveView, 1);
+    SDK::CrImageInfo imageInfo;
+    if (CR_FAILED(SDK::GetLiveViewImageInfo(handle, &imageInfo)) || imageInfo.GetBufferSize() == 0) {
+        fprintf(stderr, "FAIL: live view info\n");
+        return 1;
+    }
+
+    FramePool pool;
+    uint64_t pushed = 0;
+    uint32_t lastFrameNo = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(static_cast<int64_t>(seconds * 1000));
+    while (std::chrono::steady_clock::now() < deadline) {
+        FramePtr frame = pool.acquire(imageInfo.GetBufferSize());
+        SDK::CrImageDataBlock block;
+        block.SetSize(frame->capacity);
+        block.SetData(frame->raw());
+        SDK::CrError err = SDK::GetLiveViewImage(handle, &block);
+        frame->timestamp = std::chrono::steady_clock::now();
+        if (CR_FAILED(err) || block.GetImageSize() == 0 || block.GetFrameNo() == lastFrameNo) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+        lastFrameNo = block.GetFrameNo();
+        frame->offset = static_cast<uint32_t>(block.GetImageData() - frame->raw());
+        frame->size = block.GetImageSize();
+        frame->frameNo = lastFrameNo;
+        sender.pushFrame(frame);
+        pushed++;
+    }
+    SDK::Disconnect(handle);
+    SDK::ReleaseDevice(handle);
+    SDK::Release();
+
+    RtpMulticastSender::Stats sent = sender.stats();
+    sender.stop();
+    Receiver::Stats received = receiver.finish(300);
+
+    printf("pushed %llu frames; sent %llu frames, %llu packets, %llu bytes, dropped %llu packets\n",
+           static_cast<unsigned long long>(pushed), static_cast<unsigned long long>(sent.frames),
+           static_cast<unsigned long long>(sent.packets), static_cast<unsigned long long>(sent.bytes),
+           static_cast<unsigned long long>(sent.dropped));
+    printf("received %llu frames, %llu packets, %llu bytes; partial %llu, seq gaps %llu, malformed %llu\n",
+           static_cast<unsigned long long>(received.frames), static_cast<unsigned long long>(received.packets),
+           static_cast<unsigned long long>(received.bytes), static_cast<unsigned long long>(received.partial),
+           static_cast<unsigned long long>(received.seqGaps), static_cast<unsigned long long>(received.malformed));
+
+    if (sent.frames == 0 || sent.unsupported > 0) {
+        fprintf(stderr, "FAIL: sender produced no RTP/JPEG frames\n");
+        return 1;
+    }
+    if (received.packets == 0) {
+        fprintf(stderr, "FAIL: nothing looped back, IP_MULTICAST_LOOP not effective\n");
+        return 1;
+    }
+    if (received.malformed > 0 || received.partial > 0) {
+        fprintf(stderr, "FAIL: malformed or partial frames received\n");
+        return 1;
+    }
+    // 发送端丢的包只能是整帧尾部，收到的包数仍应与实际发出的一致
+    if (received.packets != sent.packets || received.bytes != sent.bytes || received.frames != sent.frames
+        || (sent.dropped == 0 && received.seqGaps > 0)) {
+        fprintf(stderr, "FAIL: received counts do not match sent counts\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,256 @@
+/**
+ * RTP/JPEG 打包往返测试（以 USE_CRSDK_SIMULATOR 编译）
+ * 从模拟相机取预览JPEG，用 RtpJpegPacketizer 打包，再按 RFC 2435 接收端的做法逐包解析、拼回：
+ *   RTP 头（版本、负载类型、序号连续、同帧同时间戳、最后一包带 marker）、
+ *   JPEG 主头（分片偏移连续、type 与采样一致、宽高）、重启标记头（与 DRI 一致）、带内量化表（与 DQT 一致），
+ *   拼回的熵编码数据接上原JPEG的头部和 EOI 后必须与原图逐字节相同。
+ * 色度采样和重启间隔由 CRSIM_JPEG_SAMPLING / CRSIM_JPEG_RST 控制，参数给出期望值，防止模拟器没按配置出图时空跑通过。
+ *
+ * 用法：rtp_jpeg_roundtrip_test [帧数=30] [最大包长=1400] [期望采样 420|422=420] [期望DRI=0]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <sys/uio.h>
+#include "CRSDK/CameraRemote_SDK.h"
+#include "CRSDK/IDeviceCallback.h"
+#include "FramePool.h"
+#include "RtpJpeg.h"
+
+namespace SDK = SCRSDK;
+
+namespace {
+
+class ConnectCallback : public SDK::IDeviceCallback {
+public:
+    void OnConnected(SDK::DeviceConnectionVersioin version) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        connected = true;
+        cv.notify_all();
+    }
+
+    bool wait(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, timeout, [this]() { return connected; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool connected = false;
+};
+
+uint32_t getBE(const uint8_t* p, int bytes) {
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; ++i) value = (value << 8) | p[i];
+    return value;
+}
+
+// 测试自己解析原JPEG，不复用打包器的解析
+struct SourceJpeg {
+    int width = 0;
+    int height = 0;
+    int sampling = 0;               // 亮度采样因子 0x21 / 0x22
+    uint16_t restartInterval = 0;
+    std::vector<uint8_t> qtables;   // 亮度表 + 色度表
+    size_t scanOffset = 0;
+};
+
+bool parseSource(const uint8_t* data, size_t size, SourceJpeg& out) {
+    std::vector<uint8_t> tables[4];
+    int componentTable[3] = {0, 0, 0};
+    size_t pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF) return false;
+        uint8_t marker = data[pos + 1];
+        size_t length = getBE(data + pos + 2, 2);
+        const uint8_t* seg = data + pos + 4;
+        if (marker == 0xDB) {
+            for (size_t i = 0; i < length - 2;) {
+                size_t tableSize = (seg[i] >> 4) ? 128 : 64;
+                tables[seg[i] & 0x03].assign(seg + i + 1, seg + i + 1 + tableSize);
+                i += 1 + tableSize;
+            }
+        } else if (marker == 0xDD) {
+            out.restartInterval = static_cast<uint16_t>(getBE(seg, 2));
+        } else if (marker == 0xC0) {
+            out.height = getBE(seg + 1, 2);
+            out.width = getBE(seg + 3, 2);
+            out.sampling = seg[7];
+            componentTable[0] = seg[8];
+            componentTable[1] = seg[11];
+            componentTable[2] = seg[14];
+        } else if (marker == 0xDA) {
+            out.qtables = tables[componentTable[0] & 0x03];
+            out.qtables.insert(out.qtables.end(), tables[componentTable[1] & 0x03].begin(),
+                               tables[componentTable[1] & 0x03].end());
+            out.scanOffset = pos + 2 + length;
+            return true;
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
+
+// 按接收端的方式检查一帧的所有包并拼回熵编码数据，出错时返回描述
+std::string reassemble(const RtpJpegFrame& rtp, const SourceJpeg& source, size_t maxPacketSize,
+                       uint16_t& expectedSeq, std::vector<uint8_t>& scan) {
+    std::vector<uint8_t> packet;
+    for (size_t i = 0; i < rtp.packetCount(); ++i) {
+        struct iovec iov[2];
+        int count = rtp.fill(i, iov);
+        packet.clear();
+        for (int k = 0; k < count; ++k) {
+            const uint8_t* base = static_cast<const uint8_t*>(iov[k].iov_base);
+            packet.insert(packet.end(), base, base + iov[k].iov_len);
+        }
+        if (packet.size() > maxPacketSize) return "packet exceeds max size";
+        const uint8_t* p = packet.data();
+        bool last = i + 1 == rtp.packetCount();
+        if (p[0] != 0x80) return "bad RTP version/flags";
+        if ((p[1] & 0x7F) != RtpJpegFrame::PayloadType) return "bad payload type";
+        if (((p[1] & 0x80) != 0) != last) return "marker bit not on the last packet only";
+        if (getBE(p + 2, 2) != expectedSeq) return "sequence gap";
+        expectedSeq++;
+        if (getBE(p + 4, 4) != rtp.timestamp()) return "timestamp differs within a frame";
+
+        const uint8_t* jpeg = p + RtpJpegFrame::RtpHeaderSize;
+        uint32_t fragmentOffset = getBE(jpeg + 1, 3);
+        uint8_t type = jpeg[4];
+        if (fragmentOffset != scan.size()) return "fragment offset not contiguous";
+        if ((type & 0x3F) != (source.sampling == 0x22 ? 1 : 0)) return "type does not match sampling";
+        if (((type & 0x40) != 0) != (source.restartInterval != 0)) return "restart flag does not match DRI";
+        if (jpeg[5] != 255) return "Q is not 255";
+        if (jpeg[6] * 8 != source.width || jpeg[7] * 8 != source.height) return "size mismatch";
+        size_t headerSize = 8;
+        if (type & 0x40) {
+            if (getBE(jpeg + 8, 2) != source.restartInterval) return "restart interval mismatch";
+            headerSize += 4;
+        }
+        if (fragmentOffset == 0) {
+            const uint8_t* q = jpeg + headerSize;
+            size_t length = getBE(q + 2, 2);
+            if (length != source.qtables.size()
+                || memcmp(q + 4, source.qtables.data(), length) != 0) return "quantization tables differ";
+            headerSize += 4 + length;
+        }
+        size_t payloadOffset = RtpJpegFrame::RtpHeaderSize + headerSize;
+        if (payloadOffset > packet.size()) return "truncated packet";
+        scan.insert(scan.end(), packet.begin() + payloadOffset, packet.end());
+    }
+    return std::string();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int frameCount = argc > 1 ? atoi(argv[1]) : 30;
+    size_t maxPacketSize = argc > 2 ? static_cast<size_t>(atoi(argv[2])) : RtpJpegPacketizer::DefaultMaxPacketSize;
+    int expectSampling = argc > 3 ? atoi(argv[3]) : 420;
+    int expectRestart = argc > 4 ? atoi(argv[4]) : 0;
+
+    if (!SDK::Init()) {
+        fprintf(stderr, "FAIL: CRSDK init\n");
+        return 1;
+    }
+    SDK::ICrEnumCameraObjectInfo* cameras = nullptr;
+    if (CR_FAILED(SDK::EnumCameraObjects(&cameras)) || !cameras || cameras->GetCount() == 0) {
+        fprintf(stderr, "FAIL: no simulated camera\n");
+        return 1;
+    }
+    ConnectCallback callback;
+    SDK::CrDeviceHandle handle = 0;
+    auto info = const_cast<SDK::ICrCameraObjectInfo*>(cameras->GetCameraObjectInfo(0));
+    if (CR_FAILED(SDK::Connect(info, &callback, &handle)) || !callback.wait(std::chrono::seconds(5))) {
+        fprintf(stderr, "FAIL: connect\n");
+        return 1;
+    }
+    cameras->Release();
+    SDK::SetDeviceSetting(handle, SDK::Setting_Key_EnableLiveView, 1);
+    SDK::CrImageInfo imageInfo;
+    if (CR_FAILED(SDK::GetLiveViewImageInfo(handle, &imageInfo)) || imageInfo.GetBufferSize() == 0) {
+        fprintf(stderr, "FAIL: live view info\n");
+        return 1;
+    }
+
+    FramePool pool;
+    RtpJpegPacketizer packetizer(maxPacketSize);
+    uint16_t expectedSeq = packetizer.getNextSeq();
+    uint32_t lastFrameNo = 0;
+    size_t packets = 0;
+    size_t bytes = 0;
+    int checked = 0;
+    std::string error;
+    while (checked < frameCount && error.empty()) {
+        FramePtr frame = pool.acquire(imageInfo.GetBufferSize());
+        SDK::CrImageDataBlock block;
+        block.SetSize(frame->capacity);
+        block.SetData(frame->raw());
+        SDK::CrError err = SDK::GetLiveViewImage(handle, &block);
+        if (CR_FAILED(err) || block.GetImageSize() == 0 || block.GetFrameNo() == lastFrameNo) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+        lastFrameNo = block.GetFrameNo();
+        frame->offset = static_cast<uint32_t>(block.GetImageData() - frame->raw());
+        frame->size = block.GetImageSize();
+        frame->frameNo = lastFrameNo;
+        frame->timestamp = std::chrono::steady_clock::now();
+
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(frame->data());
+        SourceJpeg source;
+        if (!parseSource(data, frame->size, source)) {
+            error = "simulator JPEG did not parse";
+            break;
+        }
+        int sampling = source.sampling == 0x22 ? 420 : (source.sampling == 0x21 ? 422 : 0);
+        if (sampling != expectSampling || source.restartInterval != expectRestart) {
+            error = "simulator produced sampling " + std::to_string(sampling) + " DRI "
+                + std::to_string(source.restartInterval) + ", expected " + std::to_string(expectSampling)
+                + " DRI " + std::to_string(expectRestart);
+            break;
+        }
+
+        RtpJpegFramePtr rtp = packetizer.packetize(frame);
+        if (!rtp) {
+            error = "packetizer rejected frame";
+            break;
+        }
+        std::vector<uint8_t> scan;
+        error = reassemble(*rtp, source, maxPacketSize, expectedSeq, scan);
+        if (!error.empty()) break;
+
+        // 原JPEG头 + 拼回的熵编码数据 + EOI 与原图逐字节一致
+        std::vector<uint8_t> rebuilt(data, data + source.scanOffset);
+        rebuilt.insert(rebuilt.end(), scan.begin(), scan.end());
+        rebuilt.push_back(0xFF);
+        rebuilt.push_back(0xD9);
+        if (rebuilt.size() != frame->size || memcmp(rebuilt.data(), data, frame->size) != 0) {
+            error = "reassembled JPEG differs from the source";
+            break;
+        }
+        packets += rtp->packetCount();
+        bytes += rtp->totalSize();
+        checked++;
+    }
+    SDK::Disconnect(handle);
+    SDK::ReleaseDevice(handle);
+    SDK::Release();
+
+    if (!error.empty()) {
+        fprintf(stderr, "FAIL: frame %d (#%u): %s\n", checked, lastFrameNo, error.c_str());
+        return 1;
+    }
+    printf("%d frames, %zu packets, %zu bytes, sampling %d, DRI %d, max packet %zu\n", checked, packets, bytes,
+           expectSampling, expectRestart, maxPacketSize);
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * 共享内存预览环吞吐基准
+ * 写线程用 ShmFrameWriter 连续写入合成的JPEG大小的帧，读取端用 ShmFrameReader::next 按顺序读取，
+ * 逐字节校验后再用 valid() 确认期间没有被覆盖，输出两端的帧率、带宽、跳帧数和被覆盖（torn）的帧数。
+ * 每帧内容全为 frameNo % 16，valid() 为 true 而内容不一致说明 seqlock 有问题，返回1。
+ *
+ * 用法：shm_throughput_bench [秒数=5] [帧字节数=200000] [槽位数=8] [读取端每帧额外耗时us=0] [写入帧率=0 不限]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <unistd.h>
+#include "ShmFrameWriter.h"
+#include "ShmFrameReader.h"
+#include "FramePool.h"
+
+namespace {
+
+const uint32_t Patterns = 16;
+
+// 读取端模拟推理耗时，忙等以免 sleep 的精度影响结果
+void spin(int us) {
+    if (us <= 0) return;
+    auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+    while (std::chrono::steady_clock::now() < until) {}
+}
+
+bool intact(const ShmFrameReader::Frame& frame) {
+    uint8_t expected = static_cast<uint8_t>(frame.frameNo % Patterns);
+    for (size_t i = 0; i < frame.size; ++i) {
+        if (frame.data[i] != expected) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 5;
+    uint32_t frameBytes = argc > 2 ? static_cast<uint32_t>(atol(argv[2])) : 200000;
+    uint32_t slots = argc > 3 ? static_cast<uint32_t>(atol(argv[3])) : 8;
+    int workUs = argc > 4 ? atoi(argv[4]) : 0;
+    int fps = argc > 5 ? atoi(argv[5]) : 0;
+    if (frameBytes == 0 || slots < 2) {
+        fprintf(stderr, "invalid frame size or slot count\n");
+        return 2;
+    }
+
+    ShmFrameWriter writer;
+    ShmFrameWriter::Config config;
+    config.name = "/sony_live_bench_" + std::to_string(getpid());
+    config.slotCount = slots;
+    config.slotSize = frameBytes;
+    if (!writer.start(config, 0)) return 1;
+
+    // 每种内容一个缓冲区，写入端不在计时循环里填充数据
+    FramePool pool;
+    std::vector<FramePtr> frames;
+    for (uint32_t i = 0; i < Patterns; ++i) {
+        FramePtr frame = pool.acquire(frameBytes);
+        memset(frame->raw(), static_cast<int>(i), frameBytes);
+        frame->size = frameBytes;
+        frames.push_back(frame);
+    }
+
+    ShmFrameReader reader;
+    if (!reader.open(config.name)) {
+        fprintf(stderr, "open %s failed\n", config.name.c_str());
+        return 1;
+    }
+
+    std::atomic<bool> writing{true};
+    std::atomic<uint64_t> written{0};
+    auto start = std::chrono::steady_clock::now();
+    std::thread writerThread([&]() {
+        auto interval = std::chrono::microseconds(fps > 0 ? 1000000 / fps : 0);
+        auto next = std::chrono::steady_clock::now();
+        for (uint64_t frameNo = 0; writing; ++frameNo) {
+            const FramePtr& frame = frames[frameNo % Patterns];
+            frame->frameNo = static_cast<uint32_t>(frameNo);
+            frame->timestamp = std::chrono::steady_clock::now();
+            writer.pushFrame(frame);
+            written++;
+            if (fps > 0) {
+                next += interval;
+                std::this_thread::sleep_until(next);
+            }
+        }
+    });
+
+    uint64_t read = 0;
+    uint64_t bytes = 0;
+    uint64_t torn = 0;
+    uint64_t corrupt = 0;
+    auto deadline = start + std::chrono::milliseconds(static_cast<int64_t>(seconds * 1000));
+    ShmFrameReader::Frame frame;
+    while (std::chrono::steady_clock::now() < deadline && reader.next(frame, 1000)) {
+        bool ok = intact(frame);
+        spin(workUs);
+        if (!reader.valid(frame)) {
+            torn++;
+            continue;
+        }
+        if (!ok) corrupt++;
+        read++;
+        bytes += frame.size;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    writing = false;
+    writerThread.join();
+    uint64_t skipped = reader.skipped();
+    reader.close();
+    writer.stop();
+
+    printf("frame %u bytes, %u slots, reader work %dus, %.1fs\n", frameBytes, slots, workUs, elapsed);
+    printf("writer: %llu frames, %.0f frames/s, %.1f MB/s\n", static_cast<unsigned long long>(written.load()),
+           written / elapsed, written * static_cast<double>(frameBytes) / elapsed / 1e6);
+    printf("reader: %llu frames, %.0f frames/s, %.1f MB/s, skipped %llu, torn %llu, corrupt %llu\n",
+           static_cast<unsigned long long>(read), read / elapsed, bytes / elapsed / 1e6,
+           static_cast<unsigned long long>(skipped), static_cast<unsigned long long>(torn),
+           static_cast<unsigned long long>(corrupt));
+    return corrupt == 0 && read > 0 ? 0 : 1;
+}